@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector> // ✨ 必须引入，用于路径列表
+#include "BrainConfig.h"
 
 class CloudBrain {
 public:
@@ -10,21 +11,27 @@ public:
     ~CloudBrain();
 
     // 核心接口：向 DeepSeek 提问
-    std::string think(const std::string& query);
+    // profile 为空时用默认模型和默认参数 (审计就是这样)
+    std::string think(const std::string& query, const ModelProfile* profile = nullptr);
 
     // 审计接口：加载外部 Prompt 文件进行评估
     std::string evaluateLog(const std::string& logContext);
 
+    // 无状态的编解码，静态以便 synapse_bench 直接测
+    static std::string jsonEscape(const std::string& input);
+    static std::string extractContent(const std::string& jsonResponse);
+
 private:
     // DeepSeek API 配置
-    // 【重要】请在这里填入你的 Key，或者在 cpp 文件里写死
-    const std::string apiKey = "密钥"; 
-    const std::string apiUrl = "https://api.deepseek.com/chat/completions";
-    const std::string modelName = "deepseek-chat"; 
+    // 【重要】默认值在 BrainConfig.cpp，Key 可以用环境变量 SYNAPSE_DEEPSEEK_KEY 传入
+    std::string apiKey;
+    std::string apiUrl;
+    std::string modelName;
+
+    // 真正发请求 (录制 / 回放见 BackendTrace)
+    std::string request(const std::string& query, const ModelProfile& profile);
 
     // 内部工具
-    std::string jsonEscape(const std::string& input);
-    std::string extractContent(const std::string& jsonResponse);
     std::string executeCurl(const std::string& cmd);
 
     // ✨✨✨ 新增：加载 Prompt 模板文件的函数声明 ✨✨✨
@@ -0,0 +1,64 @@
+#ifndef COMMAND_GRAMMAR_H
+#define COMMAND_GRAMMAR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 一条合成的指令及其标签
+// slots 与审计日志里 DeepSeek 给出的 output 同格式，可直接当 few-shot / 微调样本：
+//   CREATE: Names|Quantity|Path (名字逗号分隔，没提填 NULL / 0)
+//   DELETE: 文件名或路径，'|' 分隔
+//   OTHER:  空
+struct SyntheticCommand {
+    std::string text;
+    std::string intent;   // CREATE / DELETE / OTHER
+    std::string slots;
+    const char* lang = "zh";
+};
+
+// 离线的文法驱动指令生成器 (取代 stress_test.py 让云端模型编句子)
+// - 中英文的创建 / 删除 / 闲聊，数量用阿拉伯数字或中文数字 (两、十二、二十...)
+// - FileCreator 认的口语动词 建/搞/弄/整 都覆盖；路径有绝对、~、中文别名，文件名带或不带后缀
+// - 同一个种子生成完全相同的序列；next() 复用 out 里的缓冲区，单线程每秒数百万条
+// 非线程安全：多线程各自持有一个实例 (种子错开即可)
+class CommandGrammar {
+public:
+    enum class Language { Chinese, English, Mixed };
+
+    struct Options {
+        uint64_t seed = 1;
+        Language language = Language::Mixed;
+        double deleteRatio = 0.35;
+        double otherRatio = 0.1;
+    };
+
+    CommandGrammar();
+    explicit CommandGrammar(const Options& options);
+
+    void next(SyntheticCommand& out);
+
+    static bool parseLanguage(std::string_view name, Language& out);
+
+private:
+    Options options;
+    uint64_t state;
+    uint32_t deleteThreshold;
+    uint32_t otherThreshold;
+    std::string scratch[2]; // 删除目标的临时缓冲，避免每条都分配
+
+    uint64_t rand64();
+    uint32_t below(uint32_t n) { return static_cast<uint32_t>((rand64() >> 32) * n >> 32); }
+    bool chance(uint32_t percent) { return below(100) < percent; }
+
+    // 生成 1 个文件名 (可带后缀) 追加到 text，slots 非空时同时写入
+    void appendName(std::string& text, std::string* slots, bool english, bool forceExt);
+
+    void createChinese(SyntheticCommand& out);
+    void createEnglish(SyntheticCommand& out);
+    void deleteChinese(SyntheticCommand& out);
+    void deleteEnglish(SyntheticCommand& out);
+    void other(SyntheticCommand& out, bool english);
+};
+
+#endif
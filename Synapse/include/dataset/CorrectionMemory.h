@@ -0,0 +1,57 @@
+#ifndef CORRECTION_MEMORY_H
+#define CORRECTION_MEMORY_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "JudgmentParser.h"
+
+struct CorrectionHit {
+    std::string output;        // 修正后的槽位，如 "mytest.log|1|/tmp"
+    std::string matchedInput;  // 命中的历史输入
+    int distance = 0;          // 0 = 精确命中
+};
+
+// 纠错记忆：DeepSeek 审计过的 input -> output 直接复用，不再问本地模型
+// - 精确查找：去空白后的输入做哈希
+// - 模糊查找：按字符 (Unicode 码点) 的有界编辑距离，长度分桶 + 字符 bloom 预筛
+// - 模糊命中必须"安全"：修正里的文件名/路径都出现在新输入里，且数字完全一致，
+//   否则 "建个 a.txt" 会被错配成 "建个 b.txt" 的答案
+class CorrectionMemory {
+public:
+    static const int MAX_DISTANCE = 2;
+
+    CorrectionMemory() = default;
+
+    // 只收录槽位格式的执行修正 (hasSlotOutput)，同一输入以最新修正为准
+    void add(const TrainingExample& ex);
+
+    bool lookup(const std::string& task, std::string_view input, CorrectionHit& hit) const;
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string input;
+        std::string output;
+        std::vector<uint32_t> codepoints;
+        uint64_t bloom = 0;
+    };
+
+    struct TaskMemory {
+        std::vector<Entry> entries;
+        std::unordered_map<std::string, uint32_t> exact;   // 归一化输入 -> entry
+        std::vector<std::vector<uint32_t>> byLength;       // 码点长度 -> entries
+    };
+
+    std::unordered_map<std::string, TaskMemory> tasks;
+    mutable std::shared_mutex mtx;
+
+    static std::string normalize(std::string_view input);
+    static bool slotsPresent(const std::string& task, const std::string& output, std::string_view input);
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef DATASET_EXPORTER_H
+#define DATASET_EXPORTER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "JudgmentParser.h"
+
+enum class ExportFormat {
+    Chat,      // OpenAI / Qwen chat 微调格式: {"messages":[...]}
+    Alpaca,    // {"instruction","input","output"}
+    Modelfile  // Ollama Modelfile，MESSAGE 对作为 few-shot
+};
+
+struct ExportOptions {
+    ExportFormat format = ExportFormat::Chat;
+    bool includeRejected = false;               // 是否导出【是否入库】= 否 的样本
+    std::string taskFilter;                     // "CREATE" / "DELETE"，空 = 全部
+    std::string baseModel = "qwen2.5-coder:1.5b"; // Modelfile 的 FROM
+    size_t nearDupRepresentatives = 0;          // >0 时启用 MinHash 近重复剔除，每簇最多保留几个
+};
+
+struct SelectStats {
+    size_t duplicates = 0;      // 完全重复
+    size_t nearDuplicates = 0;  // 近重复被剔除
+    size_t clusters = 0;        // 近重复簇数 (启用时)
+};
+
+class DatasetExporter {
+public:
+    static bool parseFormat(const std::string& name, ExportFormat& out);
+
+    // 过滤 (入库标记、output 非空、任务类型) + 按 (task, type, input, output) 去重
+    // 开启 nearDupRepresentatives 时再做一轮近重复剔除
+    static std::vector<const TrainingExample*> select(const std::vector<TrainingExample>& examples,
+                                                      const ExportOptions& options,
+                                                      SelectStats* stats = nullptr);
+
+    static void write(std::ostream& out, const std::vector<const TrainingExample*>& examples,
+                      const ExportOptions& options);
+
+    // 样本对应的任务指令 (与运行时 prompt 的任务描述保持一致)
+    static std::string instructionFor(const TrainingExample& ex);
+};
+
+#endif
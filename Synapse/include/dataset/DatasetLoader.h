@@ -0,0 +1,35 @@
+#ifndef DATASET_LOADER_H
+#define DATASET_LOADER_H
+
+#include <string>
+#include <vector>
+#include "JudgmentParser.h"
+
+struct DatasetStats {
+    size_t files = 0;
+    size_t bytes = 0;
+    size_t sessions = 0;   // 切出来的会话总数
+    size_t examples = 0;   // 其中带 JSON 训练块的
+    double seconds = 0.0;
+};
+
+// 并行加载 training_data：
+// - 参数可以是目录 (递归收集 .txt/.log) 或单个文件 (多会话拼接的训练仓库)
+// - 文件全部 mmap，按字节区间切块分给工作线程，大仓库也能吃满多核
+// - 返回顺序与文件顺序、会话顺序一致，结果可复现
+class DatasetLoader {
+public:
+    // 被近重复剔除的日志放在 training_data/pruned/ 下，收集时跳过
+    static const char* const PRUNED_DIR;
+    // 额度用完、还没审计的日志放在 training_data/deferred/ 下，没有裁判意见，同样跳过
+    static const char* const DEFERRED_DIR;
+
+    static std::vector<std::string> collectFiles(const std::vector<std::string>& roots);
+
+    // threads == 0 表示用全部核心
+    static std::vector<TrainingExample> load(const std::vector<std::string>& roots,
+                                             unsigned threads = 0,
+                                             DatasetStats* stats = nullptr);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef FEW_SHOT_INDEX_H
+#define FEW_SHOT_INDEX_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "JudgmentParser.h"
+
+struct FewShotExample {
+    std::string input;
+    std::string output;
+};
+
+// 修正样本的 BM25 检索索引，用来给本地模型的 prompt 动态挑 few-shot
+// - 词项：Unicode 单字 + 相邻双字 (中文不分词也能用)，ASCII 统一小写
+// - 按任务 (CREATE / DELETE) 分开建索引，互不干扰
+// - 查询只读共享锁，add() 写锁，可边服务边增量加入新样本
+class FewShotIndex {
+public:
+    FewShotIndex() = default;
+
+    // 只收录槽位格式的执行修正 (hasSlotOutput)，同 input 只留最新一条
+    void add(const TrainingExample& ex);
+
+    // 取与 query 最相似的至多 k 条，总 token 估计不超过 tokenBudget
+    std::vector<FewShotExample> query(const std::string& task, std::string_view text,
+                                      size_t k = 3, size_t tokenBudget = 200) const;
+
+    size_t size() const;
+
+    // 粗略 token 估计：ASCII 约 4 字节一个 token，CJK 约一字一个
+    static size_t estimateTokens(std::string_view text);
+
+private:
+    struct Posting {
+        uint32_t doc;
+        uint16_t tf;
+    };
+
+    struct TaskIndex {
+        std::vector<FewShotExample> docs;
+        std::vector<uint32_t> docLength;                       // 词项数
+        std::unordered_map<uint32_t, std::vector<Posting>> postings;
+        std::unordered_map<std::string, uint32_t> byInput;     // input -> doc，用于覆盖旧修正
+        uint64_t totalLength = 0;
+    };
+
+    std::unordered_map<std::string, TaskIndex> tasks;
+    mutable std::shared_mutex mtx;
+
+    static void tokenize(std::string_view text, std::vector<uint32_t>& terms);
+};
+
+#endif
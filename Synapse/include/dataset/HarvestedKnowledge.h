@@ -0,0 +1,68 @@
+#ifndef HARVESTED_KNOWLEDGE_H
+#define HARVESTED_KNOWLEDGE_H
+
+#include <string>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "JudgmentParser.h"
+#include "NearDuplicateIndex.h"
+#include "FewShotIndex.h"
+#include "CorrectionMemory.h"
+#include "IntentClassifier.h"
+
+// 进程内共享的"已收割知识"
+// 启动时把 training_data 加载一次，喂给各个运行时索引；
+// 之后每条新审计的样本经 ingest() 增量加入，数据飞轮在运行时就能生效
+class HarvestedKnowledge {
+public:
+    static HarvestedKnowledge& instance();
+
+    // 意图分类器模型文件 (与训练数据放在一起)
+    static const char* const INTENT_MODEL_PATH;
+
+    // 新样本入口：
+    // - 能推出路由标签的会话都用来增量训练意图分类器 (模型文件由后台线程定期落盘，不在审计路径上写)
+    // - 可用修正先做近重复判定，未被剔除的再进入检索索引和纠错记忆
+    DedupResult ingest(const TrainingExample& ex);
+
+    // 路由模型判成 OTHER 的会话不会进审计日志，由执行器直接把路由结果当标签喂给意图分类器
+    void learnIntent(const std::string& text, const std::string& label);
+
+    NearDuplicateIndex& nearDuplicates() { return nearDupIndex; }
+    const FewShotIndex& fewShots() const { return fewShotIndex; }
+    const CorrectionMemory& corrections() const { return correctionMemory; }
+    const IntentClassifier& intentClassifier() const { return classifier; }
+
+    size_t loadedExamples() const { return loaded; }
+
+    // 有未落盘的增量训练就立即保存模型 (进程正常退出时析构也会调用)
+    void flush();
+
+private:
+    HarvestedKnowledge();
+    ~HarvestedKnowledge();
+    HarvestedKnowledge(const HarvestedKnowledge&) = delete;
+    HarvestedKnowledge& operator=(const HarvestedKnowledge&) = delete;
+
+    NearDuplicateIndex nearDupIndex;
+    FewShotIndex fewShotIndex;
+    CorrectionMemory correctionMemory;
+    IntentClassifier classifier;
+    std::atomic<size_t> loaded{0}; // daemon 模式下多个会话会并发 ingest
+
+    void saveModel();
+    void flushLoop();
+    void markDirty();
+
+    std::mutex saveMutex;           // 后台保存和 flush() 不抢写同一个 .tmp 文件
+    std::atomic<bool> dirty{false}; // 有增量训练还没落盘
+    std::once_flag flusherStarted;
+    std::mutex flusherMutex;
+    std::condition_variable flusherCv;
+    bool stopping = false;
+    std::thread flusher;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef JUDGMENT_PARSER_H
+#define JUDGMENT_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <functional>
+
+// 一条从审计日志里挖出来的训练样本
+struct TrainingExample {
+    std::string taskType;     // "CREATE" / "DELETE" (来自 [TaskType] 行)
+    std::string type;         // JSON 里的 type，如 EXEC_CORRECTION / ROUTER_CORRECTION
+    std::string userInput;    // 日志里的 [User Input]
+    std::string input;        // JSON 里的 input (DeepSeek 修正后的样本输入)
+    std::string output;       // JSON 里的 output，如 "mytest.log|1|/tmp"
+    std::string reason;
+    bool outputIsNull = true; // output 为 null 或缺失
+    int score = -1;           // 【评分】，缺失为 -1
+    bool accepted = false;    // 【是否入库】是/否
+
+    // 有可用的修正样本 (不看入库标记)
+    bool hasCorrection() const { return !outputIsNull && !output.empty() && !input.empty(); }
+
+    // output 是可以直接喂给执行器的槽位格式，而不是 "请告诉我..." 这类对话
+    // CREATE: Names|Quantity|Path；DELETE: 路径或文件名，'|' 分隔
+    bool hasSlotOutput() const;
+};
+
+// 解析 JudgmentLogger 写出的日志格式：
+//   ========= INTERACTION LOG =========
+//   ...
+//   ========= DEEPSEEK JUDGMENT =========
+//   【评分】... 【是否入库】... {json}
+class JudgmentParser {
+public:
+    static const std::string_view LOG_MARKER;
+    static const std::string_view JUDGMENT_MARKER;
+
+    // 解析单个会话，找不到 JSON 训练块时返回 false (评分等字段仍会尽量填上)
+    static bool parseSession(std::string_view session, TrainingExample& out);
+
+    // 把一段缓冲区 (单个 .txt 或多会话拼接的训练仓库) 按 LOG_MARKER 切成会话
+    static void splitSessions(std::string_view buffer, const std::function<void(std::string_view)>& onSession);
+};
+
+#endif
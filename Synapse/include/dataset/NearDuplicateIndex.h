@@ -0,0 +1,80 @@
+#ifndef NEAR_DUPLICATE_INDEX_H
+#define NEAR_DUPLICATE_INDEX_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "JudgmentParser.h"
+
+enum class DedupVerdict {
+    Unique,        // 新簇的第一个样本
+    Kept,          // 近重复，但簇里代表数还没满，保留
+    Pruned         // 近重复且簇已满，应剔除
+};
+
+struct DedupResult {
+    DedupVerdict verdict = DedupVerdict::Unique;
+    uint32_t clusterId = 0;
+    uint32_t clusterSize = 0;   // 加入后该簇的代表数
+    double similarity = 0.0;    // 与簇首样本的估计 Jaccard 相似度
+};
+
+// MinHash + LSH 分桶的近重复检测
+// - 签名：按 Unicode 字符 (中文一个字一个单位) 取 n-gram，32 个 MinHash
+// - LSH：8 个 band × 4 行，命中任一 band 即为候选，再用签名估计相似度确认
+// - 每个簇只保留 maxRepresentatives 个代表，多出来的判为 Pruned
+// - 簇数超过 maxClusters 时淘汰最老的簇，内存有上界 (见 memoryBytes)
+// 线程安全：add / 查询都加锁，可被多个会话的 JudgmentLogger 共享
+class NearDuplicateIndex {
+public:
+    static const int NUM_HASHES = 32;
+    static const int NUM_BANDS = 8;
+    static const int ROWS_PER_BAND = NUM_HASHES / NUM_BANDS;
+
+    struct Options {
+        size_t maxRepresentatives = 3;
+        size_t maxClusters = 1 << 18;
+        double threshold = 0.7;
+        int ngram = 3;
+    };
+
+    using Signature = std::array<uint32_t, NUM_HASHES>;
+
+    NearDuplicateIndex();
+    explicit NearDuplicateIndex(const Options& options);
+
+    // 样本文本 = 任务类型 + input + output，不同任务之间不会互相判重
+    static std::string exampleKey(const TrainingExample& ex);
+
+    DedupResult add(std::string_view text);
+    DedupResult add(const TrainingExample& ex) { return add(exampleKey(ex)); }
+
+    Signature signature(std::string_view text) const;
+    static double similarity(const Signature& a, const Signature& b);
+
+    size_t clusterCount() const;
+    size_t memoryBytes() const;
+
+private:
+    struct Cluster {
+        Signature sig;
+        uint32_t count = 0;
+        bool used = false;
+    };
+
+    Options options;
+    std::vector<Cluster> clusters;   // 环形槽位，满了覆盖最老的
+    size_t nextSlot = 0;             // 满了以后下一个被覆盖的槽位
+    size_t liveClusters = 0;
+    std::unordered_map<uint64_t, uint32_t> buckets; // band 哈希 -> 簇槽位
+    mutable std::mutex mtx;
+
+    static uint64_t bandKey(const Signature& sig, int band);
+    void evictSlot(uint32_t slot);
+};
+
+#endif
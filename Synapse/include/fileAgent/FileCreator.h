@@ -7,28 +7,20 @@
 #include "local/local_brain.h"
 #include "cloud/cloud_brain.h"
 #include "judgment/JudgmentLogger.h"
+#include "systemExecutor/SharedBrains.h"
+#include "session/Task.h"
 
-enum CreatorState {
-    STATE_IDLE,
-    STATE_WAIT_FILENAME,    
-    STATE_WAIT_EXTENSION,   // 改为：逐个或统一处理后缀
-    STATE_WAIT_PATH,        
-    STATE_WAIT_SELECTION,
-    STATE_WAIT_PATH_OVERFLOW_CONFIRM // ✨ 新增：搜索结果太多，等待用户确认是否显示    
-};
-
-
-
+// 创建流程是一个协程：原来的 IDLE / WAIT_FILENAME / WAIT_EXTENSION / WAIT_PATH /
+// WAIT_SELECTION / WAIT_PATH_OVERFLOW_CONFIRM 状态机 + goto，
+// 现在就是顺序代码里的几处 co_await (追问用户、问模型、搜路径)
 class FileCreator {
 private:
-    std::unique_ptr<LocalBrain> aiBrain;
+    std::shared_ptr<LocalBrain> aiBrain;
 
     // ✨✨✨ 这里必须声明，不然 cpp 里就会报“未定义标识符” ✨✨✨
-    std::unique_ptr<CloudBrain> cloudBrain;
+    std::shared_ptr<CloudBrain> cloudBrain;
     std::unique_ptr<JudgmentLogger> logger;
     
-    CreatorState currentState;
-    
     std::vector<std::string> targetNames; 
     int targetCount;                      
     std::string targetPathKey;            
@@ -42,26 +34,36 @@ private:
     };
 
     std::string getHomeDir();
-    void searchPaths(const std::string& keyword);
-    bool askAIForIntent(const std::string& input);
-    void performCreateFile(const std::string& finalPath);
-    
-    std::vector<std::string> splitString(const std::string& str, char delimiter);
-    // ✨ 新增：专门处理文件名的分割（自动兼容中英文逗号）
-    std::vector<std::string> parseNames(const std::string& rawInput);
+    Task<void> searchPaths(std::string keyword);
+    Task<bool> askAIForIntent(std::string input);
+    Task<std::string> promptLocalBrain(std::string input);
+    Task<void> performCreateFile(std::string finalPath);
+
+    // 追问用户：读一行并记入日志，会话结束 (exit / 断开) 返回 false
+    Task<bool> readAnswer(std::string& answer);
+    Task<bool> collectNames();
+    Task<bool> collectExtensions();
+    Task<bool> readPathKey();
+    Task<bool> resolvePathAndCreate();
+
     void autoGenerateNames();
 
     // 检查是否所有文件都有后缀了
     bool checkAllExtensionsReady();
 
 public:
-    FileCreator();
-    bool processInput(std::string input);
-    // ✨✨✨【关键修复】告诉 Router 我是不是正在忙 ✨✨✨
-    // 如果返回 true，Router 就会直接把输入传给我，而不去问 AI
-    bool isBusy() {
-        return currentState != STATE_IDLE;
-    }
+    explicit FileCreator(std::shared_ptr<SharedBrains> brains = SharedBrains::create());
+    // 不是创建指令返回 false；是的话一直跑到文件建好 (或用户中途离开) 才返回
+    Task<bool> processInput(std::string input);
+
+    // 以下都不依赖会话状态，静态以便 synapse_bench 直接测
+    static std::vector<std::string> splitString(const std::string& str, char delimiter);
+    // 参数提取 prompt；dynamicShots 为检索到的修正样例 (已按 "Input: / Output: " 排好)。预热也用它生成前缀
+    static std::string extractionPrompt(const std::string& input, const std::string& dynamicShots);
+    // ✨ 新增：专门处理文件名的分割（自动兼容中英文逗号）
+    static std::vector<std::string> parseNames(const std::string& rawInput);
+    // 在 home 下按关键词找目录：常用目录别名 + find (阻塞，调用方放到线程池里)
+    static std::vector<std::string> searchDirectories(const std::string& keyword, const std::string& home);
 };
 
 #endif
\ No newline at end of file
@@ -9,25 +9,35 @@
 #include "TrashManager.h"
 #include "JudgmentLogger.h"
 #include "security_guard.h" 
+#include "SharedBrains.h"
+#include "Task.h"
 
 class FileDeleter {
 public:
-    FileDeleter();
+    explicit FileDeleter(std::shared_ptr<SharedBrains> brains = SharedBrains::create());
     ~FileDeleter() = default;
 
     // 统一处理入口
-    bool processInput(std::string input);
-    
-    // 简单的忙碌状态
-    bool isBusy() { return false; } 
+    // 协程：追问文件名、多选、删除确认都在这里 co_await 用户输入，不再阻塞 getline(cin)
+    Task<bool> processInput(std::string input);
+
+    // 正则兜底：模型没给出目标时，从原句里抠绝对路径和 xxx.ext 形式的文件名
+    // 静态以便 synapse_bench 直接测
+    static std::vector<std::string> extractTargetsByPattern(const std::string& input);
+
+    // 在 root 下 (最多 4 层) 按文件名找，searchFileInSystem 的实际搜索；静态以便基准直接测
+    static std::vector<std::string> findFiles(const std::string& filename, const std::string& root);
+
+    // 目标提取 prompt；dynamicShots 为检索到的修正样例 (已按 "In: / Out: " 排好)。预热也用它生成前缀
+    static std::string extractionPrompt(const std::string& input, const std::string& dynamicShots);
 
 private:
     // 1. 意图识别：提取文件名列表
-    bool parseDeleteIntent(const std::string& input, std::vector<std::string>& rawTargets);
+    Task<bool> parseDeleteIntent(std::string input, std::vector<std::string>& rawTargets);
     
     // 2. [新增] 路径解析核心：将模糊文件名转换为绝对路径
     // 返回值：解析后的完整路径列表。如果用户取消或找不到，返回空。
-    std::vector<std::string> resolveTargetPaths(const std::vector<std::string>& rawTargets);
+    Task<std::vector<std::string>> resolveTargetPaths(std::vector<std::string> rawTargets);
 
     // 3. [新增] 辅助函数：在系统中搜索文件
     // 返回找到的所有路径候选
@@ -35,13 +45,13 @@ private:
 
     // 4. [新增] 用户交互：最终确认
     // isDirectory: 是否包含目录操作（触发额外警告）
-    bool getUserConfirmation(const std::vector<std::string>& finalPaths);
+    Task<bool> getUserConfirmation(std::vector<std::string> finalPaths);
 
     // 5. 执行逻辑
     void executeDelete(const std::vector<std::string>& finalPaths);
 
-    std::unique_ptr<LocalBrain> aiBrain;
-    std::unique_ptr<CloudBrain> cloudBrain;
+    std::shared_ptr<LocalBrain> aiBrain;
+    std::shared_ptr<CloudBrain> cloudBrain;
     std::unique_ptr<TrashManager> trashManager;
     std::unique_ptr<JudgmentLogger> logger;
     std::unique_ptr<SecurityGuard> securityGuard;
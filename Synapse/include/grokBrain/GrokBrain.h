@@ -13,12 +13,18 @@ public:
     // 如果是兜底意图识别，建议 prompt 里限制它只输出 json 或特定关键词
     std::string think(const std::string& prompt);
 
+    // JSON 转义 (换行、引号、控制字符)，静态以便 synapse_bench 直接测
+    static std::string jsonEscape(const std::string& input);
+
 private:
     // 灵芽平台的 API 配置
     std::string apiKey;
     std::string apiUrl;
     std::string modelName; // 例如 "grok-beta" 或灵芽支持的其他模型名
 
+    // 构造请求体并发送 (录制 / 回放见 BackendTrace)
+    std::string request(const std::string& prompt);
+
     // 内部使用的 HTTP 发送函数
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
     std::string sendRequest(const std::string& jsonBody);
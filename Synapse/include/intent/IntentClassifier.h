@@ -0,0 +1,68 @@
+#ifndef INTENT_CLASSIFIER_H
+#define INTENT_CLASSIFIER_H
+
+#include <array>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JudgmentParser.h"
+
+struct IntentPrediction {
+    std::string label = "OTHER";  // CREATE / DELETE / OTHER
+    double confidence = 0.0;      // softmax 概率
+};
+
+// CPU 上的轻量意图分类器：字符 n-gram 哈希特征 + 多分类逻辑回归 (在线 SGD)
+// - 特征：Unicode 1/2/3-gram 哈希到 2^18 个桶，中文不需要分词
+// - 训练：每条审计过的会话做一步 SGD，可增量学习
+// - 模型文件：只存非零权重的紧凑二进制
+// - 预测：几十个特征的点积，单次微秒级
+class IntentClassifier {
+public:
+    static const int NUM_CLASSES = 3;
+    static const uint32_t NUM_BUCKETS = 1u << 18;
+    static const char* const LABELS[NUM_CLASSES];
+
+    IntentClassifier();
+
+    IntentPrediction predict(std::string_view text) const;
+
+    // label 为 CREATE / DELETE / OTHER，未知标签忽略
+    // newExample 为 false 表示同一批样本的第二轮及以后 (离线多轮训练)：只做梯度，不计入样本数和留出准确率
+    void update(std::string_view text, const std::string& label, double learningRate = 0.2, bool newExample = true);
+
+    // 从审计样本推出路由标签：EXEC_CORRECTION 说明路由正确 (= TaskType)，
+    // ROUTER_CORRECTION 的 output 给出正确意图
+    static bool labelFor(const TrainingExample& ex, std::string& text, std::string& label);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // 见过的不同样本数 (多轮训练只算一次)
+    uint64_t trainedExamples() const;
+    // 留出准确率：每条新样本训练前先预测一次 (模型还没见过它)，最近约 100 条的命中率
+    double heldOutAccuracy() const;
+
+    // 按类别统计的样本数和留出准确率 (该类样本被判对的比例)，取三类里最差的那个：
+    // 某一类 (通常是 OTHER) 样本太少或总被判错时，总体准确率会掩盖它
+    uint64_t minClassExamples() const;
+    double minClassAccuracy() const;
+
+private:
+    std::vector<float> weights;               // NUM_BUCKETS * NUM_CLASSES
+    std::array<float, NUM_CLASSES> bias{};
+    uint64_t trained = 0;
+    uint64_t evaluated = 0;
+    double accuracy = 0;
+    std::array<uint64_t, NUM_CLASSES> classTrained{};
+    std::array<double, NUM_CLASSES> classAccuracy{};
+    mutable std::shared_mutex mtx;
+
+    static void features(std::string_view text, std::vector<uint32_t>& out);
+    static int labelIndex(const std::string& label);
+    void scores(const std::vector<uint32_t>& feats, std::array<double, NUM_CLASSES>& probs) const;
+};
+
+#endif
@@ -5,12 +5,16 @@
 #include <vector>
 #include <sstream>
 #include "../cloud/cloud_brain.h"
+#include "Task.h"
 
 class JudgmentLogger {
 private:
     std::stringstream sessionLog; // 内存中的日志流
     std::string currentTimestamp();
 
+    // 审计一份日志并写入 training_data (或 pruned/)
+    Task<void> audit(CloudBrain* cloudBrain, const std::string& finalLog);
+
 public:
     JudgmentLogger();
     
@@ -18,7 +22,9 @@ public:
     void record(const std::string& actor, const std::string& action);
     
     // 结束当前会话：保存文件并请求 AI 判别
-    void finalizeSession(CloudBrain* cloudBrain);
+    // 审计是一次云端调用，协程在等待期间挂起，不占事件循环
+    // DeepSeek 额度用完时不审计，日志存进 training_data/deferred/，之后有额度的审计会顺带补审
+    Task<void> finalizeSession(CloudBrain* cloudBrain);
     
     // 清空日志，准备下一次指令
     void clear();
@@ -1,7 +1,26 @@
 #ifndef LOCAL_BRAIN_H
 #define LOCAL_BRAIN_H
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+#include "BrainConfig.h"
+
+// 预热结果：加载模型和预填 prompt 各花了多久，失败时 error 非空
+struct WarmupReport {
+    bool ok = false;
+    double loadMs = 0;
+    double primeMs = 0;
+    std::string error;
+};
+
+// 预热目标：一个任务的 profile 和它固定的 prompt 前缀 (代入一句示例输入)
+struct WarmupTarget {
+    ModelProfile profile;
+    std::vector<std::string> primePrompts;
+};
 
 class LocalBrain {
 public:
@@ -10,18 +29,41 @@ public:
 
     // 核心接口：与本地模型对话
     // 参数 prompt: 用户的输入或系统指令
+    // 参数 profile: 任务的模型和生成参数 (BrainConfig::profile)，为空时用默认模型和默认参数
     // 返回: 模型的回复文本
-    std::string talk(const std::string& prompt);
+    std::string talk(const std::string& prompt, const ModelProfile* profile = nullptr);
+
+    // 无状态的编解码，静态以便 synapse_bench 直接测
+    static std::string jsonEscape(const std::string& input);
+    static std::string extractResponse(const std::string& jsonResponse);
+
+    // 后台预热：每个不同的 (模型, num_ctx) 带 keep_alive 预加载一次，再把各任务固定的 prompt 按各自的 profile 跑一遍
+    // (num_predict = 1，num_ctx 同 profile，否则真正请求时 Ollama 会重新加载)，第一条指令就是稳态延迟。
+    // 任何一步失败都记进 report.error。进程内只跑一次，重复调用直接返回；回放模式和 SYNAPSE_WARMUP=0 时不预热
+    void startWarmUp(const std::vector<WarmupTarget>& targets);
+    // 预热结束 (成功或失败) 时在预热线程上回调，只通知在等预热的调用方：
+    // 已经结束或不预热时不回调 (几小时后才连上的会话不该再收到一条旧的就绪消息)。
+    // 可以在 startWarmUp 之前登记，连接失败这种瞬间结束的预热也不会漏报
+    void onWarm(std::function<void(const WarmupReport&)> callback);
 
 private:
-    // 配置部分 (方便后续修改)
-    const std::string modelName = "qwen2.5:1.5b"; // 请确保 `ollama list` 里有这个名字
-    const std::string apiUrl = "http://localhost:11434/api/generate";
+    // 配置部分 (默认值在 BrainConfig.cpp，可用 SYNAPSE_OLLAMA_URL / SYNAPSE_OLLAMA_MODEL 覆盖)
+    std::string modelName; // 请确保 `ollama list` 里有这个名字
+    std::string apiUrl;
+    std::string keepAlive; // 请求里带的 keep_alive：空闲多久后 Ollama 卸载模型
+
+    struct WarmState {
+        std::mutex mtx;
+        bool started = false;
+        bool done = false;
+        std::vector<std::function<void(const WarmupReport&)>> listeners;
+    };
+    std::shared_ptr<WarmState> warm;
 
-    // 内部工具函数：JSON 清洗与解析
-    std::string jsonEscape(const std::string& input);
-    std::string extractResponse(const std::string& jsonResponse);
     std::string executeCurl(const std::string& cmd);
+
+    // 真正发 HTTP 请求 (录制 / 回放见 BackendTrace)
+    std::string request(const std::string& prompt, const ModelProfile& profile);
 };
 
 #endif // LOCAL_BRAIN_H
\ No newline at end of file
@@ -16,6 +16,9 @@ private:
     std::vector<std::string> dangerousPatterns; // 黑名单
     std::vector<std::string> protectedPaths;    // ✨ 新增：受保护路径
 
+    // 拦截时返回原因 (指标标签)，放行返回 nullptr
+    const char* evaluate(const std::string& cmd);
+
     bool isFormatValid(const std::string& cmd);
     bool containsDangerousPattern(const std::string& cmd);
     
@@ -0,0 +1,122 @@
+#ifndef BACKEND_SCHEDULER_H
+#define BACKEND_SCHEDULER_H
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include "EventLoop.h"
+#include "Metrics.h"
+
+// 模型后端 (local / cloud / grok) 的请求调度
+// 同一个 Ollama、同一份云端额度被交互指令、审计、--batch 共用；以前谁先到谁先发，
+// 审计和批量任务一多，用户正在等的路由 / 抽取请求就排在后面。
+// - 每个后端有并发上限 (对齐它真实的并行度)，拿到名额才发请求，等名额时协程挂起，不占线程
+// - 两个优先级：交互 (Interactive) 永远排在所有等待中的后台 (Background，审计和 --batch) 请求前面
+// - 同一优先级内按会话轮转，一个会话排再多请求也不会饿死别的会话
+// - 准入控制：后台请求在排队数达到上限时直接拒绝 (审计转为延后)，交互请求不拒绝
+//
+//   BackendSlot slot = co_await scheduleBackend("local");
+//   string reply = co_await offload([&] { return localBrain->talk(prompt); });
+//   // slot 析构时归还名额
+//
+// 配置 (PREFIX 同 BrainConfig)：
+//   SYNAPSE_<PREFIX>_CONCURRENCY  并发上限 (默认 local 4，对齐 OLLAMA_NUM_PARALLEL；cloud / grok 8)
+//   SYNAPSE_<PREFIX>_QUEUE        后台请求的最大排队数 (默认 256)
+
+class BackendScheduler;
+
+// 一个并发名额；被拒绝时为空 (operator bool 为 false)。只能移动，析构时归还
+class BackendSlot {
+public:
+    BackendSlot() = default;
+    BackendSlot(BackendSlot&& other) noexcept;
+    BackendSlot& operator=(BackendSlot&& other) noexcept;
+    BackendSlot(const BackendSlot&) = delete;
+    BackendSlot& operator=(const BackendSlot&) = delete;
+    ~BackendSlot();
+
+    explicit operator bool() const { return granted; }
+
+private:
+    friend class BackendScheduler;
+    BackendSlot(BackendScheduler* scheduler, int backend, bool counted)
+        : scheduler(scheduler), backend(backend), granted(true), counted(counted) {}
+
+    BackendScheduler* scheduler = nullptr;
+    int backend = -1;
+    bool granted = false;
+    bool counted = false; // 不在事件循环里 (离线工具) 时直接放行，不占名额
+};
+
+class BackendScheduler {
+public:
+    static BackendScheduler& instance();
+
+    class Awaiter {
+    public:
+        Awaiter(BackendScheduler& scheduler, int backend, RequestPriority priority)
+            : scheduler(scheduler), backend(backend), priority(priority) {}
+        bool await_ready();
+        // 能立即放行或被拒绝时返回 false (不挂起)
+        bool await_suspend(std::coroutine_handle<> h);
+        BackendSlot await_resume();
+    private:
+        friend class BackendScheduler;
+        BackendScheduler& scheduler;
+        int backend;
+        RequestPriority priority;
+        enum class State { Granted, Rejected, Unscheduled, Waiting } state = State::Waiting;
+        std::coroutine_handle<> handle;
+        EventLoop* loop = nullptr;
+        EventLoop::Strand* strand = nullptr;
+        SessionChannel* channel = nullptr;
+        uint64_t sessionId = 0;
+        uint64_t enqueuedNs = 0;
+    };
+
+    // backend 为 local / cloud / grok，未知名字直接放行
+    Awaiter acquire(const std::string& backend, RequestPriority priority);
+
+    // 各后端并发上限之和：阻塞线程池至少要这么大，拿到名额的请求才不会在线程池里排队
+    size_t totalCapacity() const;
+
+private:
+    friend class BackendSlot;
+    BackendScheduler();
+    void release(int backend);
+    void resume(Awaiter* waiter);
+
+    struct Backend {
+        std::string name;
+        int capacity = 1;
+        size_t queueLimit = 256;
+        int inFlight = 0;
+        // 每个优先级：会话 ID -> 该会话排队中的请求 (FIFO)；lastSession 是上次放行的会话，轮转从它后面开始
+        std::map<uint64_t, std::deque<Awaiter*>> queues[2];
+        uint64_t lastSession[2] = {0, 0};
+        size_t queued[2] = {0, 0};
+        // 指标对象在构造时注册好，调度路径上不再查表
+        Gauge* inFlightGauge = nullptr;
+        Gauge* queueDepth[2] = {};
+        Histogram* wait[2] = {};
+        Counter* rejected = nullptr;
+    };
+
+    Awaiter* popNext(Backend& backend);
+
+    std::mutex mtx;
+    Backend backends[3];
+};
+
+// 当前会话的优先级：--batch 的会话是后台，其余是交互
+RequestPriority currentRequestPriority();
+
+// co_await scheduleBackend("local")：按当前会话的优先级排队
+inline BackendScheduler::Awaiter scheduleBackend(const std::string& backend) {
+    return BackendScheduler::instance().acquire(backend, currentRequestPriority());
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "SharedBrains.h"
+#include "EventLoop.h"
+
+// 批量指令的一行：
+// {"id": "c1", "command": "在桌面建个 a.txt", "answers": ["a", ".txt", "桌面"]}
+// answers 按顺序回答追问 (文件名、后缀、路径、删除确认...)，用完了还在追问就当用户离开
+struct BatchCommand {
+    size_t index = 0; // 在输入文件里的行号 (从 1 开始)
+    std::string id;
+    std::string command;
+    std::vector<std::string> answers;
+};
+
+// 非交互批量模式 (--batch)
+// 取代 pexpect 串行驱动：每条指令是一个独立会话 (MemoryChannel 收输出)，
+// 在同一个事件循环上并发执行，大脑和已收割知识全部共用；
+// 同时在跑的指令数受 jobs 限制，模型调用的阻塞线程池也按 jobs 开，吞吐随后端容量扩展。
+// 每条指令跑完输出一行 JSON 结果 (按完成顺序，用 index / id 对应)：
+// {"index":1,"id":"c1","command":"...","understood":true,"answers_used":3,"answers_left":0,
+//  "starved":false,"queued_ms":0.1,"elapsed_ms":812.4,"events":[{...}, ...],"event_ms":[0.3, ...]}
+class BatchRunner {
+public:
+    BatchRunner(std::shared_ptr<SharedBrains> brains, size_t jobs, size_t workers);
+
+    // 解析一行输入，失败时 error 给出原因
+    static bool parseCommand(const std::string& line, BatchCommand& cmd, std::string& error);
+
+    // 读完 in 里的全部指令并执行，结果写到 outFd；返回无法解析或未被理解的指令数
+    size_t run(std::istream& in, int outFd);
+
+private:
+    struct Job;
+
+    void startNext();
+    void finishJob(const std::shared_ptr<Job>& job, bool understood);
+    void writeRecord(const std::string& record);
+    double msSince(std::chrono::steady_clock::time_point t) const;
+
+    std::shared_ptr<SharedBrains> brains;
+    size_t jobs;
+    size_t workers;
+    int outFd = -1;
+
+    std::unique_ptr<EventLoop> loop;
+    std::vector<BatchCommand> commands;
+    std::chrono::steady_clock::time_point batchStart;
+
+    std::mutex scheduleMutex;
+    size_t nextCommand = 0;
+    size_t inFlight = 0;
+    std::atomic<size_t> failures{0};
+};
+
+#endif
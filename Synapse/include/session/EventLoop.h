@@ -0,0 +1,154 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "SessionChannel.h"
+
+// 请求优先级：交互 (用户正在等) 和后台 (审计、--batch)。调度器和阻塞线程池都按它排队
+enum class RequestPriority { Interactive, Background };
+
+// 会话事件循环
+// run(workers) 起一组工作线程；每个会话挂在自己的 Strand 上，
+// 同一个会话的任务严格串行 (会话内部不需要加锁)，不同会话在工作线程间并行。
+// 会阻塞的调用 (模型请求、find 搜索、审计) 交给阻塞线程池，完成后再回到会话的 Strand 恢复。
+// 这样成百上千个等用户 / 等模型的会话只占几个工作线程加一个小线程池。
+class EventLoop {
+public:
+    static const size_t DEFAULT_BLOCKING_THREADS = 8;
+
+    // 一个会话的串行任务队列 (用 shared_ptr 持有：正在跑的批次会续命，会话先释放也不怕)
+    class Strand : public std::enable_shared_from_this<Strand> {
+    public:
+        Strand(EventLoop& loop, SessionChannel* channel) : loop(loop), channel(channel) {}
+
+        // 线程安全；任务执行期间绑定该会话的输出通道
+        void post(std::function<void()> fn);
+
+        // 当前线程正在执行的 Strand，不在任何 Strand 里返回 nullptr
+        static Strand* current();
+
+    private:
+        friend class EventLoop;
+        void runBatch();
+
+        EventLoop& loop;
+        SessionChannel* channel;
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+        bool scheduled = false;
+    };
+
+    explicit EventLoop(size_t blockingThreads = DEFAULT_BLOCKING_THREADS);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // 投递一个与会话无关的任务 (线程安全)
+    void post(std::function<void()> fn);
+
+    // 在阻塞线程池执行 (线程安全)
+    // 交互任务排在所有排队中的后台任务前面：调度器放行的交互请求不能在线程池里又排到一堆审计后面
+    void runBlocking(std::function<void()> fn, RequestPriority priority = RequestPriority::Interactive);
+
+    // 当前线程加上 workers-1 个新线程一起跑循环，直到 stop()
+    void run(size_t workers = 1);
+    void stop();
+
+    // 默认工作线程数：CPU 核数 (至少 2，一个会话卡在 CPU 上时别的会话还能走)
+    static size_t defaultWorkers();
+
+    // 当前线程正在跑的事件循环，不在循环里返回 nullptr
+    static EventLoop* current();
+
+private:
+    void workerLoop();
+    void blockingWorker();
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> ready;
+    bool stopping = false;
+
+    std::mutex poolMutex;
+    std::condition_variable poolCv;
+    std::deque<std::function<void()>> blockingQueue[2]; // 下标为 RequestPriority
+    std::vector<std::thread> pool;
+    bool poolStopping = false;
+};
+
+// co_await offload([&] { return brain->talk(prompt); });
+// 在阻塞线程池里执行 fn，完成后回到原来的 Strand 上恢复。
+// 不在事件循环里调用 (例如离线工具) 时直接同步执行。
+// 注意：lambda 一律用 [&] 捕获 (协程帧里的变量活得比 awaiter 久)。
+// GCC 12 对 co_await 操作数里按值捕获的临时 lambda 会析构两次 (double free)。
+template <typename F>
+class OffloadAwaiter {
+public:
+    using Result = std::invoke_result_t<F&>;
+    static_assert(!std::is_void_v<Result>, "offload() 需要有返回值");
+
+    OffloadAwaiter(F fn, std::optional<RequestPriority> priority)
+        : fn(std::move(fn)), loop(EventLoop::current()), priority(priority) {}
+
+    bool await_ready() const noexcept { return loop == nullptr; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        EventLoop* target = loop;
+        EventLoop::Strand* strand = EventLoop::Strand::current();
+        SessionChannel* channel = &SessionChannel::current();
+        // 没指定优先级时跟会话走：--batch 的会话是后台
+        RequestPriority lane = priority.value_or(channel->isBackground() ? RequestPriority::Background
+                                                                          : RequestPriority::Interactive);
+        target->runBlocking([this, target, strand, channel, h] {
+            // 会话此时挂起着，阻塞调用里的输出 (如 "[DeepSeek] Thinking...") 照样发给它
+            SessionChannel::bind(channel);
+            result.emplace(fn());
+            SessionChannel::bind(nullptr);
+            // 投递之后协程随时可能恢复并销毁本对象，下面不能再碰 this
+            if (strand) {
+                strand->post([h] { h.resume(); });
+            } else {
+                target->post([h, channel] {
+                    SessionChannel::bind(channel);
+                    h.resume();
+                    SessionChannel::bind(nullptr);
+                });
+            }
+        }, lane);
+    }
+
+    Result await_resume() {
+        if (!result) return fn();
+        return std::move(*result);
+    }
+
+private:
+    F fn;
+    EventLoop* loop;
+    std::optional<RequestPriority> priority;
+    std::optional<Result> result;
+};
+
+template <typename F>
+OffloadAwaiter<F> offload(F fn) {
+    return OffloadAwaiter<F>(std::move(fn), std::nullopt);
+}
+
+// 显式指定线程池里的优先级 (如交互会话里发起的审计是后台任务)
+template <typename F>
+OffloadAwaiter<F> offload(F fn, RequestPriority priority) {
+    return OffloadAwaiter<F>(std::move(fn), priority);
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// 无锁多生产者单消费者队列 (Vyukov 侵入式链表)
+// push 只有一次原子交换，任意线程可调用；tryPop / empty 只能由唯一的消费者线程调用。
+// 生产者交换完 head、还没链上 next 的瞬间，tryPop 可能返回 false 但 empty() 为 false，
+// 消费者据此判断 "稍后再取" 而不是去睡眠。
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(&stub), tail(&stub) {}
+
+    ~MpscQueue() {
+        T ignored;
+        while (tryPop(ignored)) {}
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node;
+        node->value = std::move(value);
+        pushNode(node);
+    }
+
+    bool tryPop(T& out) {
+        Node* t = tail;
+        Node* next = t->next.load(std::memory_order_acquire);
+        if (t == &stub) {
+            if (!next) return false;
+            tail = next;
+            t = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail = next;
+            return take(t, out);
+        }
+        if (t != head.load(std::memory_order_acquire)) return false; // 有生产者正在链接
+        // t 是最后一个节点：把 stub 推到它后面，才能把 t 摘下来
+        pushNode(&stub);
+        next = t->next.load(std::memory_order_acquire);
+        if (next) {
+            tail = next;
+            return take(t, out);
+        }
+        return false;
+    }
+
+    bool empty() const {
+        Node* t = tail;
+        return t->next.load(std::memory_order_acquire) == nullptr &&
+               head.load(std::memory_order_seq_cst) == t;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    void pushNode(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        // seq_cst：与消费者 "置睡眠标志 -> 再查一次 empty()" 配对，避免丢失唤醒
+        Node* prev = head.exchange(node, std::memory_order_seq_cst);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool take(Node* node, T& out) {
+        out = std::move(node->value);
+        delete node;
+        return true;
+    }
+
+    std::atomic<Node*> head;
+    Node* tail;
+    Node stub;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MpscQueue.h"
+
+// 输出事件：往哪个 fd 写什么
+// afterWrite 在该 fd 此前排队的数据都写出去 (或连接已断开) 之后，在写线程上调用
+struct OutputEvent {
+    int fd = -1;
+    std::string data;
+    std::function<void()> afterWrite;
+};
+
+// 全进程唯一的输出线程
+// 会话线程只管把输出事件丢进无锁队列，真正的 write 都在这里做：
+// - 同一个 fd 的连续事件合并成一次 write
+// - socket 写满 (EAGAIN) 时挂起该 fd 等 POLLOUT，不拖慢其他连接的输出
+// - 某个连接积压超过上限 (客户端不读输出) 就断开它，积压不会无限增长；stdout 不设上限 (阻塞写，本身有背压)
+class OutputWriter {
+public:
+    static OutputWriter& instance();
+
+    // 任意线程可调用 (无锁)
+    void push(OutputEvent event);
+
+    // 把已排队的输出全部写完再停掉写线程 (退出前调用)
+    void shutdown();
+
+private:
+    OutputWriter();
+    ~OutputWriter();
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    struct Sink {
+        std::string pending;
+        std::vector<std::function<void()>> callbacks;
+        bool broken = false;
+        bool unbounded = false; // 不是 socket，超限也不断开
+    };
+
+    void run();
+    void drainQueue();
+    // 尽量把 pending 写出去，写完 (或已断开) 返回 true
+    bool flushSink(int fd, Sink& sink);
+    // 积压超限：socket 就丢掉之后发往它的输出并断开连接
+    void dropSink(int fd, Sink& sink);
+
+    MpscQueue<OutputEvent> queue;
+    std::map<int, Sink> sinks; // 只有写线程访问
+    int wakeFd = -1;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "SessionChannel.h"
+#include "EventLoop.h"
+#include "Task.h"
+#include "SharedBrains.h"
+
+// 一个用户会话 = 一个输出通道 + 一个跑在事件循环 Strand 上的协程
+// 协程里顺序地 "读一行 -> SystemExecutor 处理 (中途可以继续追问用户、等模型)"，
+// 追问和模型调用都是挂起点，不占线程
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    Session(uint64_t id, std::unique_ptr<SessionChannel> channel);
+
+    uint64_t id() const { return sessionId; }
+
+    // 在事件循环上启动会话；结束 (exit / 对端关闭) 后在工作线程上回调 onFinished
+    void start(EventLoop& loop, std::shared_ptr<SharedBrains> brains, std::function<void()> onFinished);
+
+    // 以下由读线程调用 (线程安全)，实际处理投递到事件循环
+    // 收到 "exit" 等同于 close()；会话结束后再调用直接忽略 (事件循环可能已经没了)
+    void deliver(std::string line);
+    void close();
+    // 已投递但会话还没读走的输入字节 (含还在 Strand 队列里的)，读线程超过上限时暂停读这个连接
+    size_t queuedInputBytes() const { return inTransitBytes.load(std::memory_order_relaxed) + channel->pendingInputBytes(); }
+
+private:
+    Task<void> main(std::shared_ptr<SharedBrains> brains);
+    void post(std::function<void()> fn);
+
+    uint64_t sessionId;
+    std::unique_ptr<SessionChannel> channel;
+    std::shared_ptr<EventLoop::Strand> strand;
+
+    std::atomic<size_t> inTransitBytes{0};
+
+    std::mutex stateMutex;
+    bool finished = false;
+};
+
+#endif
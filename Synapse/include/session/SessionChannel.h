@@ -0,0 +1,193 @@
+#ifndef SESSION_CHANNEL_H
+#define SESSION_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "SessionEvent.h"
+
+// 会话的输入输出通道
+// 原来各模块直接 cout / getline(cin)，只能服务一个用户；
+// 现在统一走 "当前线程绑定的通道"，stdin 模式默认绑定 stdio，
+// daemon 模式由事件循环在恢复某个会话协程时绑定它自己的通道。
+//
+// 输入是协程式的：co_await nextLine(line) 有现成的行立即返回，
+// 否则挂起会话，等读线程 deliver() 过来再恢复，不阻塞任何线程。
+// 输入相关的方法只能在事件循环线程调用。
+//
+// 输出分两种协议：
+// - Text：给人看的文本，事件渲染成原来的 "[THINK] ..." 等格式
+// - JsonLines：给 GUI 的帧协议，一个事件一行 JSON，带会话 ID 和序号；
+//   out() 里没分类的裸输出按行包成 info 事件，不会破坏帧
+class SessionChannel {
+public:
+    enum class Protocol { Text, JsonLines };
+
+    virtual ~SessionChannel() = default;
+
+    virtual std::ostream& out() = 0;
+
+    void setProtocol(Protocol p) { protocol = p; }
+    void setSessionId(uint64_t id) { sessionId = id; }
+    uint64_t id() const { return sessionId; }
+    // 后台会话 (--batch 的指令) 调模型时排在交互会话后面，见 BackendScheduler
+    void setBackground(bool value) { background = value; }
+    bool isBackground() const { return background; }
+
+    // 发出一个事件：先把 out() 里缓冲的文本推出去保证顺序，再整体写出一帧
+    void emit(const SessionEvent& event);
+
+    class LineAwaiter {
+    public:
+        LineAwaiter(SessionChannel& channel, std::string& line) : channel(channel), line(line) {}
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        // 对端关闭 (或输入 exit) 且没有剩余输入时返回 false
+        bool await_resume();
+    private:
+        SessionChannel& channel;
+        std::string& line;
+        uint64_t suspendedNs = 0; // 挂起等输入的起点，记 "input.wait" span
+    };
+
+    LineAwaiter nextLine(std::string& line) { return LineAwaiter(*this, line); }
+
+    // 读线程送来的一行；有协程在等就直接恢复它
+    void deliver(std::string line);
+    // 不会再有输入了
+    void close();
+    bool isClosed() const { return closed; }
+    // 还没被读走的输入行数
+    size_t pendingInput() const { return pendingLines.size(); }
+    // 还没被读走的输入字节数，读线程据此做背压 (可跨线程读)
+    size_t pendingInputBytes() const { return pendingBytes.load(std::memory_order_relaxed); }
+    // 有人在对端关闭后还想读输入 (追问没有得到回答)
+    bool inputStarved() const { return starved; }
+
+    // 当前线程绑定的通道，未绑定时是 stdio
+    static SessionChannel& current();
+    // 绑定到当前线程，传 nullptr 恢复 stdio
+    static void bind(SessionChannel* channel);
+
+protected:
+    // 已经按协议编码好的字节
+    virtual void writeRaw(std::string data) = 0;
+    // out() 的缓冲刷出来的文本：Text 原样写，JsonLines 包成 info 事件
+    void writeText(std::string text);
+
+    // out() 用的缓冲：endl / flush / 写满时把文本交给 writeText
+    class TextBuf : public std::streambuf {
+    public:
+        explicit TextBuf(SessionChannel& owner);
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+    private:
+        SessionChannel& owner;
+        char buffer[4096];
+        void flushBuffer();
+    };
+
+private:
+    void wakeWaiter();
+    std::string encode(const SessionEvent& event);
+
+    Protocol protocol = Protocol::Text;
+    uint64_t sessionId = 0;
+    uint64_t seq = 0;
+    bool background = false;
+
+    std::deque<std::string> pendingLines;
+    std::atomic<size_t> pendingBytes{0};
+    std::coroutine_handle<> waiter;
+    bool closed = false;
+    bool starved = false;
+};
+
+// 便捷写法：sessionOut() << "..." << endl;
+std::ostream& sessionOut();
+// 便捷写法：if (co_await sessionReadLine(line)) ...
+SessionChannel::LineAwaiter sessionReadLine(std::string& line);
+
+// 便捷写法：sessionEvent(EventType::Thinking) << "..." << x;
+// 语句结束 (临时对象析构) 时作为一个事件发到当前通道；文本不需要带换行
+class EventBuilder {
+public:
+    explicit EventBuilder(EventType type) : type(type) {}
+    EventBuilder(const EventBuilder&) = delete;
+    EventBuilder& operator=(const EventBuilder&) = delete;
+    ~EventBuilder();
+
+    template <typename T>
+    EventBuilder& operator<<(const T& value) {
+        text << value;
+        return *this;
+    }
+
+private:
+    EventType type;
+    std::ostringstream text;
+};
+
+EventBuilder sessionEvent(EventType type);
+// 候选列表：title 是说明，items 按顺序编号 (文本模式下显示为 [1] ... [n])，skip 非空时另有 [0] 选项
+void sessionCandidates(const std::string& title, std::vector<std::string> items,
+                       CandidateLayout layout = CandidateLayout::Lines, const std::string& skip = "");
+
+// 直接写 cout，没有绑定任何会话时的兜底
+class StdioChannel : public SessionChannel {
+public:
+    std::ostream& out() override;
+protected:
+    void writeRaw(std::string data) override;
+};
+
+// 基于文件描述符 (stdout / Unix socket) 的输出通道
+// 输出带缓冲，在事件边界 (emit / endl / flush) 打包成一块交给 OutputWriter，由写线程真正 write
+class FdChannel : public SessionChannel {
+public:
+    explicit FdChannel(int fd);
+    ~FdChannel() override;
+
+    std::ostream& out() override { return stream; }
+
+protected:
+    void writeRaw(std::string data) override;
+
+private:
+    int fd;
+    TextBuf outBuf;
+    std::ostream stream;
+};
+
+// 输出收进内存，不写任何 fd (--batch 模式每条指令一个，跑完整体取走)
+class MemoryChannel : public SessionChannel {
+public:
+    MemoryChannel();
+    ~MemoryChannel() override;
+
+    std::ostream& out() override { return stream; }
+
+    // 取走目前为止的全部输出
+    std::string takeOutput();
+    // 每一行输出 (JSON 模式下即每个事件) 写入的时间
+    const std::vector<std::chrono::steady_clock::time_point>& lineTimes() const { return times; }
+
+protected:
+    void writeRaw(std::string data) override;
+
+private:
+    TextBuf outBuf;
+    std::ostream stream;
+    std::string captured;
+    std::vector<std::chrono::steady_clock::time_point> times;
+};
+
+#endif
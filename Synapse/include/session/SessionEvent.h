@@ -0,0 +1,39 @@
+#ifndef SESSION_EVENT_H
+#define SESSION_EVENT_H
+
+#include <string>
+#include <vector>
+
+// 会话对外输出的类型化事件
+// 以前 GUI 靠 "[THINK]" / "[RESULT]" / "[ERROR]" 前缀逐行刮文本，候选列表一长就容易错位；
+// 现在每条输出都是一个事件，文本模式下渲染成原来的样子，JSON 模式下一个事件一行
+enum class EventType {
+    Thinking,   // 推理过程 ([THINK])
+    Prompt,     // 向用户提问，之后会等一行输入
+    Result,     // 操作结果 ([RESULT])
+    Candidates, // 供选择的列表 (路径、删除候选、后缀)，items 里是每一项
+    Progress,   // 搜索、定位、移入回收站、审计等耗时步骤
+    Error,      // 错误 ([ERROR])
+    Info,       // 其余提示；JSON 模式下未分类的裸输出也归到这里
+    Done        // 一条指令处理完毕 (text 为 understood / not_understood)，文本模式下不显示
+};
+
+// 候选列表在文本模式下的排版，照搬改版前各调用点的打印格式
+enum class CandidateLayout {
+    Lines,         // 每项一行 "[i] ..." (路径选择)
+    IndentedLines, // 每项一行 " [i] ..." (删除候选)
+    Inline         // 排在同一行 "[1] a [2] b " (后缀)
+};
+
+struct SessionEvent {
+    EventType type = EventType::Info;
+    std::string text;
+    std::vector<std::string> items;
+    CandidateLayout layout = CandidateLayout::Lines;
+    std::string skip; // 非空时在列表后多一个 [0] 选项 (如 "跳过此文件")
+};
+
+// JSON 里的 type 字段
+const char* eventTypeName(EventType type);
+
+#endif
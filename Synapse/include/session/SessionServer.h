@@ -0,0 +1,51 @@
+#ifndef SESSION_SERVER_H
+#define SESSION_SERVER_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "SharedBrains.h"
+#include "EventLoop.h"
+#include "SessionChannel.h"
+
+// 多会话 daemon：监听 Unix socket，每个连接是一个独立会话
+// - 会话状态 (FileCreator / FileDeleter / JudgmentLogger) 每个连接各一份
+// - 大脑、已收割知识 (few-shot / 纠错记忆 / 分类器) 全进程共用
+// 线程模型 (流水线)：
+//   I/O 线程 poll 所有连接、按行投递 -> 各会话的 Strand (命令队列) -> 工作线程池跑会话协程
+//   -> 输出事件进无锁队列 -> 唯一的写线程 (OutputWriter) 负责所有 write
+class SessionServer {
+public:
+    // protocol：所有连接使用的输出协议 (文本 / JSON-lines)
+    explicit SessionServer(const std::string& socketPath,
+                           SessionChannel::Protocol protocol = SessionChannel::Protocol::Text);
+    ~SessionServer();
+
+    // $XDG_RUNTIME_DIR/synapse.sock，没有则 /tmp/synapse-<uid>.sock
+    static std::string defaultSocketPath();
+
+    // 绑定并监听，失败返回 false (原因打到 stderr)
+    bool start();
+
+    // 接受连接、读输入直到进程退出
+    void run();
+
+    // 瘦客户端：把 stdin 转发给 daemon，把 daemon 的输出转发到 stdout
+    static int runClient(const std::string& socketPath);
+
+private:
+    void onSessionFinished(int fd);
+
+    std::string socketPath;
+    SessionChannel::Protocol protocol;
+    int listenFd = -1;
+    int wakeFd = -1; // eventfd：会话结束时叫醒 I/O 线程去关连接
+    std::shared_ptr<SharedBrains> brains;
+    std::unique_ptr<EventLoop> loop;
+
+    std::mutex finishedMutex;
+    std::vector<int> finishedFds;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef SHARED_BRAINS_H
+#define SHARED_BRAINS_H
+
+#include <memory>
+#include "local_brain.h"
+#include "cloud_brain.h"
+#include "GrokBrain.h"
+
+// 三个大脑只持有配置、每次调用各自建连接，本身无会话状态，
+// 所以一个进程只需要一套：stdin 模式下 Router / FileCreator / FileDeleter 共用，
+// daemon 模式下所有连接共用
+struct SharedBrains {
+    std::shared_ptr<LocalBrain> local;
+    std::shared_ptr<CloudBrain> cloud;
+    std::shared_ptr<GrokBrain> grok;
+
+    static std::shared_ptr<SharedBrains> create() {
+        auto brains = std::make_shared<SharedBrains>();
+        brains->local = std::make_shared<LocalBrain>();
+        brains->cloud = std::make_shared<CloudBrain>();
+        brains->grok  = std::make_shared<GrokBrain>();
+        return brains;
+    }
+};
+
+#endif
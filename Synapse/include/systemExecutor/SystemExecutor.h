@@ -11,26 +11,39 @@
 #include "FileCreator.h"
 #include "FileDeleter.h"
 #include "GrokBrain.h"
+#include "SharedBrains.h"
+#include "Task.h"
 
 class SystemExecutor {
 public:
     SystemExecutor();
+    // daemon 模式：每个会话一个 SystemExecutor，大脑由所有会话共用
+    explicit SystemExecutor(std::shared_ptr<SharedBrains> brains);
     ~SystemExecutor();
 
     // 唯一的入口
-    bool processInput(const std::string& userQuery);
+    // 协程：创建/删除流程里的追问和模型调用都会挂起，直到这一条指令的对话整个结束
+    Task<bool> processInput(std::string userQuery);
+
+    // 交互会话开始时调用一次：打印启动横幅 (安全检查、已加载的修正样本数) 并触发预热
+    // 不放在构造函数里：--batch 每条指令都新建一个 SystemExecutor
+    static void announce(const std::shared_ptr<SharedBrains>& brains);
+
+    // 后台预热本地模型并预填路由 prompt (进程内只跑一次；daemon / --batch 启动时提前调用)
+    // 就绪情况用 brains->local->onWarm 订阅，和 "[System] Ready." 分开报告
+    static void warmUp(const std::shared_ptr<SharedBrains>& brains);
 
 private:
-    std::unique_ptr<LocalBrain> localBrain;
-    std::unique_ptr<CloudBrain> cloudBrain;
-    std::unique_ptr<GrokBrain> grokBrain; // [新增] Grok 大脑
+    std::shared_ptr<LocalBrain> localBrain;
+    std::shared_ptr<CloudBrain> cloudBrain;
+    std::shared_ptr<GrokBrain> grokBrain; // [新增] Grok 大脑
     
     // 特种兵
     std::unique_ptr<FileCreator> fileCreator;
     std::unique_ptr<FileDeleter> fileDeleter;
 
     // ✨✨✨ 补上了这个声明 ✨✨✨
-    std::string loadPrompt(const std::string& filename);
+    static std::string loadPrompt(const std::string& filename);
 };
 
 #endif
\ No newline at end of file
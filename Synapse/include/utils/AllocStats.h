@@ -0,0 +1,20 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <cstdint>
+
+// 进程级的堆分配计数 (替换全局 operator new / delete)
+// 默认关闭，关闭时每次分配只多一次 relaxed load；录制 / 回放时打开，用来比较不同版本的分配次数
+namespace AllocStats {
+
+struct Snapshot {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+void enable();
+Snapshot snapshot();
+
+}
+
+#endif
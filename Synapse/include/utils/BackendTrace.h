@@ -0,0 +1,69 @@
+#ifndef BACKEND_TRACE_H
+#define BACKEND_TRACE_H
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 后端交互的录制 / 回放 (--record FILE / --replay FILE)
+// 模型输出不确定，同一条指令两次跑的路径都可能不同，延迟变化没法归因到代码改动。
+// 录制时把大脑请求/回复、find 搜索结果和用户输入按顺序写进 trace 文件；
+// 回放时不连模型、不跑 find，按类别依次取录下的结果，输入也从 trace 里读，
+// 于是两个版本跑的是同一条路径，可以直接比较 CPU 时间和内存分配次数。
+//
+// 文件格式 (JSON Lines)，请求只存 FNV-1a 哈希，用来发现提示词改动导致的不匹配：
+//   {"synapse_trace":1}
+//   {"k":"local","h":"6b1f...","ms":812.4,"r":"CREATE"}
+//   {"k":"input","r":"在桌面建个 a.txt"}
+// 线程安全：调用来自多个阻塞线程 (审计和会话并发)，同一类别内按录制顺序取
+class BackendTrace {
+public:
+    static BackendTrace& instance();
+
+    bool startRecording(const std::string& path);
+    // keepTiming：每次调用按录下的耗时睡眠，墙钟时间和原始会话可比
+    bool loadReplay(const std::string& path, bool keepTiming);
+
+    bool recording() const { return mode == Mode::Record; }
+    bool replaying() const { return mode == Mode::Replay; }
+
+    // 所有后端调用都从这里过：关闭时直接执行 live；录制时执行并记下结果；回放时返回录下的结果
+    std::string call(const char* kind, const std::string& request, const std::function<std::string()>& live);
+
+    void recordInput(const std::string& line);
+    // 回放时按顺序交给会话的用户输入
+    std::vector<std::string> recordedInputs() const;
+
+    // 录制 / 回放统计：调用数、请求不匹配数、trace 里缺的调用数
+    void report(std::ostream& out) const;
+
+private:
+    enum class Mode { Off, Record, Replay };
+
+    struct Entry {
+        uint64_t hash = 0;
+        double ms = 0;
+        std::string response;
+    };
+
+    BackendTrace() = default;
+    void writeLine(const std::string& line);
+
+    Mode mode = Mode::Off;
+    bool keepTiming = false;
+    mutable std::mutex mtx;
+    std::ofstream out;
+    std::map<std::string, std::deque<Entry>> pending; // 回放：按类别排队
+    std::vector<std::string> inputs;
+    std::map<std::string, size_t> calls;
+    size_t mismatches = 0;
+    size_t missing = 0;
+};
+
+#endif
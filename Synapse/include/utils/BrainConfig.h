@@ -0,0 +1,59 @@
+#ifndef BRAIN_CONFIG_H
+#define BRAIN_CONFIG_H
+
+#include <string>
+#include <vector>
+
+struct CallMetrics;
+
+// 模型端点配置
+// 默认值就是原来写死在各个 Brain 里的地址；用环境变量覆盖，方便指向本地 mock 做离线压测：
+//   SYNAPSE_OLLAMA_URL / SYNAPSE_OLLAMA_MODEL / SYNAPSE_OLLAMA_KEEP_ALIVE (模型空闲多久后卸载，默认 30m)
+//   SYNAPSE_DEEPSEEK_URL / SYNAPSE_DEEPSEEK_MODEL / SYNAPSE_DEEPSEEK_KEY
+//   SYNAPSE_GROK_URL / SYNAPSE_GROK_MODEL / SYNAPSE_GROK_KEY
+//   SYNAPSE_MOCK_LLM=http://127.0.0.1:11500  一次把三个大脑都指向 synapse_mock_llm
+// 单项变量优先于 SYNAPSE_MOCK_LLM
+struct BrainEndpoint {
+    std::string url;
+    std::string model;
+    std::string apiKey;
+    std::string keepAlive; // 只有 Ollama 用
+};
+
+// 按任务的模型和生成参数
+// 路由只要从三个词里选一个，抽取只要一行结果；以前所有本地调用都用同一个模型和默认参数，
+// 小模型偶尔停不下来，把 few-shot 样例接着往下编，白白多生成几十个 token。
+// 任务：local 的 router / create / delete，cloud 的 suggest (OTHER 意图下生成建议命令)
+// 环境变量 (PREFIX 同上，TASK 为任务名大写，如 SYNAPSE_OLLAMA_ROUTER_MODEL)：
+//   SYNAPSE_<PREFIX>_<TASK>_MODEL        模型，默认同 SYNAPSE_<PREFIX>_MODEL (可以给路由换更小的量化模型)
+//   SYNAPSE_<PREFIX>_<TASK>_NUM_PREDICT  最多生成的 token 数 (OpenAI 兼容接口为 max_tokens)，0 表示不限
+//   SYNAPSE_<PREFIX>_<TASK>_STOP         停止序列，多个用 ';' 分隔，"\n" 表示换行，none 表示不设
+//   SYNAPSE_<PREFIX>_<TASK>_TEMPERATURE  温度
+//   SYNAPSE_<PREFIX>_<TASK>_NUM_CTX      上下文长度，0 表示用模型默认 (只有 Ollama 用；同一模型 num_ctx 不同会触发重新加载)
+struct ModelProfile {
+    std::string task;
+    std::string model;
+    int numPredict = 0;
+    std::vector<std::string> stop;
+    double temperature = -1; // < 0 表示不传，用后端默认
+    int numCtx = 0;
+    // synapse_task_*{task, model}，profile() 里注册一次，调用路径上直接用
+    const CallMetrics* metrics = nullptr;
+};
+
+namespace BrainConfig {
+
+BrainEndpoint local();  // Ollama /api/generate
+BrainEndpoint cloud();  // DeepSeek /chat/completions
+BrainEndpoint grok();   // 灵芽 (OpenAI 兼容) /chat/completions
+
+// provider 名 (local / cloud / grok) 对应的环境变量前缀 SYNAPSE_OLLAMA / SYNAPSE_DEEPSEEK / SYNAPSE_GROK
+std::string envPrefix(const std::string& provider);
+// 任务的生成参数：内置默认值 + 环境变量覆盖，未知任务只有模型名
+ModelProfile profile(const std::string& provider, const std::string& task);
+// 读数值型环境变量，没设、解析失败或为负数时返回 fallback
+double envNumber(const std::string& name, double fallback);
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef JSON_UTIL_H
+#define JSON_UTIL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 轻量 JSON 工具：项目里不引第三方 JSON 库，只做够用的转义和取值
+namespace JsonUtil {
+
+// 转义为 JSON 字符串内容 (不含两侧引号)，控制字符输出 \uXXXX
+std::string escape(std::string_view input);
+
+// 在 json 中查找 "key": "value" 并反转义 value (含 \uXXXX -> UTF-8)
+// key 存在且值为 null 时返回 true，isNull 置为 true
+bool extractString(std::string_view json, std::string_view key, std::string& out, bool* isNull = nullptr);
+
+// 在 json 中查找 "key": ["a", "b", ...]，只支持字符串数组
+bool extractStringArray(std::string_view json, std::string_view key, std::vector<std::string>& out);
+
+// 从 pos 开始找第一个完整的 {...} 对象 (识别字符串里的括号)，找不到返回空
+std::string_view findObject(std::string_view text, size_t pos = 0);
+
+}
+
+#endif
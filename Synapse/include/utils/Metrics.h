@@ -0,0 +1,122 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+// 进程内指标：计数器、仪表、延迟直方图
+// 原来唯一的信号是控制台上的 emoji 输出；现在大脑调用、搜索、安全判定、审计、回收站操作都有计数和延迟分布。
+// - 热路径只有 relaxed 原子加，不加锁；注册 (按名字 + 标签查表) 要加锁，调用方用函数内 static 引用缓存
+// - daemon 模式经 MetricsServer 以 Prometheus 文本格式暴露，stdin 模式退出时打一份摘要到 stderr
+//
+//   static Histogram& latency = Metrics::instance().histogram("synapse_brain_latency_seconds",
+//                                                             "大脑调用耗时", "brain=\"local\"");
+//   LatencyTimer timer(latency);
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+class Gauge {
+public:
+    void add(int64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+    void set(int64_t n) { value.store(n, std::memory_order_relaxed); }
+    int64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> value{0};
+};
+
+// HDR 风格的对数-线性直方图，单位微秒：每个 2 的幂区间再分 8 格，相对误差 < 12.5%
+// 覆盖 1 µs 到约 12 天，固定 320 个原子桶，记录 O(1)
+class Histogram {
+public:
+    static constexpr int SUB_BUCKETS = 8;
+    static constexpr int BUCKETS = 320;
+
+    void record(uint64_t micros);
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sumMicros() const { return sum.load(std::memory_order_relaxed); }
+    // q ∈ [0, 1]，返回所在桶的上界 (微秒)；没有数据返回 0
+    uint64_t percentile(double q) const;
+    // 小于 bound 微秒的样本数 (bound 取 2 的幂时和桶边界对齐，是精确的)
+    uint64_t countBelow(uint64_t bound) const;
+
+    static int bucketOf(uint64_t micros);
+    static uint64_t upperBound(int bucket);
+
+private:
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+};
+
+// RAII：析构时把经过的时间记进直方图
+class LatencyTimer {
+public:
+    explicit LatencyTimer(Histogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    ~LatencyTimer() {
+        histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    LatencyTimer(const LatencyTimer&) = delete;
+    LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// 一类远程调用的三件套 (次数、失败数、耗时)，名字为 <prefix>_requests_total / _errors_total / _latency_seconds
+struct CallMetrics {
+    Counter& calls;
+    Counter& errors;
+    Histogram& latency;
+
+    static CallMetrics make(const std::string& prefix, const std::string& labels);
+};
+
+class Metrics {
+public:
+    static Metrics& instance();
+
+    // labels 是写好的 Prometheus 标签，如 brain="local",result="ok"；同名同标签返回同一个对象 (地址不变)
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    // Prometheus 文本格式 (version 0.0.4)
+    void writePrometheus(std::ostream& out) const;
+    // 给人看的摘要：只列非零的项，直方图给 p50 / p90 / p99
+    void writeSummary(std::ostream& out) const;
+
+private:
+    Metrics() = default;
+
+    enum class Kind { Counter, Gauge, Histogram };
+    struct Family {
+        Kind kind;
+        std::string help;
+        // 标签 -> 对象；unique_ptr 保证注册后地址不变
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    Family& family(const std::string& name, const std::string& help, Kind kind);
+
+    mutable std::mutex mtx;
+    std::map<std::string, Family> families;
+};
+
+#endif
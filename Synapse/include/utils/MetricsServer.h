@@ -0,0 +1,25 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <string>
+
+// daemon 模式的指标抓取端点：极简 HTTP/1.0，任何 GET 都返回 Metrics 的 Prometheus 文本
+// listen 是纯数字时监听 127.0.0.1:<端口>，否则当成 Unix socket 路径 (curl --unix-socket PATH http://x/metrics)
+// 一个后台线程串行处理，抓取频率很低，不值得并发
+class MetricsServer {
+public:
+    explicit MetricsServer(const std::string& listen);
+    ~MetricsServer();
+
+    // 绑定并起后台线程，失败返回 false (原因打到 stderr)
+    bool start();
+
+private:
+    void serve();
+
+    std::string listenSpec;
+    int listenFd = -1;
+    bool unixSocket = false;
+};
+
+#endif
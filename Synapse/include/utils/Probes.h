@@ -0,0 +1,35 @@
+#ifndef SYNAPSE_PROBES_H
+#define SYNAPSE_PROBES_H
+
+// USDT 静态探针 (provider 为 synapse)，bpftrace / perf 不用重新编译就能挂到内部事件上
+// 没挂探针时每个点只是一条 nop，参数只在寄存器里，不做任何额外计算；示例脚本见 tools/bpftrace/
+//
+// 有 <sys/sdt.h> (systemtap-sdt-dev / systemtap-sdt-devel) 时才真正生成探针，
+// 没有或 -DSYNAPSE_ENABLE_SDT=OFF 时宏展开为空，参数不求值
+//
+// 探针一览 (entry / return 成对)：
+//   local_talk_entry(prompt_bytes)              local_talk_return(reply_bytes, failed)
+//   cloud_think_entry(prompt_bytes)             cloud_think_return(reply_bytes, failed)
+//   grok_request_entry(body_bytes)              grok_request_return(reply_bytes, curl_code)
+//   security_check_entry(cmd, cmd_bytes)        security_check_return(allowed, reason)
+//   search_dirs_entry(keyword, root)            search_dirs_return(candidates)
+//   search_files_entry(filename, root)          search_files_return(candidates)
+//   trash_move_entry(path)                      trash_move_return(ok, path)
+// 字符串参数是 const char*，bpftrace 里用 str(argN) 读
+
+#if !defined(SYNAPSE_DISABLE_SDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SYNAPSE_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef SYNAPSE_HAVE_SDT
+#define SYNAPSE_PROBE1(name, a) DTRACE_PROBE1(synapse, name, a)
+#define SYNAPSE_PROBE2(name, a, b) DTRACE_PROBE2(synapse, name, a, b)
+#else
+#define SYNAPSE_PROBE1(name, a) do {} while (0)
+#define SYNAPSE_PROBE2(name, a, b) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 在途请求合并 (singleflight)
+// daemon / --batch 下很多会话会同一时刻发出一字不差的 prompt (同样的路由 prompt、同样的 Grok 仲裁)。
+// 同一个大脑上已有相同 prompt 的请求在途时，后来者直接等它的结果，不再发一次 HTTP。
+// 只合并 "同时在途" 的请求，结果不缓存：前一个请求返回之后再来的照常发送。
+// 省下的调用数记在 synapse_brain_coalesced_total{brain=...}；SYNAPSE_SINGLEFLIGHT=0 关闭
+class SingleFlight {
+public:
+    static SingleFlight& instance();
+
+    // kind 是大脑名 (local / cloud / grok)，key 是完整 prompt；fn 只在没有相同请求在途时才执行
+    std::string run(const std::string& kind, const std::string& key, const std::function<std::string()>& fn);
+
+private:
+    SingleFlight();
+
+    bool enabled = true;
+    std::mutex mtx;
+    // kind + '\0' + key -> 在途请求的结果
+    std::unordered_map<std::string, std::shared_future<std::string>> inFlight;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// 进程内的阶段耗时追踪 (span)，导出为 Chrome / Perfetto 的 trace JSON
+// 一条指令跑了 40 s，要能看出时间花在路由模型、Grok 仲裁、find、等用户回答还是 DeepSeek 审计上。
+//
+// - 记录进固定大小的环形缓冲 (默认 65536 条，写满后覆盖最旧的)，不加锁、不分配内存，
+//   每个 span 的开销是两次读时钟加一次原子自增，生产环境常开 (SYNAPSE_TRACE=0 关闭)
+// - 名字和类别必须是字符串字面量 (只存指针)
+// - 每个会话一条轨道：同一会话的阶段在协程里顺序执行，跨线程 (offload) 也能正确嵌套
+// - 按需导出：kill -USR1 <pid> 写到 --trace-out 指定的文件 (默认 synapse_trace_<pid>.json)，
+//   stdin / --batch 模式退出时也会写一次
+class Tracer {
+public:
+    static Tracer& instance();
+
+    bool enabled() const { return on.load(std::memory_order_relaxed); }
+    void setEnabled(bool value) { on.store(value, std::memory_order_relaxed); }
+
+    static uint64_t nowNs();
+
+    // argName 为空表示没有参数
+    void record(const char* category, const char* name, uint64_t startNs, uint64_t endNs,
+                const char* argName = nullptr, int64_t argValue = 0);
+
+    // 当前缓冲里的全部 span，写成 {"traceEvents":[...]}；可以和记录并发
+    void writeChromeJson(std::ostream& out) const;
+    bool writeChromeJson(const std::string& path) const;
+
+    // 后台线程等 SIGUSR1，收到就导出到 path；必须在起任何其他线程之前调用 (要先屏蔽信号)
+    void installDumpSignal(const std::string& path);
+
+private:
+    Tracer();
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0}; // 写入中为奇数，写完为 2 * (序号 + 1)
+        const char* category = nullptr;
+        const char* name = nullptr;
+        const char* argName = nullptr;
+        int64_t argValue = 0;
+        uint64_t startNs = 0;
+        uint64_t durNs = 0;
+        uint64_t session = 0;
+        uint32_t thread = 0;
+    };
+
+    static constexpr size_t CAPACITY = 1 << 16;
+
+    std::atomic<bool> on{true};
+    std::atomic<uint64_t> head{0};
+    std::unique_ptr<Slot[]> slots;
+    uint64_t originNs;
+};
+
+// RAII：构造时记开始，析构时写入环形缓冲
+//   TraceSpan span("brain", "local.talk");
+//   span.arg("bytes", prompt.size());
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name)
+        : category(category), name(name), startNs(Tracer::instance().enabled() ? Tracer::nowNs() : 0) {}
+    ~TraceSpan() {
+        if (startNs) Tracer::instance().record(category, name, startNs, Tracer::nowNs(), argName, argValue);
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void arg(const char* key, int64_t value) {
+        argName = key;
+        argValue = value;
+    }
+
+private:
+    const char* category;
+    const char* name;
+    uint64_t startNs;
+    const char* argName = nullptr;
+    int64_t argValue = 0;
+};
+
+#endif
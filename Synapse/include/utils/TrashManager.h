@@ -27,6 +27,10 @@ private:
     // 历史记录栈（后进先出，实现 Undo）
     std::vector<DeleteRecord> historyStack;
 
+    // 实际的移动 / 恢复；公开接口在外面计数
+    std::pair<bool, std::string> moveToTrashImpl(const std::string& originalPath);
+    std::pair<bool, std::string> undoLastDeleteImpl();
+
     std::string getTimestamp();
     std::string getHomeDir();
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef USAGE_LEDGER_H
+#define USAGE_LEDGER_H
+
+#include <cstdint>
+#include "Metrics.h"
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// 模型调用账本：按 provider (local / cloud / grok，和 BackendTrace、指标里的名字一致) 记 token、请求数和估算费用，并执行限额
+// 以前每个会话的 DeepSeek 审计和 Grok 仲裁都不记账，压测时悄悄烧钱、撞上游限速。
+// - 用量取自响应的 usage 字段 (OpenAI 兼容: prompt_tokens / completion_tokens；Ollama: prompt_eval_count / eval_count)
+//   只记真实请求，回放不计
+// - 超限不排队等额度：tryAcquire 返回 false，调用方自己降级 (审计延后、跳过 Grok 仲裁)，会话不卡住
+//
+// 配置 (PREFIX 为 DEEPSEEK / GROK)，不设或为 0 表示不限。本地 Ollama 只记账不限额：不花钱，并发由 BackendScheduler 管
+//   SYNAPSE_<PREFIX>_RPM           每分钟请求数 (令牌桶，最多攒一分钟的量)
+//   SYNAPSE_<PREFIX>_TPM           每分钟 token 数 (调用后按实际用量扣，可透支，透支期间拒绝)
+//   SYNAPSE_<PREFIX>_DAILY_TOKENS  每日 token 上限 (本地时间零点清零)
+//   SYNAPSE_<PREFIX>_DAILY_USD     每日估算费用上限 (美元)
+//   SYNAPSE_<PREFIX>_PRICE_IN / SYNAPSE_<PREFIX>_PRICE_OUT  每百万输入 / 输出 token 的美元价，默认是公开价
+struct TokenUsage {
+    uint64_t prompt = 0;
+    uint64_t completion = 0;
+};
+
+class UsageLedger {
+public:
+    static UsageLedger& instance();
+
+    // 从响应 JSON 里取用量，两种字段都没有返回 false
+    static bool parseUsage(std::string_view json, TokenUsage& usage);
+
+    // 发请求前申请额度；成功时占掉一个请求令牌，失败时 reason 写超了哪一项 (rpm / tpm / daily_tokens / daily_usd)
+    bool tryAcquire(const std::string& provider, std::string* reason = nullptr);
+    // 请求完成后记账 (TPM 桶、日累计、指标)
+    void record(const std::string& provider, const TokenUsage& usage);
+    // 便捷版：解析 json 里的用量再记账，没有 usage 字段时只记一次请求
+    void recordResponse(const std::string& provider, std::string_view json);
+
+    // 给人看的摘要：每个 provider 今天的请求数、token、估算费用和被拒次数
+    void writeSummary(std::ostream& out) const;
+
+private:
+    UsageLedger();
+
+    struct Limits {
+        double rpm = 0, tpm = 0, dailyTokens = 0, dailyUsd = 0;
+        double priceIn = 0, priceOut = 0; // 美元 / 百万 token
+    };
+    struct Account {
+        std::string name;
+        Limits limits;
+        double requestTokens = 0; // RPM 桶
+        double tokenBudget = 0;   // TPM 桶，可为负
+        int64_t refilledAtNs = 0;
+        int day = -1;             // 本地日期 (year * 1000 + yday)
+        uint64_t requests = 0, promptTokens = 0, completionTokens = 0, denied = 0;
+        double usd = 0;
+        // 指标对象在构造时注册好，记账路径上不再查表
+        Counter* requestCounter = nullptr;
+        Counter* promptCounter = nullptr;
+        Counter* completionCounter = nullptr;
+        Counter* costCounter = nullptr;
+        Counter* denials[4] = {}; // 顺序同 DENIAL_REASONS
+    };
+
+    Account* find(const std::string& provider);
+    void refill(Account& account, int64_t nowNs);
+
+    mutable std::mutex mtx;
+    Account accounts[3];
+};
+
+#endif
@@ -1,4 +1,12 @@
 #include "cloud_brain.h"
+#include "SessionChannel.h"
+#include "BrainConfig.h"
+#include "BackendTrace.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Probes.h"
+#include "UsageLedger.h"
+#include "SingleFlight.h"
 #include <iostream>
 #include <fstream>
 #include <sstream> // ✨ 必须引入，用于读取文件流
@@ -7,10 +15,16 @@
 #include <cstdio>
 #include <filesystem> // 用于路径检查
 #include <vector>
+#include <cstdlib>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
 CloudBrain::CloudBrain() {
+    BrainEndpoint endpoint = BrainConfig::cloud();
+    apiKey = endpoint.apiKey;
+    apiUrl = endpoint.url;
+    modelName = endpoint.model;
     // std::cout << "[System] Cloud Brain (DeepSeek) Initialized." << std::endl;
 }
 
@@ -38,45 +52,94 @@ std::string CloudBrain::loadPromptTemplate(const std::string& filename) {
     return ""; // 返回空字符串表示失败
 }
 
-std::string CloudBrain::think(const std::string& query) {
-    if (apiKey.empty() || apiKey.find("sk-") == std::string::npos) {
+std::string CloudBrain::think(const std::string& query, const ModelProfile* profile) {
+    BackendTrace& trace = BackendTrace::instance();
+    static CallMetrics metrics = CallMetrics::make("synapse_brain", "brain=\"cloud\"");
+    metrics.calls.inc();
+    SYNAPSE_PROBE1(cloud_think_entry, query.size());
+    // 回放不连 DeepSeek，不需要 Key
+    if (!trace.replaying() && (apiKey.empty() || apiKey.find("sk-") == std::string::npos)) {
+        metrics.errors.inc();
+        SYNAPSE_PROBE2(cloud_think_return, 0, true);
         return "[Config Error] Please set your DeepSeek API Key in src/cloud/cloud_brain.h or .cpp";
     }
 
-    std::cout << ">>> [DeepSeek] Thinking..." << std::endl;
+    sessionEvent(EventType::Progress) << ">>> [DeepSeek] Thinking...";
+    TraceSpan span("brain", "cloud.think");
+    span.arg("prompt_bytes", query.size());
+    // 没指定任务的调用就是审计 (evaluateLog)
+    static const ModelProfile audit = BrainConfig::profile("cloud", "audit");
+    if (!profile) profile = &audit;
+    const CallMetrics& taskMetrics = *profile->metrics;
+    taskMetrics.calls.inc();
+    std::string response;
+    {
+        LatencyTimer timer(metrics.latency);
+        LatencyTimer taskTimer(taskMetrics.latency);
+        std::string key = profile->model + "\n" + query;
+        response = trace.call("cloud", query, [&] {
+            return SingleFlight::instance().run("cloud", key, [&] { return request(query, *profile); });
+        });
+    }
+    bool failed = response.rfind("[Error", 0) == 0;
+    if (failed) {
+        metrics.errors.inc();
+        taskMetrics.errors.inc();
+    }
+    SYNAPSE_PROBE2(cloud_think_return, response.size(), failed);
+    return response;
+}
 
+std::string CloudBrain::request(const std::string& query, const ModelProfile& profile) {
     std::string safeQuery = jsonEscape(query);
     
-    // 1. 构造 JSON 内容
+    // 1. 构造 JSON 内容 (profile 里没设的生成参数不传)
+    std::string options;
+    if (profile.numPredict > 0) options += ",\"max_tokens\": " + std::to_string(profile.numPredict);
+    if (profile.temperature >= 0) {
+        std::ostringstream temperature;
+        temperature << profile.temperature;
+        options += ",\"temperature\": " + temperature.str();
+    }
+    if (!profile.stop.empty()) {
+        std::string stop;
+        for (const auto& s : profile.stop) stop += (stop.empty() ? "\"" : ", \"") + jsonEscape(s) + "\"";
+        options += ",\"stop\": [" + stop + "]";
+    }
     std::string jsonBody = "{"
-        "\"model\": \"" + modelName + "\","
+        "\"model\": \"" + profile.model + "\","
         "\"messages\": [{\"role\": \"user\", \"content\": \"" + safeQuery + "\"}],"
-        "\"stream\": false"
+        "\"stream\": false" + options +
     "}";
 
     // 2. 将 JSON 写入临时文件 (解决 Shell 特殊字符问题)
-    std::string tempFileName = "deepseek_request.json";
-    std::ofstream file(tempFileName);
-    if (file.is_open()) {
-        file << jsonBody;
-        file.close();
-    } else {
+    //    daemon 模式下多个会话会同时调用，文件名必须唯一
+    std::string tempFileName = (fs::temp_directory_path() / "synapse_deepseek_XXXXXX").string();
+    int fd = mkstemp(&tempFileName[0]);
+    if (fd < 0) {
+        return "[Error] Failed to create temporary request file.";
+    }
+    bool written = ::write(fd, jsonBody.data(), jsonBody.size()) == static_cast<ssize_t>(jsonBody.size());
+    ::close(fd);
+    if (!written) {
+        remove(tempFileName.c_str());
         return "[Error] Failed to create temporary request file.";
     }
 
     // 3. 构造 curl 命令
     // 使用 @符号读取文件，避免命令行长度限制
-    std::string cmd = "curl -s -X POST " + apiUrl + 
+    std::string cmd = "curl -s -X POST \"" + apiUrl + "\"" +
                       " -H \"Content-Type: application/json\"" +
                       " -H \"Authorization: Bearer " + apiKey + "\"" +
                       " -d @" + tempFileName; 
 
     std::string rawJson = executeCurl(cmd);
     
-    // 清理临时文件 (调试时可注释掉)
-    // remove(tempFileName.c_str());
+    // 清理临时文件 (文件名每次都不同，不删会越积越多)
+    remove(tempFileName.c_str());
 
     if (rawJson.empty()) return "[Error] Network failure connecting to DeepSeek.";
+    UsageLedger::instance().recordResponse("cloud", rawJson);
 
     return extractContent(rawJson);
 }
@@ -0,0 +1,385 @@
+#include "CommandGrammar.h"
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+
+using namespace std;
+
+// ==========================================
+// 词表
+// ==========================================
+
+namespace {
+
+template <size_t N>
+using Words = string_view[N];
+
+// 说出来的位置 -> 槽位里的 Path
+struct Place {
+    string_view spoken;
+    string_view slot;
+};
+
+const Words<28> STEMS = {
+    "report", "backup", "notes", "main", "config", "todo", "data", "test", "draft", "summary",
+    "budget", "plan", "readme", "app", "utils", "schema", "syslog", "error", "db_backup", "auth",
+    "会议记录", "周报", "简历", "通知", "笔记", "预算", "草稿", "方案",
+};
+const Words<13> EXTS = {".txt", ".md", ".py", ".cpp", ".json", ".log", ".docx", ".xlsx", ".sh", ".yaml", ".csv", ".bak", ".js"};
+
+const Place PLACES_ZH[] = {
+    {"桌面", "桌面"}, {"下载", "下载"}, {"文档", "文档"}, {"/tmp", "/tmp"}, {"/var/log", "/var/log"},
+    {"~/Documents", "~/Documents"}, {"project 目录", "project"}, {"src 文件夹", "src"}, {"Desktop", "Desktop"},
+    {"~/workspace/dev", "~/workspace/dev"}, {"backup 目录", "backup"}, {"/etc/conf", "/etc/conf"},
+};
+const Place PLACES_EN[] = {
+    {"the desktop", "desktop"}, {"Downloads", "Downloads"}, {"/tmp", "/tmp"}, {"/var/log", "/var/log"},
+    {"my documents folder", "Documents"}, {"the project folder", "project"}, {"~/Documents", "~/Documents"},
+    {"the src directory", "src"}, {"~/workspace/dev", "~/workspace/dev"}, {"/etc/conf", "/etc/conf"},
+};
+
+const Words<8> PREFIX_ZH = {"", "", "", "帮我", "请", "麻烦", "给我", "能不能"};
+const Words<6> PREFIX_EN = {"", "", "please ", "can you ", "hey, ", "could you "};
+
+// FileCreator 靠这几个字判定创建：创建 / 建 / 搞 / 弄 / 整
+const Words<8> VERB_ZH = {"创建", "新建", "建", "建立", "搞", "弄", "整", "新建"};
+const Words<6> VERB_EN = {"create", "make", "new", "generate", "add", "touch"};
+const Words<6> TOPIC_ZH = {"文件", "文本文件", "python脚本", "日志文件", "文档", "配置文件"};
+const Words<4> TOPIC_EN = {"files", "text files", "new files", "empty files"};
+
+const Words<7> DELETE_ZH = {"删除", "删掉", "帮我删了", "移除", "清理掉", "干掉", "删了"};
+const Words<6> DELETE_EN = {"delete", "remove", "rm", "trash", "get rid of", "erase"};
+
+const Words<10> OTHER_ZH = {
+    "今天天气怎么样", "刚才的文件弄好了吗", "查看一下磁盘空间", "列出当前目录", "现在几点了",
+    "帮我查一下内存占用", "你是谁", "打开浏览器", "这个目录下有什么", "重启一下网络",
+};
+const Words<8> OTHER_EN = {
+    "what's the weather like", "list files in /tmp", "show disk usage", "what time is it",
+    "who are you", "open the browser", "how much memory is free", "ping google.com",
+};
+
+const Words<11> DIGITS_ZH = {"零", "一", "二", "三", "四", "五", "六", "七", "八", "九", "十"};
+const Words<21> NUMBERS_EN = {
+    "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine", "ten",
+    "eleven", "twelve", "thirteen", "fourteen", "fifteen", "sixteen", "seventeen", "eighteen", "nineteen", "twenty",
+};
+
+template <size_t N>
+constexpr size_t countOf(const Words<N>&) { return N; }
+
+void appendInt(string& s, unsigned value) {
+    char buf[16];
+    auto res = to_chars(buf, buf + sizeof(buf), value);
+    s.append(buf, res.ptr);
+}
+
+// 2 -> 两 / 二，12 -> 十二，20 -> 二十 (只需要 1..99)
+void appendChineseNumber(string& s, unsigned value, bool liang) {
+    if (value == 2 && liang) {
+        s += "两";
+        return;
+    }
+    if (value < 10) {
+        s += DIGITS_ZH[value];
+        return;
+    }
+    if (value >= 20) s += DIGITS_ZH[value / 10];
+    s += "十";
+    if (value % 10) s += DIGITS_ZH[value % 10];
+}
+
+} // namespace
+
+// ==========================================
+// 生成器
+// ==========================================
+
+CommandGrammar::CommandGrammar() : CommandGrammar(Options()) {}
+
+CommandGrammar::CommandGrammar(const Options& opts) : options(opts), state(opts.seed) {
+    auto toThreshold = [](double ratio) {
+        if (ratio <= 0) return 0u;
+        if (ratio >= 1) return 1000u;
+        return static_cast<uint32_t>(ratio * 1000);
+    };
+    otherThreshold = toThreshold(options.otherRatio);
+    deleteThreshold = min(1000u, otherThreshold + toThreshold(options.deleteRatio));
+}
+
+bool CommandGrammar::parseLanguage(string_view name, Language& out) {
+    if (name == "zh") out = Language::Chinese;
+    else if (name == "en") out = Language::English;
+    else if (name == "mix" || name == "mixed") out = Language::Mixed;
+    else return false;
+    return true;
+}
+
+// splitmix64：一次乘加移位，序列只由种子决定
+uint64_t CommandGrammar::rand64() {
+    uint64_t x = (state += 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+void CommandGrammar::next(SyntheticCommand& out) {
+    out.text.clear();
+    out.slots.clear();
+
+    bool english = options.language == Language::English ||
+                   (options.language == Language::Mixed && chance(30));
+    out.lang = english ? "en" : "zh";
+
+    uint32_t roll = below(1000);
+    if (roll < otherThreshold) other(out, english);
+    else if (roll < deleteThreshold) english ? deleteEnglish(out) : deleteChinese(out);
+    else english ? createEnglish(out) : createChinese(out);
+}
+
+void CommandGrammar::appendName(string& text, string* slots, bool english, bool forceExt) {
+    size_t start = text.size();
+    // 英文句子里少用中文名，但也不排除
+    text += STEMS[english && chance(80) ? below(20) : below(countOf(STEMS))];
+    if (chance(35)) {
+        text += chance(50) ? "_" : "";
+        appendInt(text, chance(30) ? 2020 + below(7) : below(100));
+    }
+    if (forceExt || chance(60)) text += EXTS[below(countOf(EXTS))];
+    if (slots) slots->append(text, start, string::npos);
+}
+
+// [前缀][在{位置}]{动词}[数量个]{对象}[，放到{位置}]
+void CommandGrammar::createChinese(SyntheticCommand& out) {
+    string& t = out.text;
+    string& s = out.slots;
+    out.intent = "CREATE";
+
+    const Place* place = chance(55) ? &PLACES_ZH[below(size(PLACES_ZH))] : nullptr;
+    bool placeFirst = place && chance(65);
+
+    t += PREFIX_ZH[below(countOf(PREFIX_ZH))];
+    if (placeFirst) {
+        t += "在";
+        t += place->spoken;
+        t += chance(50) ? "下" : (chance(50) ? "里" : "");
+    }
+    t += VERB_ZH[below(countOf(VERB_ZH))];
+
+    unsigned quantity = 0;
+    switch (below(4)) {
+        case 0: { // 不给名字：建3个文件 / 创建文件
+            if (chance(75)) {
+                quantity = 1 + below(chance(70) ? 9 : 20);
+                if (chance(50)) appendInt(t, quantity);
+                else appendChineseNumber(t, quantity, true);
+                t += "个";
+            }
+            t += TOPIC_ZH[below(countOf(TOPIC_ZH))];
+            s += "NULL";
+            break;
+        }
+        case 1: { // 一个名字：搞个 a.txt / 建一个叫 a 的文件
+            quantity = 1;
+            uint32_t form = below(3);
+            t += chance(50) ? "个" : "一个";
+            if (form == 0) t += " ";
+            else t += form == 1 ? "叫 " : "名为 ";
+            appendName(t, &s, false, false);
+            if (form != 0) t += " 的文件";
+            break;
+        }
+        case 2: { // 同名多份：弄三个名为 report 的文件
+            quantity = 2 + below(9);
+            if (chance(50)) appendInt(t, quantity);
+            else appendChineseNumber(t, quantity, true);
+            t += chance(50) ? "个名为 " : "个叫 ";
+            appendName(t, &s, false, false);
+            t += " 的文件";
+            break;
+        }
+        default: { // 列举：建 a.txt 和 b.md
+            quantity = 2 + (chance(30) ? 1 : 0);
+            t += " ";
+            for (unsigned i = 0; i < quantity; ++i) {
+                if (i > 0) {
+                    s += ",";
+                    t += (i + 1 == quantity) ? " 和 " : "、";
+                }
+                appendName(t, &s, false, false);
+            }
+            break;
+        }
+    }
+
+    if (place && !placeFirst) {
+        t += chance(50) ? "，放到" : "，放在";
+        t += place->spoken;
+        if (place->slot == "桌面" && chance(50)) t += "上";
+    }
+
+    s += "|";
+    appendInt(s, quantity);
+    s += "|";
+    s += place ? place->slot : "NULL";
+}
+
+// [前缀]{动词} {对象}[ in {位置}]
+void CommandGrammar::createEnglish(SyntheticCommand& out) {
+    string& t = out.text;
+    string& s = out.slots;
+    out.intent = "CREATE";
+
+    const Place* place = chance(55) ? &PLACES_EN[below(size(PLACES_EN))] : nullptr;
+    t += PREFIX_EN[below(countOf(PREFIX_EN))];
+    t += VERB_EN[below(countOf(VERB_EN))];
+    t += " ";
+
+    unsigned quantity = 0;
+    switch (below(4)) {
+        case 0: { // create 3 files / create a file
+            quantity = chance(30) ? 1 : 2 + below(19);
+            if (quantity == 1) t += chance(50) ? "a file" : "a new file";
+            else {
+                if (chance(50)) appendInt(t, quantity);
+                else t += NUMBERS_EN[quantity];
+                t += " ";
+                t += TOPIC_EN[below(countOf(TOPIC_EN))];
+            }
+            s += "NULL";
+            break;
+        }
+        case 1: { // create a file named x / touch x.txt
+            quantity = 1;
+            uint32_t form = below(3);
+            if (form == 1) t += "a file named ";
+            else if (form == 2) t += "a file called ";
+            appendName(t, &s, true, form == 0);
+            break;
+        }
+        case 2: { // make three files named report
+            quantity = 2 + below(9);
+            if (chance(50)) appendInt(t, quantity);
+            else t += NUMBERS_EN[quantity];
+            t += chance(50) ? " files named " : " files called ";
+            appendName(t, &s, true, false);
+            break;
+        }
+        default: { // create a.txt and b.md
+            quantity = 2 + (chance(30) ? 1 : 0);
+            for (unsigned i = 0; i < quantity; ++i) {
+                if (i > 0) {
+                    s += ",";
+                    t += (i + 1 == quantity) ? " and " : ", ";
+                }
+                appendName(t, &s, true, true);
+            }
+            break;
+        }
+    }
+
+    if (place) {
+        t += chance(50) ? " in " : (chance(50) ? " on " : " under ");
+        t += place->spoken;
+    }
+
+    s += "|";
+    appendInt(s, quantity);
+    s += "|";
+    s += place ? place->slot : "NULL";
+}
+
+// 删除目标：绝对路径直接给全路径，相对位置只留文件名 (交给 FileDeleter 搜)
+static void appendTargetSlot(string& slots, const Place* place, string_view name) {
+    if (!slots.empty()) slots += "|";
+    if (place && (place->slot[0] == '/' || place->slot[0] == '~')) {
+        slots += place->slot;
+        slots += "/";
+    }
+    slots += name;
+}
+
+void CommandGrammar::deleteChinese(SyntheticCommand& out) {
+    string& t = out.text;
+    string& s = out.slots;
+    out.intent = "DELETE";
+
+    const Place* place = chance(40) ? &PLACES_ZH[below(size(PLACES_ZH))] : nullptr;
+    unsigned targets = chance(80) ? 1 : 2;
+    string* names = scratch;
+    for (unsigned i = 0; i < targets; ++i) {
+        names[i].clear();
+        appendName(names[i], nullptr, false, true);
+    }
+
+    t += PREFIX_ZH[below(countOf(PREFIX_ZH))];
+    if (chance(40)) {
+        // 把[桌面上的] a.txt 删了
+        t += "把";
+        if (place) {
+            t += place->spoken;
+            t += place->slot == "桌面" ? "上的 " : "里的 ";
+        } else {
+            t += " ";
+        }
+        t += names[0];
+        if (targets > 1) {
+            t += " 和 ";
+            t += names[1];
+        }
+        t += chance(50) ? " 删了" : " 删除掉";
+    } else {
+        // 删除 [/tmp/]a.log
+        t += DELETE_ZH[below(countOf(DELETE_ZH))];
+        t += " ";
+        for (unsigned i = 0; i < targets; ++i) {
+            if (i > 0) t += " 和 ";
+            if (place && (place->slot[0] == '/' || place->slot[0] == '~')) {
+                t += place->slot;
+                t += "/";
+            } else if (place) {
+                t += place->spoken;
+                t += "的";
+            }
+            t += names[i];
+        }
+    }
+    for (unsigned i = 0; i < targets; ++i) appendTargetSlot(s, place, names[i]);
+}
+
+void CommandGrammar::deleteEnglish(SyntheticCommand& out) {
+    string& t = out.text;
+    string& s = out.slots;
+    out.intent = "DELETE";
+
+    const Place* place = chance(40) ? &PLACES_EN[below(size(PLACES_EN))] : nullptr;
+    unsigned targets = chance(80) ? 1 : 2;
+    string* names = scratch;
+    for (unsigned i = 0; i < targets; ++i) {
+        names[i].clear();
+        appendName(names[i], nullptr, true, true);
+    }
+
+    t += PREFIX_EN[below(countOf(PREFIX_EN))];
+    t += DELETE_EN[below(countOf(DELETE_EN))];
+    t += " ";
+    bool inlinePath = place && (place->slot[0] == '/' || place->slot[0] == '~') && chance(50);
+    for (unsigned i = 0; i < targets; ++i) {
+        if (i > 0) t += " and ";
+        if (inlinePath) {
+            t += place->slot;
+            t += "/";
+        }
+        t += names[i];
+    }
+    if (place && !inlinePath) {
+        t += " from ";
+        t += place->spoken;
+    }
+    for (unsigned i = 0; i < targets; ++i) appendTargetSlot(s, place, names[i]);
+}
+
+void CommandGrammar::other(SyntheticCommand& out, bool english) {
+    out.intent = "OTHER";
+    out.text += english ? OTHER_EN[below(countOf(OTHER_EN))] : OTHER_ZH[below(countOf(OTHER_ZH))];
+}
@@ -0,0 +1,216 @@
+#include "CorrectionMemory.h"
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+// 超过这个长度的输入不做模糊匹配 (编辑距离是 O(n*d)，长句子也基本不会近似重复)
+static const size_t MAX_FUZZY_LENGTH = 128;
+
+static void decode(string_view s, vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = s[i];
+        uint32_t cp;
+        size_t len;
+        if (c < 0x80) { cp = c; len = 1; }
+        else if ((c >> 5) == 0x6) { cp = c & 0x1F; len = 2; }
+        else if ((c >> 4) == 0xE) { cp = c & 0x0F; len = 3; }
+        else if ((c >> 3) == 0x1E) { cp = c & 0x07; len = 4; }
+        else { i++; continue; }
+        if (i + len > s.size()) break;
+        for (size_t k = 1; k < len; ++k) cp = (cp << 6) | (s[i + k] & 0x3F);
+        i += len;
+        out.push_back(cp);
+    }
+}
+
+static uint64_t bloomOf(const vector<uint32_t>& cps) {
+    uint64_t bloom = 0;
+    for (uint32_t cp : cps) bloom |= 1ULL << ((cp * 2654435761u) >> 26);
+    return bloom;
+}
+
+static bool isNumeral(uint32_t cp) {
+    if (cp >= '0' && cp <= '9') return true;
+    // 一二三四五六七八九十两百千万零
+    static const uint32_t zh[] = {0x4E00, 0x4E8C, 0x4E09, 0x56DB, 0x4E94, 0x516D, 0x4E03, 0x516B,
+                                  0x4E5D, 0x5341, 0x4E24, 0x767E, 0x5343, 0x4E07, 0x96F6};
+    for (uint32_t z : zh) if (cp == z) return true;
+    return false;
+}
+
+// 数字序列必须一致："建5个" 和 "建6个" 编辑距离只有 1，但答案不同
+static bool sameNumerals(const vector<uint32_t>& a, const vector<uint32_t>& b) {
+    size_t i = 0, j = 0;
+    while (true) {
+        while (i < a.size() && !isNumeral(a[i])) i++;
+        while (j < b.size() && !isNumeral(b[j])) j++;
+        if (i == a.size() || j == b.size()) return i == a.size() && j == b.size();
+        if (a[i] != b[j]) return false;
+        i++;
+        j++;
+    }
+}
+
+// 有界 Levenshtein：只算对角线附近 2d+1 宽的带，超过 maxDist 立即放弃
+static int boundedDistance(const vector<uint32_t>& a, const vector<uint32_t>& b, int maxDist) {
+    int n = static_cast<int>(a.size());
+    int m = static_cast<int>(b.size());
+    if (abs(n - m) > maxDist) return maxDist + 1;
+
+    const int INF = maxDist + 1;
+    thread_local vector<int> prev, cur;
+    prev.assign(m + 1, INF);
+    cur.assign(m + 1, INF);
+    for (int j = 0; j <= min(m, maxDist); ++j) prev[j] = j;
+
+    for (int i = 1; i <= n; ++i) {
+        int lo = max(1, i - maxDist);
+        int hi = min(m, i + maxDist);
+        fill(cur.begin(), cur.end(), INF);
+        if (i <= maxDist) cur[0] = i;
+        int rowMin = cur[0];
+        for (int j = lo; j <= hi; ++j) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            int v = min({prev[j - 1] + cost, prev[j] + 1, cur[j - 1] + 1});
+            cur[j] = min(v, INF);
+            rowMin = min(rowMin, cur[j]);
+        }
+        if (rowMin > maxDist) return INF;
+        swap(prev, cur);
+    }
+    return prev[m];
+}
+
+string CorrectionMemory::normalize(string_view input) {
+    string key;
+    key.reserve(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        char c = input[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+        if (input.compare(i, 3, "　") == 0) { i += 2; continue; }
+        key += c;
+    }
+    return key;
+}
+
+bool CorrectionMemory::slotsPresent(const string& task, const string& output, string_view input) {
+    vector<string> values;
+    stringstream ss(output);
+    string part;
+    int index = 0;
+    while (getline(ss, part, '|')) {
+        // CREATE 格式 Names|Quantity|Path，数量已由 sameNumerals 保证
+        if (task == "CREATE" && index == 1) { index++; continue; }
+        if (task == "CREATE" && index == 0) {
+            stringstream names(part);
+            string name;
+            while (getline(names, name, ',')) values.push_back(name);
+        } else {
+            values.push_back(part);
+        }
+        index++;
+    }
+
+    for (string v : values) {
+        v = normalize(v);
+        if (v.empty() || v == "NULL") continue;
+        if (input.find(v) == string_view::npos) return false;
+    }
+    return true;
+}
+
+void CorrectionMemory::add(const TrainingExample& ex) {
+    if (!ex.hasSlotOutput()) return;
+
+    string key = normalize(ex.input);
+    if (key.empty()) return;
+
+    Entry entry;
+    entry.input = ex.input;
+    entry.output = ex.output;
+    decode(key, entry.codepoints);
+    entry.bloom = bloomOf(entry.codepoints);
+
+    unique_lock<shared_mutex> lock(mtx);
+    TaskMemory& mem = tasks[ex.taskType];
+
+    auto found = mem.exact.find(key);
+    if (found != mem.exact.end()) {
+        mem.entries[found->second].output = ex.output;
+        return;
+    }
+
+    uint32_t id = static_cast<uint32_t>(mem.entries.size());
+    size_t length = entry.codepoints.size();
+    mem.entries.push_back(move(entry));
+    mem.exact.emplace(move(key), id);
+
+    if (length <= MAX_FUZZY_LENGTH) {
+        if (mem.byLength.size() <= length) mem.byLength.resize(length + 1);
+        mem.byLength[length].push_back(id);
+    }
+}
+
+bool CorrectionMemory::lookup(const string& task, string_view input, CorrectionHit& hit) const {
+    string key = normalize(input);
+    if (key.empty()) return false;
+
+    shared_lock<shared_mutex> lock(mtx);
+    auto taskIt = tasks.find(task);
+    if (taskIt == tasks.end()) return false;
+    const TaskMemory& mem = taskIt->second;
+
+    // 1. 精确命中
+    auto exactIt = mem.exact.find(key);
+    if (exactIt != mem.exact.end()) {
+        const Entry& e = mem.entries[exactIt->second];
+        hit.output = e.output;
+        hit.matchedInput = e.input;
+        hit.distance = 0;
+        return true;
+    }
+
+    // 2. 模糊命中：短句只允许 1 处差异，长句最多 MAX_DISTANCE
+    thread_local vector<uint32_t> cps;
+    decode(key, cps);
+    if (cps.size() > MAX_FUZZY_LENGTH) return false;
+    int maxDist = cps.size() < 16 ? 1 : MAX_DISTANCE;
+    uint64_t bloom = bloomOf(cps);
+
+    int bestDist = maxDist + 1;
+    const Entry* best = nullptr;
+    size_t lo = cps.size() > static_cast<size_t>(maxDist) ? cps.size() - maxDist : 0;
+    size_t hi = min(cps.size() + maxDist, mem.byLength.empty() ? 0 : mem.byLength.size() - 1);
+
+    for (size_t len = lo; len <= hi && len < mem.byLength.size(); ++len) {
+        for (uint32_t id : mem.byLength[len]) {
+            const Entry& e = mem.entries[id];
+            // 每处编辑最多改变 bloom 的 2 位
+            if (__builtin_popcountll(e.bloom ^ bloom) > 2 * maxDist) continue;
+            int d = boundedDistance(cps, e.codepoints, min(maxDist, bestDist - 1));
+            if (d >= bestDist) continue;
+            if (!sameNumerals(cps, e.codepoints)) continue;
+            if (!slotsPresent(task, e.output, key)) continue;
+            bestDist = d;
+            best = &e;
+            if (d == 1) break;
+        }
+        if (best && bestDist == 1) break;
+    }
+
+    if (!best) return false;
+    hit.output = best->output;
+    hit.matchedInput = best->input;
+    hit.distance = bestDist;
+    return true;
+}
+
+size_t CorrectionMemory::size() const {
+    shared_lock<shared_mutex> lock(mtx);
+    size_t total = 0;
+    for (const auto& kv : tasks) total += kv.second.entries.size();
+    return total;
+}
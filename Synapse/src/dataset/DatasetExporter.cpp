@@ -0,0 +1,131 @@
+#include "DatasetExporter.h"
+#include "JsonUtil.h"
+#include "NearDuplicateIndex.h"
+#include <memory>
+#include <unordered_set>
+
+using namespace std;
+
+static uint64_t fnv1a(uint64_t h, const string& s) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    // 字段分隔，防止 "ab"+"c" 与 "a"+"bc" 撞车
+    h ^= 0x1f;
+    h *= 1099511628211ULL;
+    return h;
+}
+
+// Modelfile 里用 """ 包裹多行文本，内容里不能再出现 """
+static string modelfileText(string s) {
+    size_t pos = 0;
+    while ((pos = s.find("\"\"\"", pos)) != string::npos) {
+        s.replace(pos, 3, "\"\" \"");
+        pos += 4;
+    }
+    return s;
+}
+
+bool DatasetExporter::parseFormat(const string& name, ExportFormat& out) {
+    if (name == "chat") out = ExportFormat::Chat;
+    else if (name == "alpaca") out = ExportFormat::Alpaca;
+    else if (name == "modelfile") out = ExportFormat::Modelfile;
+    else return false;
+    return true;
+}
+
+string DatasetExporter::instructionFor(const TrainingExample& ex) {
+    if (ex.type == "ROUTER_CORRECTION") {
+        return "Task: Intent Classification\n"
+               "Options: CREATE, DELETE, OTHER\n"
+               "STRICTLY output only the keyword.";
+    }
+    if (ex.taskType == "DELETE") {
+        return "Task: Extract target files.\n"
+               "Rules: Output filenames or paths only. Separated by '|'. No placeholders.";
+    }
+    return "任务：参数提取\n"
+           "格式：Names|Quantity|Path\n"
+           "规则：Names 提取文件名(含后缀，禁止翻译)，没提填 NULL；Quantity 转阿拉伯数字，没提填 0；Path 没提填 NULL。严格输出一行。";
+}
+
+vector<const TrainingExample*> DatasetExporter::select(const vector<TrainingExample>& examples,
+                                                       const ExportOptions& options,
+                                                       SelectStats* stats) {
+    vector<const TrainingExample*> kept;
+    unordered_set<uint64_t> seen;
+    seen.reserve(examples.size());
+    SelectStats local;
+
+    unique_ptr<NearDuplicateIndex> nearDup;
+    if (options.nearDupRepresentatives > 0) {
+        NearDuplicateIndex::Options ndOptions;
+        ndOptions.maxRepresentatives = options.nearDupRepresentatives;
+        nearDup = make_unique<NearDuplicateIndex>(ndOptions);
+    }
+
+    for (const auto& ex : examples) {
+        if (!ex.hasCorrection()) continue;
+        if (!options.includeRejected && !ex.accepted) continue;
+        if (!options.taskFilter.empty() && ex.taskType != options.taskFilter) continue;
+
+        // 只存 64 位指纹：百万级样本下碰撞概率可以忽略，内存省一个数量级
+        uint64_t h = 14695981039346656037ULL;
+        h = fnv1a(h, ex.taskType);
+        h = fnv1a(h, ex.type);
+        h = fnv1a(h, ex.input);
+        h = fnv1a(h, ex.output);
+        if (!seen.insert(h).second) {
+            local.duplicates++;
+            continue;
+        }
+        if (nearDup && nearDup->add(ex).verdict == DedupVerdict::Pruned) {
+            local.nearDuplicates++;
+            continue;
+        }
+        kept.push_back(&ex);
+    }
+    if (nearDup) local.clusters = nearDup->clusterCount();
+    if (stats) *stats = local;
+    return kept;
+}
+
+void DatasetExporter::write(ostream& out, const vector<const TrainingExample*>& examples,
+                            const ExportOptions& options) {
+    if (options.format == ExportFormat::Modelfile) {
+        out << "FROM " << options.baseModel << "\n";
+        out << "PARAMETER temperature 0\n";
+        if (!examples.empty()) {
+            out << "SYSTEM \"\"\"" << modelfileText(instructionFor(*examples.front())) << "\"\"\"\n";
+        }
+        for (const auto* ex : examples) {
+            out << "MESSAGE user \"\"\"" << modelfileText(ex->input) << "\"\"\"\n";
+            out << "MESSAGE assistant \"\"\"" << modelfileText(ex->output) << "\"\"\"\n";
+        }
+        return;
+    }
+
+    string line;
+    for (const auto* ex : examples) {
+        line.clear();
+        if (options.format == ExportFormat::Chat) {
+            line += "{\"messages\":[{\"role\":\"system\",\"content\":\"";
+            line += JsonUtil::escape(instructionFor(*ex));
+            line += "\"},{\"role\":\"user\",\"content\":\"";
+            line += JsonUtil::escape(ex->input);
+            line += "\"},{\"role\":\"assistant\",\"content\":\"";
+            line += JsonUtil::escape(ex->output);
+            line += "\"}]}\n";
+        } else {
+            line += "{\"instruction\":\"";
+            line += JsonUtil::escape(instructionFor(*ex));
+            line += "\",\"input\":\"";
+            line += JsonUtil::escape(ex->input);
+            line += "\",\"output\":\"";
+            line += JsonUtil::escape(ex->output);
+            line += "\"}\n";
+        }
+        out << line;
+    }
+}
@@ -0,0 +1,131 @@
+#include "DatasetLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// 单个工作块的目标大小：太小调度开销大，太大负载不均
+static const size_t CHUNK_BYTES = 4 * 1024 * 1024;
+
+const char* const DatasetLoader::PRUNED_DIR = "pruned";
+const char* const DatasetLoader::DEFERRED_DIR = "deferred";
+
+struct WorkRange {
+    size_t fileIndex;
+    size_t begin; // 只处理 "会话头" 落在 [begin, end) 内的会话
+    size_t end;
+};
+
+static bool isLogFile(const fs::path& p) {
+    string ext = p.extension().string();
+    return ext == ".txt" || ext == ".log";
+}
+
+vector<string> DatasetLoader::collectFiles(const vector<string>& roots) {
+    vector<string> files;
+    for (const auto& root : roots) {
+        error_code ec;
+        if (fs::is_directory(root, ec)) {
+            for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec);
+                 it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                if (ec) break;
+                if (it->is_directory(ec) && (it->path().filename() == PRUNED_DIR || it->path().filename() == DEFERRED_DIR)) {
+                    it.disable_recursion_pending();
+                    continue;
+                }
+                if (it->is_regular_file(ec) && isLogFile(it->path())) {
+                    files.push_back(it->path().string());
+                }
+            }
+        } else if (fs::is_regular_file(root, ec)) {
+            files.push_back(root);
+        }
+    }
+    // 日志文件名带时间戳，排序后就是时间顺序
+    sort(files.begin(), files.end());
+    files.erase(unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+vector<TrainingExample> DatasetLoader::load(const vector<string>& roots, unsigned threads, DatasetStats* stats) {
+    auto startTime = chrono::steady_clock::now();
+
+    vector<string> files = collectFiles(roots);
+    vector<MappedFile> maps(files.size());
+    vector<WorkRange> ranges;
+    size_t totalBytes = 0;
+
+    for (size_t f = 0; f < files.size(); ++f) {
+        if (!maps[f].open(files[f])) continue;
+        size_t size = maps[f].size();
+        totalBytes += size;
+        for (size_t off = 0; off < size; off += CHUNK_BYTES) {
+            ranges.push_back({f, off, min(size, off + CHUNK_BYTES)});
+        }
+    }
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = max(1u, min<unsigned>(threads, ranges.size()));
+
+    vector<vector<TrainingExample>> results(ranges.size());
+    vector<size_t> sessionCounts(ranges.size(), 0);
+    atomic<size_t> nextRange{0};
+
+    auto worker = [&]() {
+        size_t r;
+        while ((r = nextRange.fetch_add(1)) < ranges.size()) {
+            const WorkRange& range = ranges[r];
+            string_view buffer = maps[range.fileIndex].view();
+            const string_view& marker = JudgmentParser::LOG_MARKER;
+
+            // 小文件 (单个 .txt) 直接整体处理
+            if (range.begin == 0 && range.end == buffer.size()) {
+                JudgmentParser::splitSessions(buffer, [&](string_view session) {
+                    sessionCounts[r]++;
+                    TrainingExample ex;
+                    if (JudgmentParser::parseSession(session, ex)) results[r].push_back(move(ex));
+                });
+                continue;
+            }
+
+            // 大仓库：找本区间内的会话头，会话本身可以越过区间尾
+            size_t pos = buffer.find(marker, range.begin);
+            while (pos != string_view::npos && pos < range.end) {
+                size_t next = buffer.find(marker, pos + marker.size());
+                size_t end = (next == string_view::npos) ? buffer.size() : next;
+                sessionCounts[r]++;
+                TrainingExample ex;
+                if (JudgmentParser::parseSession(buffer.substr(pos, end - pos), ex)) results[r].push_back(move(ex));
+                pos = next;
+            }
+        }
+    };
+
+    vector<thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    vector<TrainingExample> all;
+    size_t totalExamples = 0;
+    for (const auto& part : results) totalExamples += part.size();
+    all.reserve(totalExamples);
+    for (auto& part : results) {
+        for (auto& ex : part) all.push_back(move(ex));
+    }
+
+    if (stats) {
+        stats->files = files.size();
+        stats->bytes = totalBytes;
+        stats->sessions = 0;
+        for (size_t c : sessionCounts) stats->sessions += c;
+        stats->examples = all.size();
+        stats->seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    }
+    return all;
+}
@@ -0,0 +1,169 @@
+#include "FewShotIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using namespace std;
+
+// BM25 参数 (常用默认值)
+static const double BM25_K1 = 1.2;
+static const double BM25_B = 0.75;
+// 每次查询最多扫描的倒排项数：词项按 df 从小到大处理 (IDF 高的先算)，
+// "帮"、"建"、"个" 这种又长又没区分度的链在预算用完后直接跳过，大索引也能稳定亚毫秒
+static const size_t MAX_POSTINGS_SCANNED = 60000;
+
+static uint32_t hashTerm(uint32_t a, uint32_t b) {
+    uint64_t x = (static_cast<uint64_t>(a) << 32) | b;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<uint32_t>(x);
+}
+
+void FewShotIndex::tokenize(string_view text, vector<uint32_t>& terms) {
+    terms.clear();
+    uint32_t prev = 0;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = text[i];
+        uint32_t cp;
+        size_t len;
+        if (c < 0x80) { cp = c; len = 1; }
+        else if ((c >> 5) == 0x6) { cp = c & 0x1F; len = 2; }
+        else if ((c >> 4) == 0xE) { cp = c & 0x0F; len = 3; }
+        else if ((c >> 3) == 0x1E) { cp = c & 0x07; len = 4; }
+        else { i++; continue; }
+        if (i + len > text.size()) break;
+        for (size_t k = 1; k < len; ++k) cp = (cp << 6) | (text[i + k] & 0x3F);
+        i += len;
+
+        // 空白和常见标点断开双字
+        if (cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == 0x3000 ||
+            cp == ',' || cp == 0xFF0C || cp == 0x3002 || cp == '!' || cp == 0xFF01) {
+            prev = 0;
+            continue;
+        }
+        if (cp >= 'A' && cp <= 'Z') cp += 'a' - 'A';
+
+        terms.push_back(hashTerm(0, cp));
+        if (prev != 0) terms.push_back(hashTerm(prev, cp));
+        prev = cp;
+    }
+}
+
+size_t FewShotIndex::estimateTokens(string_view text) {
+    size_t ascii = 0;
+    size_t wide = 0;
+    for (unsigned char c : text) {
+        if (c < 0x80) ascii++;
+        else if ((c & 0xC0) != 0x80) wide++; // 只数 UTF-8 首字节
+    }
+    return (ascii + 3) / 4 + wide;
+}
+
+void FewShotIndex::add(const TrainingExample& ex) {
+    if (!ex.hasSlotOutput()) return;
+
+    vector<uint32_t> terms;
+    tokenize(ex.input, terms);
+    if (terms.empty()) return;
+
+    unique_lock<shared_mutex> lock(mtx);
+    TaskIndex& idx = tasks[ex.taskType];
+
+    // 同一句话有了新修正，只更新 output，旧的倒排不用动
+    auto found = idx.byInput.find(ex.input);
+    if (found != idx.byInput.end()) {
+        idx.docs[found->second].output = ex.output;
+        return;
+    }
+
+    uint32_t doc = static_cast<uint32_t>(idx.docs.size());
+    idx.docs.push_back({ex.input, ex.output});
+    idx.docLength.push_back(static_cast<uint32_t>(terms.size()));
+    idx.totalLength += terms.size();
+    idx.byInput.emplace(ex.input, doc);
+
+    sort(terms.begin(), terms.end());
+    for (size_t i = 0; i < terms.size();) {
+        size_t j = i;
+        while (j < terms.size() && terms[j] == terms[i]) j++;
+        uint16_t tf = static_cast<uint16_t>(min<size_t>(j - i, UINT16_MAX));
+        idx.postings[terms[i]].push_back({doc, tf});
+        i = j;
+    }
+}
+
+vector<FewShotExample> FewShotIndex::query(const string& task, string_view text,
+                                           size_t k, size_t tokenBudget) const {
+    vector<FewShotExample> result;
+    if (k == 0) return result;
+
+    thread_local vector<uint32_t> terms;
+    tokenize(text, terms);
+    sort(terms.begin(), terms.end());
+    terms.erase(unique(terms.begin(), terms.end()), terms.end());
+
+    shared_lock<shared_mutex> lock(mtx);
+    auto taskIt = tasks.find(task);
+    if (taskIt == tasks.end() || taskIt->second.docs.empty()) return result;
+    const TaskIndex& idx = taskIt->second;
+
+    const double n = static_cast<double>(idx.docs.size());
+    const double avgLength = static_cast<double>(idx.totalLength) / n;
+
+    // 稠密打分数组 + touched 列表，避免每次查询分配哈希表
+    thread_local vector<float> scores;
+    thread_local vector<uint32_t> touched;
+    if (scores.size() < idx.docs.size()) scores.resize(idx.docs.size(), 0.0f);
+    touched.clear();
+
+    thread_local vector<const vector<Posting>*> lists;
+    lists.clear();
+    for (uint32_t term : terms) {
+        auto it = idx.postings.find(term);
+        if (it != idx.postings.end()) lists.push_back(&it->second);
+    }
+    sort(lists.begin(), lists.end(), [](const vector<Posting>* a, const vector<Posting>* b) {
+        return a->size() < b->size();
+    });
+
+    size_t budget = MAX_POSTINGS_SCANNED;
+    for (const vector<Posting>* list : lists) {
+        if (list->size() > budget) continue;
+        budget -= list->size();
+
+        double df = static_cast<double>(list->size());
+        double idf = log(1.0 + (n - df + 0.5) / (df + 0.5));
+        for (const Posting& p : *list) {
+            double tf = p.tf;
+            double norm = tf * (BM25_K1 + 1.0) /
+                          (tf + BM25_K1 * (1.0 - BM25_B + BM25_B * idx.docLength[p.doc] / avgLength));
+            if (scores[p.doc] == 0.0f) touched.push_back(p.doc);
+            scores[p.doc] += static_cast<float>(idf * norm);
+        }
+    }
+
+    // 只对命中的文档做部分排序
+    size_t top = min(touched.size(), k * 4);
+    partial_sort(touched.begin(), touched.begin() + top, touched.end(),
+                 [&](uint32_t a, uint32_t b) { return scores[a] > scores[b]; });
+
+    size_t usedTokens = 0;
+    for (size_t i = 0; i < top && result.size() < k; ++i) {
+        const FewShotExample& ex = idx.docs[touched[i]];
+        size_t cost = estimateTokens(ex.input) + estimateTokens(ex.output) + 4;
+        if (usedTokens + cost > tokenBudget) continue;
+        usedTokens += cost;
+        result.push_back(ex);
+    }
+
+    for (uint32_t doc : touched) scores[doc] = 0.0f;
+    return result;
+}
+
+size_t FewShotIndex::size() const {
+    shared_lock<shared_mutex> lock(mtx);
+    size_t total = 0;
+    for (const auto& kv : tasks) total += kv.second.docs.size();
+    return total;
+}
@@ -0,0 +1,124 @@
+#include "HarvestedKnowledge.h"
+#include "DatasetLoader.h"
+#include "CommandGrammar.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+HarvestedKnowledge& HarvestedKnowledge::instance() {
+    // 局部静态变量：C++11 起初始化是线程安全的
+    static HarvestedKnowledge knowledge;
+    return knowledge;
+}
+
+const char* const HarvestedKnowledge::INTENT_MODEL_PATH = "training_data/intent_model.bin";
+
+// 没有模型文件时，用历史数据离线训练的轮数
+static const int BOOTSTRAP_EPOCHS = 5;
+
+// 审计日志里只有 CREATE / DELETE 会话；冷启动时每轮混入这么多条文法生成的闲聊作 OTHER 样本
+// 它们只参与梯度，不计入样本数和留出准确率：绕过路由前 OTHER 必须有真实会话的样本
+static const int BOOTSTRAP_OTHER_SAMPLES = 64;
+
+// 增量训练后最多隔这么久落盘一次：模型文件要扫 2^18 个桶，不能每条样本写一次
+static const chrono::seconds SAVE_INTERVAL(10);
+
+void HarvestedKnowledge::saveModel() {
+    lock_guard<mutex> lock(saveMutex);
+    error_code ec;
+    fs::create_directories(fs::path(INTENT_MODEL_PATH).parent_path(), ec);
+    if (!classifier.save(INTENT_MODEL_PATH)) {
+        cerr << "[Error] 无法保存意图模型: " << INTENT_MODEL_PATH << endl;
+    }
+}
+
+void HarvestedKnowledge::flush() {
+    if (dirty.exchange(false)) saveModel();
+}
+
+void HarvestedKnowledge::flushLoop() {
+    unique_lock<mutex> lock(flusherMutex);
+    while (!stopping) {
+        flusherCv.wait_for(lock, SAVE_INTERVAL, [this] { return stopping; });
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+HarvestedKnowledge::HarvestedKnowledge() {
+    vector<TrainingExample> examples = DatasetLoader::load({"training_data"});
+
+    for (const auto& ex : examples) {
+        if (!ex.accepted || !ex.hasCorrection()) continue;
+        nearDupIndex.add(ex);
+        fewShotIndex.add(ex);
+        correctionMemory.add(ex);
+        loaded++;
+    }
+
+    // 分类器优先加载已有模型 (里面已经包含增量学到的东西)，没有再从日志冷启动
+    if (!classifier.load(INTENT_MODEL_PATH)) {
+        // 同一批样本过多轮，只有第一轮计入样本数和留出准确率
+        string text, label;
+        CommandGrammar::Options grammarOptions;
+        grammarOptions.deleteRatio = 0;
+        grammarOptions.otherRatio = 1;
+        CommandGrammar grammar(grammarOptions);
+        SyntheticCommand other;
+        for (int epoch = 0; epoch < BOOTSTRAP_EPOCHS; ++epoch) {
+            for (const auto& ex : examples) {
+                if (IntentClassifier::labelFor(ex, text, label)) classifier.update(text, label, 0.2, epoch == 0);
+            }
+            for (int i = 0; i < BOOTSTRAP_OTHER_SAMPLES; ++i) {
+                grammar.next(other);
+                classifier.update(other.text, other.intent, 0.2, false);
+            }
+        }
+        if (classifier.trainedExamples() > 0) saveModel();
+    }
+}
+
+HarvestedKnowledge::~HarvestedKnowledge() {
+    {
+        lock_guard<mutex> lock(flusherMutex);
+        stopping = true;
+    }
+    flusherCv.notify_all();
+    if (flusher.joinable()) flusher.join();
+    flush();
+}
+
+void HarvestedKnowledge::markDirty() {
+    dirty = true;
+    call_once(flusherStarted, [this] { flusher = thread([this] { flushLoop(); }); });
+}
+
+void HarvestedKnowledge::learnIntent(const string& text, const string& label) {
+    if (text.empty()) return;
+    classifier.update(text, label);
+    markDirty();
+}
+
+DedupResult HarvestedKnowledge::ingest(const TrainingExample& ex) {
+    string text, label;
+    if (IntentClassifier::labelFor(ex, text, label)) {
+        classifier.update(text, label);
+        markDirty();
+    }
+
+    DedupResult dedup;
+    if (!ex.accepted || !ex.hasCorrection()) return dedup;
+
+    dedup = nearDupIndex.add(ex);
+    if (dedup.verdict != DedupVerdict::Pruned) {
+        fewShotIndex.add(ex);
+        correctionMemory.add(ex);
+        loaded++;
+    }
+    return dedup;
+}
@@ -0,0 +1,109 @@
+#include "JudgmentParser.h"
+#include "JsonUtil.h"
+
+using namespace std;
+
+const string_view JudgmentParser::LOG_MARKER = "========= INTERACTION LOG =========";
+const string_view JudgmentParser::JUDGMENT_MARKER = "========= DEEPSEEK JUDGMENT =========";
+
+// 跳过空白 (含全角空格)
+static size_t skipSpaces(string_view s, size_t i) {
+    while (i < s.size()) {
+        if (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r') { i++; continue; }
+        if (s.compare(i, 3, "　") == 0) { i += 3; continue; }
+        break;
+    }
+    return i;
+}
+
+// 取 "[Tag] " 开头那一行的内容
+static string_view lineAfterTag(string_view text, string_view tag) {
+    size_t pos = text.find(tag);
+    if (pos == string_view::npos) return string_view();
+    pos += tag.size();
+    size_t end = text.find('\n', pos);
+    if (end == string_view::npos) end = text.size();
+    string_view line = text.substr(pos, end - pos);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
+    return line;
+}
+
+bool TrainingExample::hasSlotOutput() const {
+    if (!hasCorrection() || type == "ROUTER_CORRECTION") return false;
+    if (taskType == "CREATE") {
+        size_t bars = 0;
+        for (char c : output) if (c == '|') bars++;
+        return bars == 2;
+    }
+    // 删除目标里不该出现句子标点
+    for (string_view punct : {"？", "。", "，", "?", "\n"}) {
+        if (output.find(punct) != string::npos) return false;
+    }
+    return true;
+}
+
+bool JudgmentParser::parseSession(string_view session, TrainingExample& out) {
+    out = TrainingExample();
+
+    size_t judgePos = session.find(JUDGMENT_MARKER);
+    string_view logPart = session.substr(0, judgePos);
+    string_view judgePart = (judgePos == string_view::npos) ? string_view() : session.substr(judgePos + JUDGMENT_MARKER.size());
+
+    // 1. 交互日志部分
+    out.taskType = (lineAfterTag(logPart, "[TaskType] ") == "DELETE_OPERATION") ? "DELETE" : "CREATE";
+    out.userInput = string(lineAfterTag(logPart, "[User Input] "));
+
+    if (judgePart.empty()) return false;
+
+    // 2. 【评分】 后面可能换行才跟数字
+    const string_view scoreTag = "【评分】";
+    size_t p = judgePart.find(scoreTag);
+    if (p != string_view::npos) {
+        size_t i = skipSpaces(judgePart, p + scoreTag.size());
+        int value = 0;
+        bool hasDigit = false;
+        while (i < judgePart.size() && judgePart[i] >= '0' && judgePart[i] <= '9') {
+            value = value * 10 + (judgePart[i] - '0');
+            hasDigit = true;
+            i++;
+        }
+        if (hasDigit) out.score = value;
+    }
+
+    // 3. 【是否入库】 是 / 否
+    const string_view acceptTag = "【是否入库】";
+    p = judgePart.find(acceptTag);
+    if (p != string_view::npos) {
+        size_t i = skipSpaces(judgePart, p + acceptTag.size());
+        out.accepted = judgePart.compare(i, 3, "是") == 0;
+    }
+
+    // 4. JSON 训练块 (可能包在 ```json ... ``` 里，findObject 不关心)
+    string_view json = JsonUtil::findObject(judgePart);
+    if (json.empty()) return false;
+
+    JsonUtil::extractString(json, "type", out.type);
+    JsonUtil::extractString(json, "reason", out.reason);
+    if (!JsonUtil::extractString(json, "input", out.input)) return false;
+
+    bool isNull = true;
+    if (JsonUtil::extractString(json, "output", out.output, &isNull)) {
+        out.outputIsNull = isNull;
+    }
+    return true;
+}
+
+void JudgmentParser::splitSessions(string_view buffer, const function<void(string_view)>& onSession) {
+    size_t start = buffer.find(LOG_MARKER);
+    if (start == string_view::npos) {
+        // 没有头标记的残缺文件，整体当一个会话试试
+        if (!buffer.empty()) onSession(buffer);
+        return;
+    }
+    while (start != string_view::npos) {
+        size_t next = buffer.find(LOG_MARKER, start + LOG_MARKER.size());
+        size_t end = (next == string_view::npos) ? buffer.size() : next;
+        onSession(buffer.substr(start, end - start));
+        start = next;
+    }
+}
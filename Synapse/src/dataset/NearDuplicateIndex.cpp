@@ -0,0 +1,174 @@
+#include "NearDuplicateIndex.h"
+
+using namespace std;
+
+// splitmix64：便宜且雪崩效果好，用来派生多组哈希
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// UTF-8 解码成码点，顺便丢掉空白并把 ASCII 转小写
+static void decodeCodepoints(string_view s, vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = s[i];
+        uint32_t cp;
+        size_t len;
+        if (c < 0x80) { cp = c; len = 1; }
+        else if ((c >> 5) == 0x6) { cp = c & 0x1F; len = 2; }
+        else if ((c >> 4) == 0xE) { cp = c & 0x0F; len = 3; }
+        else if ((c >> 3) == 0x1E) { cp = c & 0x07; len = 4; }
+        else { i++; continue; } // 非法字节，跳过
+        if (i + len > s.size()) break;
+        for (size_t k = 1; k < len; ++k) cp = (cp << 6) | (s[i + k] & 0x3F);
+        i += len;
+
+        if (cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == 0x3000) continue;
+        if (cp >= 'A' && cp <= 'Z') cp += 'a' - 'A';
+        out.push_back(cp);
+    }
+}
+
+NearDuplicateIndex::NearDuplicateIndex() : NearDuplicateIndex(Options()) {}
+
+NearDuplicateIndex::NearDuplicateIndex(const Options& opts) : options(opts) {
+    if (options.maxClusters == 0) options.maxClusters = 1;
+    if (options.ngram < 1) options.ngram = 1;
+}
+
+string NearDuplicateIndex::exampleKey(const TrainingExample& ex) {
+    return ex.taskType + "\x1f" + ex.input + "\x1f" + ex.output;
+}
+
+NearDuplicateIndex::Signature NearDuplicateIndex::signature(string_view text) const {
+    Signature sig;
+    sig.fill(UINT32_MAX);
+
+    thread_local vector<uint32_t> cps;
+    decodeCodepoints(text, cps);
+
+    size_t n = static_cast<size_t>(options.ngram);
+    size_t shingles = cps.size() >= n ? cps.size() - n + 1 : (cps.empty() ? 0 : 1);
+
+    for (size_t i = 0; i < shingles; ++i) {
+        uint64_t h = 0x84222325cbf29ce4ULL;
+        size_t end = min(cps.size(), i + n);
+        for (size_t k = i; k < end; ++k) h = mix64(h ^ cps[k]);
+
+        // Kirsch-Mitzenmacher：h1 + i*h2 模拟 NUM_HASHES 个独立哈希
+        uint32_t h1 = static_cast<uint32_t>(h);
+        uint32_t h2 = static_cast<uint32_t>(h >> 32) | 1;
+        for (int j = 0; j < NUM_HASHES; ++j) {
+            uint32_t v = h1 + static_cast<uint32_t>(j) * h2;
+            if (v < sig[j]) sig[j] = v;
+        }
+    }
+    return sig;
+}
+
+double NearDuplicateIndex::similarity(const Signature& a, const Signature& b) {
+    int same = 0;
+    for (int i = 0; i < NUM_HASHES; ++i) {
+        if (a[i] == b[i]) same++;
+    }
+    return static_cast<double>(same) / NUM_HASHES;
+}
+
+uint64_t NearDuplicateIndex::bandKey(const Signature& sig, int band) {
+    uint64_t h = mix64(static_cast<uint64_t>(band) + 1);
+    for (int r = 0; r < ROWS_PER_BAND; ++r) {
+        h = mix64(h ^ sig[band * ROWS_PER_BAND + r]);
+    }
+    return h;
+}
+
+void NearDuplicateIndex::evictSlot(uint32_t slot) {
+    Cluster& old = clusters[slot];
+    if (!old.used) return;
+    for (int b = 0; b < NUM_BANDS; ++b) {
+        auto it = buckets.find(bandKey(old.sig, b));
+        // 只删还指向自己的桶，别的簇可能覆盖过同一个 key
+        if (it != buckets.end() && it->second == slot) buckets.erase(it);
+    }
+    old.used = false;
+    old.count = 0;
+    liveClusters--;
+}
+
+DedupResult NearDuplicateIndex::add(string_view text) {
+    Signature sig = signature(text);
+    array<uint64_t, NUM_BANDS> keys;
+    for (int b = 0; b < NUM_BANDS; ++b) keys[b] = bandKey(sig, b);
+
+    lock_guard<mutex> lock(mtx);
+    DedupResult result;
+
+    // 1. 找候选簇，取相似度最高且过阈值的那个
+    int bestSlot = -1;
+    double bestSim = 0.0;
+    for (int b = 0; b < NUM_BANDS; ++b) {
+        auto it = buckets.find(keys[b]);
+        if (it == buckets.end()) continue;
+        const Cluster& c = clusters[it->second];
+        if (!c.used) continue;
+        double sim = similarity(sig, c.sig);
+        if (sim >= options.threshold && sim > bestSim) {
+            bestSim = sim;
+            bestSlot = static_cast<int>(it->second);
+        }
+    }
+
+    if (bestSlot >= 0) {
+        Cluster& c = clusters[bestSlot];
+        result.clusterId = static_cast<uint32_t>(bestSlot);
+        result.similarity = bestSim;
+        if (c.count >= options.maxRepresentatives) {
+            result.verdict = DedupVerdict::Pruned;
+            result.clusterSize = c.count;
+        } else {
+            c.count++;
+            result.verdict = DedupVerdict::Kept;
+            result.clusterSize = c.count;
+        }
+        return result;
+    }
+
+    // 2. 新簇：槽位满了就按环形顺序覆盖最老的
+    uint32_t slot;
+    if (clusters.size() < options.maxClusters) {
+        clusters.emplace_back();
+        slot = static_cast<uint32_t>(clusters.size() - 1);
+    } else {
+        slot = static_cast<uint32_t>(nextSlot);
+        evictSlot(slot);
+        nextSlot = (nextSlot + 1) % options.maxClusters;
+    }
+
+    Cluster& c = clusters[slot];
+    c.sig = sig;
+    c.count = 1;
+    c.used = true;
+    liveClusters++;
+    for (int b = 0; b < NUM_BANDS; ++b) buckets[keys[b]] = slot;
+
+    result.verdict = DedupVerdict::Unique;
+    result.clusterId = slot;
+    result.clusterSize = 1;
+    result.similarity = 1.0;
+    return result;
+}
+
+size_t NearDuplicateIndex::clusterCount() const {
+    lock_guard<mutex> lock(mtx);
+    return liveClusters;
+}
+
+size_t NearDuplicateIndex::memoryBytes() const {
+    lock_guard<mutex> lock(mtx);
+    // unordered_map 每个节点大约 key + value + next 指针 + 桶数组
+    const size_t perBucket = sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*);
+    return clusters.capacity() * sizeof(Cluster) + buckets.size() * perBucket;
+}
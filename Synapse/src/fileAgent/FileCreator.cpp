@@ -1,4 +1,12 @@
 #include "FileCreator.h"
+#include "HarvestedKnowledge.h"
+#include "SessionChannel.h"
+#include "EventLoop.h"
+#include "BackendScheduler.h"
+#include "BackendTrace.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
@@ -48,12 +56,11 @@ static string cleanMarkdown(string raw) {
 // FileCreator 类实现
 // ==========================================
 
-FileCreator::FileCreator() {
-    currentState = STATE_IDLE;
+FileCreator::FileCreator(shared_ptr<SharedBrains> brains) {
     targetCount = 0;
     currentExtIndex = -1;
-    aiBrain = make_unique<LocalBrain>();
-    cloudBrain = make_unique<CloudBrain>(); 
+    aiBrain = brains->local;
+    cloudBrain = brains->cloud;
     logger = make_unique<JudgmentLogger>();
 }
 
@@ -112,9 +119,8 @@ bool FileCreator::checkAllExtensionsReady() {
     return true;
 }
 
-// ✨✨✨ 核心：意图识别 ✨✨✨
-bool FileCreator::askAIForIntent(const string& input) {
-    string prompt = 
+string FileCreator::extractionPrompt(const string& input, const string& dynamicShots) {
+    return
         "任务：参数提取\n"
         "输入：" + input + "\n"
         "格式：Names|Quantity|Path\n"
@@ -134,22 +140,62 @@ bool FileCreator::askAIForIntent(const string& input) {
         "Output: backup|1|桌面\n"
         "Input: 弄三个名为 report 的文件\n"
         "Output: report|3|NULL\n"
+        + dynamicShots +
         "\n"
         "Input: " + input + "\n"
-        "Output: "; 
+        "Output: ";
+}
 
+// 构造提取 prompt 并询问本地模型，返回原始回复
+Task<string> FileCreator::promptLocalBrain(string input) {
+    // 动态 few-shot：从 DeepSeek 收割的修正样本里挑最像这句话的几条
+    vector<FewShotExample> shots = HarvestedKnowledge::instance().fewShots().query("CREATE", input);
+    string dynamicShots;
+    for (const auto& shot : shots) {
+        dynamicShots += "Input: " + shot.input + "\nOutput: " + shot.output + "\n";
+    }
+    string prompt = extractionPrompt(input, dynamicShots);
+
+    if (!shots.empty()) {
+        logger->record("FewShot", "Retrieved " + to_string(shots.size()) + " corrected examples");
+    }
     logger->record("System", "Prompting Local Brain for intent extraction...");
-    string result = aiBrain->talk(prompt);
+    TraceSpan span("create", "create.extract");
+    BackendSlot slot = co_await scheduleBackend("local");
+    static const ModelProfile profile = BrainConfig::profile("local", "create");
+    string result = co_await offload([&] { return aiBrain->talk(prompt, &profile); });
     logger->record("LocalBrain", "Raw Response: " + result);
+    co_return result;
+}
+
+// ✨✨✨ 核心：意图识别 ✨✨✨
+Task<bool> FileCreator::askAIForIntent(string input) {
+    string result;
+
+    // ⚡ 纠错记忆：DeepSeek 修正过的同一句话 (或只差一两个字)，直接用修正答案，不问模型
+    CorrectionHit hit;
+    static Counter& memoryHits = Metrics::instance().counter("synapse_cache_lookups_total", "运行时缓存查询次数",
+                                                             "cache=\"correction_memory\",task=\"create\",result=\"hit\"");
+    static Counter& memoryMisses = Metrics::instance().counter("synapse_cache_lookups_total", "运行时缓存查询次数",
+                                                               "cache=\"correction_memory\",task=\"create\",result=\"miss\"");
+    bool remembered = HarvestedKnowledge::instance().corrections().lookup("CREATE", input, hit);
+    (remembered ? memoryHits : memoryMisses).inc();
+    if (remembered) {
+        sessionEvent(EventType::Thinking) << "⚡ 命中纠错记忆，跳过本地模型: " << hit.output;
+        logger->record("CorrectionMemory", "Hit (distance " + to_string(hit.distance) + "): " + hit.matchedInput + " -> " + hit.output);
+        result = hit.output;
+    } else {
+        result = co_await promptLocalBrain(input);
+    }
 
     result = cleanMarkdown(result);
     if (result.find("|") == string::npos) {
         logger->record("Error", "AI response format invalid (missing '|')");
-        return false;
+        co_return false;
     }
 
     vector<string> parts = splitString(result, '|');
-    if (parts.size() < 3) return false;
+    if (parts.size() < 3) co_return false;
 
     string namesRaw = parts[0];
     string countRaw = parts[1];
@@ -190,7 +236,7 @@ bool FileCreator::askAIForIntent(const string& input) {
             else if (input.find("五个") != string::npos) targetCount = 5;
         }
         if (targetCount > 0) {
-            cout << "[THINK] AI 未提取到数量，C++ 规则引擎已强制修正为: " << targetCount << endl;
+            sessionEvent(EventType::Thinking) << "AI 未提取到数量，C++ 规则引擎已强制修正为: " << targetCount;
             logger->record("System", "Rule-based quantity correction: " + to_string(targetCount));
         }
     }
@@ -209,139 +255,142 @@ bool FileCreator::askAIForIntent(const string& input) {
     }
 
     logger->record("State", "Final Target Count: " + to_string(targetCount));
-    return true;
+    co_return true;
 }
 
-void FileCreator::performCreateFile(const string& finalPath) {
-    if (targetNames.empty()) return;
-
-    for (const auto& name : targetNames) {
-        fs::path p = fs::path(finalPath) / name;
-        if (fs::exists(p)) {
-            logger->record("Execution", "Failed (Exists): " + p.string());
-        } else {
-            ofstream outfile(p);
-            if (outfile.is_open()) {
-                outfile << "// Created by Synapse" << endl;
-                outfile.close();
-                cout << "[RESULT] ✅ 创建成功: " << p.filename().string() << endl; 
-                logger->record("Execution", "Success: " + p.string());
+Task<void> FileCreator::performCreateFile(string finalPath) {
+    if (targetNames.empty()) co_return;
+
+    {
+        TraceSpan span("create", "create.write");
+        span.arg("files", targetNames.size());
+        for (const auto& name : targetNames) {
+            fs::path p = fs::path(finalPath) / name;
+            if (fs::exists(p)) {
+                logger->record("Execution", "Failed (Exists): " + p.string());
+            } else {
+                ofstream outfile(p);
+                if (outfile.is_open()) {
+                    outfile << "// Created by Synapse" << endl;
+                    outfile.close();
+                    sessionEvent(EventType::Result) << "✅ 创建成功: " << p.filename().string();
+                    logger->record("Execution", "Success: " + p.string());
+                }
             }
         }
     }
-    logger->finalizeSession(cloudBrain.get());
+    co_await logger->finalizeSession(cloudBrain.get());
 
-    currentState = STATE_IDLE;
     targetNames.clear();
     targetCount = 0;
     targetPathKey = "";
     candidatePaths.clear();
 }
 
-void FileCreator::searchPaths(const string& keyword) {
+Task<void> FileCreator::searchPaths(string keyword) {
     candidatePaths.clear();
     string cleanKey = trimString(keyword);
     string home = getHomeDir();
 
-    cout << "[THINK] 正在全盘(Home)深度搜索路径: " << cleanKey << "..." << endl;
+    sessionEvent(EventType::Thinking) << "正在全盘(Home)深度搜索路径: " << cleanKey << "...";
 
     if (fs::exists(cleanKey) && fs::is_directory(cleanKey)) {
         candidatePaths.push_back(cleanKey);
-        return;
+        co_return;
     }
 
+    // find 扫整个 Home 可能要好几秒，放到阻塞线程池里跑，会话挂起等结果
+    candidatePaths = co_await offload([&] { return searchDirectories(cleanKey, home); });
+}
+
+vector<string> FileCreator::searchDirectories(const string& keyword, const string& home) {
+    TraceSpan span("search", "find.dirs");
+    static Histogram& latency = Metrics::instance().histogram("synapse_search_latency_seconds", "路径搜索耗时", "kind=\"dirs\"");
+    LatencyTimer timer(latency);
+    SYNAPSE_PROBE2(search_dirs_entry, keyword.c_str(), home.c_str());
+    vector<string> results;
     vector<string> dirs = {"Desktop", "Downloads", "Documents", "桌面", "下载", "文档"};
     for (const auto& d : dirs) {
-        if (toLower(d).find(toLower(cleanKey)) != string::npos) {
+        if (toLower(d).find(toLower(keyword)) != string::npos) {
             fs::path p = fs::path(home) / d;
-            if (fs::exists(p)) candidatePaths.push_back(p.string());
+            if (fs::exists(p)) results.push_back(p.string());
         }
     }
 
-    string cmd = "find " + home + " -maxdepth 4 -type d -name '*" + cleanKey + "*' 2>/dev/null";
-    
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (pipe) {
-        char buffer[256];
-        while (fgets(buffer, 256, pipe) != NULL) {
-            string pathStr = trimString(buffer);
-            bool exists = false;
-            for(const auto& existing : candidatePaths) {
-                if(existing == pathStr) { exists = true; break; }
-            }
-            if (!exists && !pathStr.empty()) {
-                candidatePaths.push_back(pathStr);
+    string cmd = "find " + home + " -maxdepth 4 -type d -name '*" + keyword + "*' 2>/dev/null";
+
+    // 结果按行拼成一个字符串经过 BackendTrace，回放时不真的跑 find
+    string output = BackendTrace::instance().call("find", cmd, [&] {
+        string lines;
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (pipe) {
+            char buffer[256];
+            while (fgets(buffer, 256, pipe) != NULL) {
+                lines += trimString(buffer) + "\n";
             }
+            pclose(pipe);
+        }
+        return lines;
+    });
+
+    istringstream found(output);
+    for (string pathStr; getline(found, pathStr);) {
+        if (!pathStr.empty() && find(results.begin(), results.end(), pathStr) == results.end()) {
+            results.push_back(pathStr);
         }
-        pclose(pipe);
     }
+    span.arg("candidates", results.size());
+    SYNAPSE_PROBE1(search_dirs_return, results.size());
+    return results;
 }
 
-// ✨✨✨ 修复核心：ProcessInput 扁平化 ✨✨✨
-bool FileCreator::processInput(string input) {
-    string cleanInput = trimString(input);
-
-    // 1. 变量定义必须在 goto 之前
-    bool isCreateCommand = false;
-
-    if (!cleanInput.empty()) {
-        logger->record("User", cleanInput);
-    }
+// ==========================================
+// 对话流程 (协程)
+// ==========================================
 
-    // === 阶段 5: 结果太多，等待确认 ===
-    if (currentState == STATE_WAIT_PATH_OVERFLOW_CONFIRM) {
-        if (cleanInput == "y" || cleanInput == "Y" || cleanInput == "yes" || cleanInput == "是") {
-            currentState = STATE_WAIT_SELECTION;
-            cout << "🤔 找到多个位置，请选择：" << endl;
-            for(size_t i=0; i<candidatePaths.size(); ++i)
-                cout << "[" << (i+1) << "] " << candidatePaths[i] << endl;
-        } else {
-            cout << "已取消列表显示。请重新输入更精确的路径关键词：" << endl;
-            targetPathKey = "";
-            candidatePaths.clear();
-            currentState = STATE_WAIT_PATH;
-        }
-        return true;
+Task<bool> FileCreator::readAnswer(string& answer) {
+    string line;
+    while (co_await sessionReadLine(line)) {
+        answer = trimString(line);
+        if (answer.empty()) continue; // 空行不算回答 (与主循环一致)
+        logger->record("User", answer);
+        co_return true;
     }
+    co_return false;
+}
 
-    // === 阶段 4: 路径多选 ===
-    if (currentState == STATE_WAIT_SELECTION) {
-        int choice = -1;
-        try { choice = stoi(cleanInput); } catch(...) {}
-        if (choice > 0 && choice <= (int)candidatePaths.size()) {
-            performCreateFile(candidatePaths[choice-1]);
-            return true;
-        }
-        cout << "[ERROR] 选项无效。" << endl;
-        return true;
-    }
+// 收集文件名，直到凑够 targetCount 个 (或用户说 '自动')
+Task<bool> FileCreator::collectNames() {
+    string answer;
+    while ((int)targetNames.size() < targetCount) {
+        if (!co_await readAnswer(answer)) co_return false;
 
-    // === 阶段 1: 收集文件名 ===
-    if (currentState == STATE_WAIT_FILENAME) {
-        if (cleanInput.empty()) {
-            cout << "请输入文件名 (或输入 '自动' )：" << endl;
-            return true;
-        }
-        if (cleanInput == "自动" || toLower(cleanInput) == "auto") {
+        if (answer == "自动" || toLower(answer) == "auto") {
             logger->record("Action", "User triggered Auto-Generate");
             autoGenerateNames();
-            goto CHECK_EXTENSION; 
+            break;
         }
-        vector<string> newNames = parseNames(cleanInput);
+        vector<string> newNames = parseNames(answer);
         targetNames.insert(targetNames.end(), newNames.begin(), newNames.end());
         if ((int)targetNames.size() < targetCount) {
             int remain = targetCount - targetNames.size();
-            cout << "✅ 已记录，还需 " << remain << " 个文件名 (继续输入 / 批量输入 / 输入'自动'):" << endl;
-            return true; 
-        } else {
-            goto CHECK_EXTENSION;
+            sessionEvent(EventType::Prompt) << "✅ 已记录，还需 " << remain << " 个文件名 (继续输入 / 批量输入 / 输入'自动'):";
         }
     }
+    co_return true;
+}
 
-    // === 阶段 2: 处理后缀 ===
-    if (currentState == STATE_WAIT_EXTENSION) {
-        string ext = cleanInput;
-        if (ext.empty()) ext = ".txt"; 
+// 逐个补齐后缀，支持 'all .txt' 统一应用
+Task<bool> FileCreator::collectExtensions() {
+    string answer;
+    while (!checkAllExtensionsReady()) {
+        string problematicFile = targetNames[currentExtIndex];
+        sessionEvent(EventType::Info) << "🤔 文件 [" << problematicFile << "] 缺少后缀。";
+        sessionCandidates("请输入后缀 (如 .cpp)，或者输入 'all .txt' 统一应用：", commonExtensions,
+                          CandidateLayout::Inline);
+
+        if (!co_await readAnswer(answer)) co_return false;
+        string ext = answer;
 
         if (ext.find("all ") == 0 || ext.find("所有 ") == 0) {
             string uniExt = ext.substr(ext.find(" ") + 1);
@@ -360,107 +409,103 @@ bool FileCreator::processInput(string input) {
             if (ext[0] != '.') ext = "." + ext;
             if (currentExtIndex >= 0 && currentExtIndex < (int)targetNames.size()) {
                 targetNames[currentExtIndex] += ext;
-                cout << "✅ 文件 [" << targetNames[currentExtIndex] << "] 命名完成。" << endl;
+                sessionEvent(EventType::Info) << "✅ 文件 [" << targetNames[currentExtIndex] << "] 命名完成。";
                 logger->record("Action", "Renamed file index " + to_string(currentExtIndex) + " with ext: " + ext);
             }
         }
-        goto CHECK_EXTENSION;
     }
+    co_return true;
+}
 
-    // === 阶段 3: 路径 ===
-    if (currentState == STATE_WAIT_PATH) {
-        if (cleanInput.empty()) {
-            targetPathKey = "桌面";
-            logger->record("Action", "Default path used: Desktop");
-        } else {
-            targetPathKey = cleanInput;
+Task<bool> FileCreator::readPathKey() {
+    string answer;
+    if (!co_await readAnswer(answer)) co_return false;
+    targetPathKey = answer;
+    co_return true;
+}
+
+// 搜索路径 -> (结果太多先确认) -> 多选 -> 创建
+Task<bool> FileCreator::resolvePathAndCreate() {
+    string answer;
+    while (true) {
+        co_await searchPaths(targetPathKey);
+
+        if (candidatePaths.empty()) {
+            sessionEvent(EventType::Error) << "找不到类似 '" << targetPathKey << "' 的路径，请重新输入：";
+            targetPathKey = "";
+            if (!co_await readPathKey()) co_return false;
+            continue;
+        }
+        if (candidatePaths.size() == 1) {
+            co_await performCreateFile(candidatePaths[0]);
+            co_return true;
         }
-        goto HANDLE_EXECUTION;
-    }
 
-    // === 阶段 0: 初始入口 ===
-    if (currentState == STATE_IDLE) {
-        if (cleanInput.empty()) return false;
-        
-        // 2. 这里的判断使用前面定义的变量，安全
-        if (cleanInput.find("创建") != string::npos) isCreateCommand = true;
-        else if (cleanInput.find("建") != string::npos) isCreateCommand = true;
-        else if (cleanInput.find("搞") != string::npos) isCreateCommand = true;
-        else if (cleanInput.find("弄") != string::npos) isCreateCommand = true;
-        else if (cleanInput.find("整") != string::npos) isCreateCommand = true;
-
-        if (isCreateCommand) {
-            logger->clear(); 
-            logger->record("Session", "=== New Command Started ===");
-            logger->record("User Input", cleanInput);
-
-            if (!askAIForIntent(cleanInput)) {
-                targetCount = 1;
-                targetNames.clear();
-                currentState = STATE_WAIT_FILENAME;
-                cout << "收到创建指令。请问文件要叫什么名字？" << endl;
-                return true;
+        if (candidatePaths.size() > 10) {
+            sessionEvent(EventType::Prompt) << "⚠️  找到了 " << candidatePaths.size() << " 个匹配路径，是否全部显示？(y/n)";
+            if (!co_await readAnswer(answer)) co_return false;
+            if (!(answer == "y" || answer == "Y" || answer == "yes" || answer == "是")) {
+                sessionEvent(EventType::Prompt) << "已取消列表显示。请重新输入更精确的路径关键词：";
+                targetPathKey = "";
+                candidatePaths.clear();
+                if (!co_await readPathKey()) co_return false;
+                continue;
             }
+        }
+
+        sessionCandidates("🤔 找到多个位置，请选择：", candidatePaths);
 
-            if ((int)targetNames.size() < targetCount) {
-                currentState = STATE_WAIT_FILENAME;
-                int remain = targetCount - targetNames.size();
-                cout << "准备创建 " << targetCount << " 个文件。" << endl;
-                cout << "还缺 " << remain << " 个名字，请输入 (例如: a,b | 或输入 '自动'):" << endl;
-                return true;
+        while (true) {
+            if (!co_await readAnswer(answer)) co_return false;
+            int choice = -1;
+            try { choice = stoi(answer); } catch(...) {}
+            if (choice > 0 && choice <= (int)candidatePaths.size()) {
+                co_await performCreateFile(candidatePaths[choice-1]);
+                co_return true;
             }
-            
-            // 3. 这里的 goto 现在跳转到函数最外层，合法
-            goto CHECK_EXTENSION;
+            sessionEvent(EventType::Error) << "选项无效。";
         }
     }
+}
+
+Task<bool> FileCreator::processInput(string input) {
+    string cleanInput = trimString(input);
+    if (cleanInput.empty()) co_return false;
+
+    bool isCreateCommand = false;
+    if (cleanInput.find("创建") != string::npos) isCreateCommand = true;
+    else if (cleanInput.find("建") != string::npos) isCreateCommand = true;
+    else if (cleanInput.find("搞") != string::npos) isCreateCommand = true;
+    else if (cleanInput.find("弄") != string::npos) isCreateCommand = true;
+    else if (cleanInput.find("整") != string::npos) isCreateCommand = true;
 
     // 如果不是创建指令，返回 false 让 ShellAgent 处理
-    return false;
+    if (!isCreateCommand) co_return false;
 
-    // ==========================================
-    // 👇 公共逻辑区 (已提至函数主作用域) 👇
-    // ==========================================
+    logger->clear(); 
+    logger->record("Session", "=== New Command Started ===");
+    logger->record("User Input", cleanInput);
 
-    CHECK_EXTENSION:
-    if (!checkAllExtensionsReady()) {
-        currentState = STATE_WAIT_EXTENSION;
-        string problematicFile = targetNames[currentExtIndex];
-        cout << "🤔 文件 [" << problematicFile << "] 缺少后缀。" << endl;
-        cout << "请输入后缀 (如 .cpp)，或者输入 'all .txt' 统一应用：" << endl;
-        for (size_t i = 0; i < commonExtensions.size(); ++i) {
-                cout << "[" << (i + 1) << "] " << commonExtensions[i] << " ";
-        }
-        cout << endl;
-        return true;
+    // 中途用户离开 (exit / 断开) 时各步返回 false，这条指令就此作罢
+    if (!co_await askAIForIntent(cleanInput)) {
+        targetCount = 1;
+        targetNames.clear();
+        sessionEvent(EventType::Prompt) << "收到创建指令。请问文件要叫什么名字？";
+        if (!co_await collectNames()) co_return true;
+    } else if ((int)targetNames.size() < targetCount) {
+        int remain = targetCount - targetNames.size();
+        sessionEvent(EventType::Info) << "准备创建 " << targetCount << " 个文件。";
+        sessionEvent(EventType::Prompt) << "还缺 " << remain << " 个名字，请输入 (例如: a,b | 或输入 '自动'):";
+        if (!co_await collectNames()) co_return true;
     }
 
+    if (!co_await collectExtensions()) co_return true;
+
     if (targetPathKey.empty()) {
-        currentState = STATE_WAIT_PATH;
-        cout << "所有文件名已就绪，请问放在哪里？(支持模糊搜索，例如 'test' 或 '/home/user/...')" << endl;
-        return true;
+        sessionEvent(EventType::Prompt) << "所有文件名已就绪，请问放在哪里？(支持模糊搜索，例如 'test' 或 '/home/user/...')";
+        if (!co_await readPathKey()) co_return true;
     }
 
-    HANDLE_EXECUTION:
-    searchPaths(targetPathKey);
-    
-    if (candidatePaths.empty()) {
-        cout << "[ERROR] 找不到类似 '" << targetPathKey << "' 的路径，请重新输入：" << endl;
-        targetPathKey = ""; 
-        currentState = STATE_WAIT_PATH;
-        return true;
-    } else if (candidatePaths.size() == 1) {
-        performCreateFile(candidatePaths[0]);
-    } else {
-        if (candidatePaths.size() > 10) {
-            currentState = STATE_WAIT_PATH_OVERFLOW_CONFIRM;
-            cout << "⚠️  找到了 " << candidatePaths.size() << " 个匹配路径，是否全部显示？(y/n)" << endl;
-        } else {
-            currentState = STATE_WAIT_SELECTION;
-            cout << "🤔 找到多个位置，请选择：" << endl;
-            for(size_t i=0; i<candidatePaths.size(); ++i)
-                cout << "[" << (i+1) << "] " << candidatePaths[i] << endl;
-        }
-    }
-    return true;
-}
\ No newline at end of file
+    co_await resolvePathAndCreate();
+    co_return true;
+}
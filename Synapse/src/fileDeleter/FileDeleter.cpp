@@ -1,4 +1,12 @@
 #include "FileDeleter.h"
+#include "HarvestedKnowledge.h"
+#include "SessionChannel.h"
+#include "EventLoop.h"
+#include "BackendScheduler.h"
+#include "BackendTrace.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -9,14 +17,30 @@
 namespace fs = std::filesystem;
 using namespace std;
 
-FileDeleter::FileDeleter() {
-    aiBrain = make_unique<LocalBrain>();
-    cloudBrain = make_unique<CloudBrain>();
+FileDeleter::FileDeleter(shared_ptr<SharedBrains> brains) {
+    aiBrain = brains->local;
+    cloudBrain = brains->cloud;
     trashManager = make_unique<TrashManager>();
     logger = make_unique<JudgmentLogger>();
     securityGuard = make_unique<SecurityGuard>();
 }
 
+// 检索到的样例和固定样例放在一起，最后以当前输入收尾：
+// 如果直接接在 "Out: " 前面，模型会照抄最近一条样例的目标，而不是从当前输入里抽
+string FileDeleter::extractionPrompt(const string& input, const string& dynamicShots) {
+    return
+        "Task: Extract target files.\n"
+        "Rules: Output filenames or paths only. Separated by '|'. No placeholders.\n"
+        "Samples:\n"
+        "In: 删除1.txt\nOut: 1.txt\n"
+        "In: 删了 /tmp/a.log\nOut: /tmp/a.log\n"
+        "In: 把a.txt删掉\nOut: a.txt\n"
+        + dynamicShots +
+        "\n"
+        "In: " + input + "\n"
+        "Out: ";
+}
+
 // ==========================================
 // [辅助] 提取输入中的路径上下文
 // 用于：用户只说了路径没说文件名的情况
@@ -41,19 +65,40 @@ string extractPathContext(const string& input) {
 // ==========================================
 // 1. 意图解析 (AI -> 增强正则 -> 暴力去词)
 // ==========================================
-bool FileDeleter::parseDeleteIntent(const string& input, vector<string>& rawTargets) {
-    // 🚀 1. 尝试用 AI 提取
-    string prompt = 
-        "Task: Extract target files.\n"
-        "Input: \"" + input + "\"\n"
-        "Rules: Output filenames or paths only. Separated by '|'. No placeholders.\n"
-        "Samples:\n"
-        "In: 删除1.txt\nOut: 1.txt\n"  
-        "In: 删了 /tmp/a.log\nOut: /tmp/a.log\n"
-        "In: 把a.txt删掉\nOut: a.txt\n"
-        "Out: "; 
+Task<bool> FileDeleter::parseDeleteIntent(string input, vector<string>& rawTargets) {
+    string result;
+
+    // ⚡ 0. 纠错记忆：审计修正过的同一句话直接用修正答案
+    CorrectionHit hit;
+    static Counter& memoryHits = Metrics::instance().counter("synapse_cache_lookups_total", "运行时缓存查询次数",
+                                                             "cache=\"correction_memory\",task=\"delete\",result=\"hit\"");
+    static Counter& memoryMisses = Metrics::instance().counter("synapse_cache_lookups_total", "运行时缓存查询次数",
+                                                               "cache=\"correction_memory\",task=\"delete\",result=\"miss\"");
+    bool remembered = HarvestedKnowledge::instance().corrections().lookup("DELETE", input, hit);
+    (remembered ? memoryHits : memoryMisses).inc();
+    if (remembered) {
+        sessionEvent(EventType::Thinking) << "⚡ 命中纠错记忆，跳过本地模型: " << hit.output;
+        logger->record("CorrectionMemory", "Hit (distance " + to_string(hit.distance) + "): " + hit.matchedInput + " -> " + hit.output);
+        result = hit.output;
+    } else {
+        // 🚀 1. 尝试用 AI 提取
+        // 动态 few-shot：附上最相似的几条已修正样本
+        vector<FewShotExample> shots = HarvestedKnowledge::instance().fewShots().query("DELETE", input);
+        string dynamicShots;
+        for (const auto& shot : shots) {
+            dynamicShots += "In: " + shot.input + "\nOut: " + shot.output + "\n";
+        }
+        if (!shots.empty()) {
+            logger->record("FewShot", "Retrieved " + to_string(shots.size()) + " corrected examples");
+        }
+
+        string prompt = extractionPrompt(input, dynamicShots);
 
-    string result = aiBrain->talk(prompt);
+        TraceSpan span("delete", "delete.extract");
+        BackendSlot slot = co_await scheduleBackend("local");
+        static const ModelProfile profile = BrainConfig::profile("local", "delete");
+        result = co_await offload([&] { return aiBrain->talk(prompt, &profile); });
+    }
     
     // 清洗结果
     result.erase(0, result.find_first_not_of(" \t\n\r"));
@@ -72,125 +117,149 @@ bool FileDeleter::parseDeleteIntent(const string& input, vector<string>& rawTarg
         }
     }
 
-    if (!rawTargets.empty()) return true;
+    if (!rawTargets.empty()) co_return true;
 
     // 🚀 2. 增强正则 (Regex Fallback)
     // 只有当 AI 失败时才启用
-    try {
-        // 模式1: 绝对路径
-        regex abs_path_pattern(R"(/[^ \t\n\r"']+)");
-        // 模式2: 明确的文件名 (xxx.xx)
-        regex filename_pattern(R"([a-zA-Z0-9_\u4e00-\u9fa5]+\.[a-zA-Z0-9]+)"); 
-
-        auto begin1 = sregex_iterator(input.begin(), input.end(), abs_path_pattern);
-        auto end1 = sregex_iterator();
-        for (auto i = begin1; i != end1; ++i) rawTargets.push_back(i->str());
-
-        auto begin2 = sregex_iterator(input.begin(), input.end(), filename_pattern);
-        auto end2 = sregex_iterator();
-        for (auto i = begin2; i != end2; ++i) rawTargets.push_back(i->str());
-    } catch (...) {}
+    rawTargets = extractTargetsByPattern(input);
 
-    if (!rawTargets.empty()) return true;
+    if (!rawTargets.empty()) co_return true;
 
     // 🚀 3. 暴力去词法
     // 如果还没找到，可能用户根本没输文件名，或者文件名很不规范（无后缀）
     // 这里我们先不暴力提取，因为可能是“意图明确但参数缺失”，留给 processInput 处理交互
     
-    return false; 
+    co_return false; 
+}
+
+vector<string> FileDeleter::extractTargetsByPattern(const string& input) {
+    // 正则只编译一次 (原来每次兜底都要重新编译两条)
+    // 模式1: 绝对路径
+    static const regex absPathPattern(R"(/[^ \t\n\r"']+)");
+    // 模式2: 明确的文件名 (xxx.xx)。std::regex 按字节匹配，\u4e00-\u9fa5 在 char 上会直接抛异常，
+    // 导致整个兜底失效；这里用 UTF-8 多字节 (0x80-0xFF) 代表中文
+    static const regex filenamePattern("[a-zA-Z0-9_\x80-\xff]+\\.[a-zA-Z0-9]+");
+
+    vector<string> targets;
+    for (auto it = sregex_iterator(input.begin(), input.end(), absPathPattern); it != sregex_iterator(); ++it) {
+        targets.push_back(it->str());
+    }
+    for (auto it = sregex_iterator(input.begin(), input.end(), filenamePattern); it != sregex_iterator(); ++it) {
+        targets.push_back(it->str());
+    }
+    return targets;
 }
 
 // ... (searchFileInSystem 保持不变) ...
 vector<string> FileDeleter::searchFileInSystem(const string& filename) {
-    vector<string> candidates;
     // 智能处理：如果是相对路径，在当前目录或常用目录搜；如果是"桌面"，映射路径
     string searchPath = "/home/ubuntu";
     if (filename.find("桌面") == 0) searchPath = "/home/ubuntu/Desktop"; // 简单映射
+    return findFiles(filename, searchPath);
+}
 
-    string cmd = "find " + searchPath + " -maxdepth 4 -name \"" + filename + "\" 2>/dev/null";
-    
-    FILE* pipe = popen(cmd.c_str(), "r");
-    if (!pipe) return candidates;
-    char buffer[128];
-    while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
-        string path = buffer;
+vector<string> FileDeleter::findFiles(const string& filename, const string& root) {
+    TraceSpan span("search", "find.files");
+    static Histogram& latency = Metrics::instance().histogram("synapse_search_latency_seconds", "路径搜索耗时", "kind=\"files\"");
+    LatencyTimer timer(latency);
+    SYNAPSE_PROBE2(search_files_entry, filename.c_str(), root.c_str());
+    vector<string> candidates;
+    string cmd = "find " + root + " -maxdepth 4 -name \"" + filename + "\" 2>/dev/null";
+
+    // 经过 BackendTrace：录制时记下 find 的输出，回放时直接用
+    string output = BackendTrace::instance().call("find", cmd, [&] {
+        string lines;
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (!pipe) return lines;
+        char buffer[128];
+        while (fgets(buffer, sizeof(buffer), pipe) != NULL) lines += buffer;
+        pclose(pipe);
+        return lines;
+    });
+    istringstream lines(output);
+    string path;
+    while (getline(lines, path)) {
         path.erase(path.find_last_not_of(" \n\r") + 1);
         if (!path.empty()) candidates.push_back(path);
     }
-    pclose(pipe);
+    span.arg("candidates", candidates.size());
+    SYNAPSE_PROBE1(search_files_return, candidates.size());
     return candidates;
 }
 
 // ... (resolveTargetPaths 保持不变) ...
-vector<string> FileDeleter::resolveTargetPaths(const vector<string>& rawTargets) {
+Task<vector<string>> FileDeleter::resolveTargetPaths(vector<string> rawTargets) {
+    TraceSpan span("delete", "delete.resolve");
+    span.arg("targets", rawTargets.size());
     vector<string> resolvedPaths;
     for (const auto& target : rawTargets) {
         if (target.find("/") == 0) {
             if (fs::exists(target)) {
                 resolvedPaths.push_back(target);
             } else {
-                cout << "⚠️  找不到指定路径: " << target << " (已忽略)" << endl;
+                sessionEvent(EventType::Error) << "⚠️  找不到指定路径: " << target << " (已忽略)";
                 logger->record("Resolution", "Path not found: " + target);
             }
             continue;
         }
-        cout << "[System] 正在定位文件 [" << target << "] ..." << endl;
-        vector<string> candidates = searchFileInSystem(target);
+        sessionEvent(EventType::Progress) << "[System] 正在定位文件 [" << target << "] ...";
+        // find 可能要好几秒，放到阻塞线程池里跑
+        vector<string> candidates = co_await offload([&] { return searchFileInSystem(target); });
 
         if (candidates.empty()) {
-            cout << "❌ 未找到名为 [" << target << "] 的文件。" << endl;
+            sessionEvent(EventType::Error) << "❌ 未找到名为 [" << target << "] 的文件。";
             logger->record("Resolution", "File not found: " + target);
         } else if (candidates.size() == 1) {
-            cout << "✅ 已定位: " << candidates[0] << endl;
+            sessionEvent(EventType::Progress) << "✅ 已定位: " << candidates[0];
             resolvedPaths.push_back(candidates[0]);
         } else {
-            cout << "🤔 找到多个 [" << target << "]，请选择要删除哪一个：" << endl;
-            for (size_t i = 0; i < candidates.size(); ++i) {
-                cout << " [" << (i + 1) << "] " << candidates[i] << endl;
-            }
-            cout << " [0] 跳过此文件" << endl;
-            cout << "请输入序号: ";
+            sessionCandidates("🤔 找到多个 [" + target + "]，请选择要删除哪一个：", candidates,
+                              CandidateLayout::IndentedLines, "跳过此文件");
+            sessionEvent(EventType::Prompt) << "请输入序号: ";
+            string choiceLine;
             int choice;
-            if (cin >> choice) {
+            if (co_await sessionReadLine(choiceLine) && (istringstream(choiceLine) >> choice)) {
                 if (choice > 0 && static_cast<size_t>(choice) <= candidates.size()) {
                     resolvedPaths.push_back(candidates[choice - 1]);
                     logger->record("Resolution", "User selected: " + candidates[choice - 1]);
-                } else { cout << "已跳过。" << endl; }
+                } else { sessionEvent(EventType::Info) << "已跳过。"; }
             }
-            cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n');
         }
     }
-    return resolvedPaths;
+    co_return resolvedPaths;
 }
 
 // ... (getUserConfirmation 保持不变) ...
-bool FileDeleter::getUserConfirmation(const vector<string>& finalPaths) {
-    if (finalPaths.empty()) return false;
+Task<bool> FileDeleter::getUserConfirmation(vector<string> finalPaths) {
+    if (finalPaths.empty()) co_return false;
     bool hasDirectory = false;
     for (const auto& path : finalPaths) {
         if (fs::is_directory(path)) { hasDirectory = true; break; }
     }
-    cout << "\n================ 🗑️ 删除确认 ================" << endl;
+    // 确认单整体作为一个事件，GUI 可以整块渲染
+    ostringstream summary;
+    summary << "\n================ 🗑️ 删除确认 ================\n";
     if (hasDirectory) {
-        cout << "🔴 警告：检测到列表中包含【文件夹】！" << endl;
-        cout << "🔴 删除文件夹将移除其内部所有文件！" << endl;
+        summary << "🔴 警告：检测到列表中包含【文件夹】！\n";
+        summary << "🔴 删除文件夹将移除其内部所有文件！\n";
     }
-    cout << "即将把以下 " << finalPaths.size() << " 项移入回收站：" << endl;
+    summary << "即将把以下 " << finalPaths.size() << " 项移入回收站：\n";
     for (const auto& path : finalPaths) {
-        if (fs::is_directory(path)) cout << " 📁 " << path << endl;
-        else cout << " 📄 " << path << endl;
+        if (fs::is_directory(path)) summary << " 📁 " << path << "\n";
+        else summary << " 📄 " << path << "\n";
     }
-    cout << "============================================" << endl;
-    cout << "❓ 确认执行吗？(y/n): ";
+    summary << "============================================";
+    sessionEvent(EventType::Info) << summary.str();
+    sessionEvent(EventType::Prompt) << "❓ 确认执行吗？(y/n): ";
     string input;
-    getline(cin, input);
+    co_await sessionReadLine(input);
     if (input == "y" || input == "Y") {
         logger->record("Interaction", "User CONFIRMED deletion.");
-        return true;
+        co_return true;
     } else {
         logger->record("Interaction", "User CANCELLED deletion.");
-        cout << "操作已取消。" << endl;
-        return false;
+        sessionEvent(EventType::Info) << "操作已取消。";
+        co_return false;
     }
 }
 
@@ -201,20 +270,25 @@ void FileDeleter::executeDelete(const vector<string>& finalPaths) {
     for (const auto& path : finalPaths) {
         string virtualCmd = "rm " + path; 
         if (fs::is_directory(path)) virtualCmd += " -rf"; 
-        if (!securityGuard->check(virtualCmd)) {
-            cout << "🛡️ [拦截] SecurityGuard 拒绝删除: " << path << endl;
+        bool allowed;
+        {
+            TraceSpan span("delete", "security.check");
+            allowed = securityGuard->check(virtualCmd);
+        }
+        if (!allowed) {
+            sessionEvent(EventType::Error) << "🛡️ [拦截] SecurityGuard 拒绝删除: " << path;
             logger->record("Security", "⛔ BLOCKED: " + path);
             failCount++;
             continue;
         }
-        cout << "[Action] 正在移入回收站: " << path << " ..." << endl;
+        sessionEvent(EventType::Progress) << "[Action] 正在移入回收站: " << path << " ...";
         pair<bool, string> result = trashManager->moveToTrash(path);
         if (result.first) {
-            cout << "✅ " << result.second << endl;
+            sessionEvent(EventType::Result) << "✅ " << result.second;
             logger->record("Execution", "Success: " + path);
             successCount++;
         } else {
-            cout << "❌ " << result.second << endl;
+            sessionEvent(EventType::Error) << "❌ " << result.second;
             logger->record("Execution", "Failed: " + result.second);
             failCount++;
         }
@@ -226,7 +300,7 @@ void FileDeleter::executeDelete(const vector<string>& finalPaths) {
 // ==========================================
 // 主流程 (新增：多轮追问逻辑)
 // ==========================================
-bool FileDeleter::processInput(string input) {
+Task<bool> FileDeleter::processInput(string input) {
     logger->clear();
     logger->record("TaskType", "DELETE_OPERATION");
     logger->record("User Input", input);
@@ -234,24 +308,24 @@ bool FileDeleter::processInput(string input) {
     vector<string> rawTargets;
     
     // 1. 尝试提取意图
-    bool hasTargets = parseDeleteIntent(input, rawTargets);
+    bool hasTargets = co_await parseDeleteIntent(input, rawTargets);
 
     // ✨✨✨ 核心逻辑：如果没提取到文件名，启动追问模式 ✨✨✨
     if (!hasTargets) {
-        cout << "🤔 明白您想删除文件，但没听清具体是哪个。" << endl;
+        sessionEvent(EventType::Info) << "🤔 明白您想删除文件，但没听清具体是哪个。";
         
         // 尝试从原句中提取路径上下文 (例如 "在 /tmp 下删除...")
         string contextPath = extractPathContext(input);
         
         if (!contextPath.empty()) {
-            cout << "📂 您是指在目录 [" << contextPath << "] 下删除吗？" << endl;
-            cout << "👉 请输入该目录下的文件名 (如: data.log): ";
+            sessionEvent(EventType::Prompt) << "📂 您是指在目录 [" << contextPath << "] 下删除吗？\n"
+                                            << "👉 请输入该目录下的文件名 (如: data.log): ";
         } else {
-            cout << "👉 请输入完整路径或文件名: ";
+            sessionEvent(EventType::Prompt) << "👉 请输入完整路径或文件名: ";
         }
 
         string supplement;
-        getline(cin, supplement); // 获取用户补充输入
+        co_await sessionReadLine(supplement); // 获取用户补充输入
 
         if (!supplement.empty()) {
             logger->record("Interaction", "User supplemented: " + supplement);
@@ -265,23 +339,23 @@ bool FileDeleter::processInput(string input) {
                 if (fullPath.back() != '/') fullPath += "/";
                 fullPath += supplement;
                 
-                cout << "[System] 自动组合路径: " << fullPath << endl;
+                sessionEvent(EventType::Info) << "[System] 自动组合路径: " << fullPath;
                 rawTargets.push_back(fullPath);
             } else {
                 // 用户输入了全新内容，直接作为目标
                 rawTargets.push_back(supplement);
             }
         } else {
-            cout << "操作已取消。" << endl;
+            sessionEvent(EventType::Info) << "操作已取消。";
         }
     }
 
     // Step 2: 路径补全 (对 targets 进行最终检索)
     if (!rawTargets.empty()) {
-        vector<string> finalPaths = resolveTargetPaths(rawTargets);
+        vector<string> finalPaths = co_await resolveTargetPaths(rawTargets);
         if (!finalPaths.empty()) {
             // Step 3: 用户确认
-            if (getUserConfirmation(finalPaths)) {
+            if (co_await getUserConfirmation(finalPaths)) {
                 // Step 4: 执行
                 executeDelete(finalPaths);
             }
@@ -293,6 +367,6 @@ bool FileDeleter::processInput(string input) {
     }
 
     // 上传日志
-    logger->finalizeSession(cloudBrain.get());
-    return true; 
+    co_await logger->finalizeSession(cloudBrain.get());
+    co_return true; 
 }
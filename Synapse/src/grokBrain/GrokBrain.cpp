@@ -3,6 +3,13 @@
 #include <curl/curl.h>
 #include <sstream>
 #include <iomanip>
+#include "BrainConfig.h"
+#include "BackendTrace.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Probes.h"
+#include "UsageLedger.h"
+#include "SingleFlight.h"
 
 using namespace std;
 
@@ -10,16 +17,17 @@ GrokBrain::GrokBrain() {
     // ==========================================
     // 🔧 配置区域
     // ==========================================
-    this->apiKey = "灵芽密钥"; // 你的 Key
-    // 确保 URL 完整且正确
-    this->apiUrl = "https://api.lingyaai.cn/v1/chat/completions"; 
-    this->modelName = "grok-4-1-fast-non-reasoning"; // 或 gpt-4o-mini 等
+    // 默认值在 BrainConfig.cpp，可用 SYNAPSE_GROK_KEY / SYNAPSE_GROK_URL / SYNAPSE_GROK_MODEL 覆盖
+    BrainEndpoint endpoint = BrainConfig::grok();
+    this->apiKey = endpoint.apiKey; // 你的 Key
+    this->apiUrl = endpoint.url;
+    this->modelName = endpoint.model; // 或 gpt-4o-mini 等
 }
 
 GrokBrain::~GrokBrain() {}
 
 // 🛡️ [新增] JSON 转义函数：专门处理换行符和引号
-std::string jsonEscape(const std::string& input) {
+std::string GrokBrain::jsonEscape(const std::string& input) {
     std::ostringstream ss;
     for (char c : input) {
         switch (c) {
@@ -49,6 +57,23 @@ size_t GrokBrain::WriteCallback(void* contents, size_t size, size_t nmemb, strin
 }
 
 string GrokBrain::think(const string& prompt) {
+    TraceSpan span("brain", "grok.think");
+    span.arg("prompt_bytes", prompt.size());
+    static CallMetrics metrics = CallMetrics::make("synapse_brain", "brain=\"grok\"");
+    metrics.calls.inc();
+    string response;
+    {
+        LatencyTimer timer(metrics.latency);
+        response = BackendTrace::instance().call("grok", prompt, [&] {
+            return SingleFlight::instance().run("grok", prompt, [&] { return request(prompt); });
+        });
+    }
+    // sendRequest 失败时返回空串
+    if (response.empty()) metrics.errors.inc();
+    return response;
+}
+
+string GrokBrain::request(const string& prompt) {
     // 🛡️ [调用] 在构造 JSON 前先转义
     string safePrompt = jsonEscape(prompt);
 
@@ -66,8 +91,9 @@ string GrokBrain::think(const string& prompt) {
 
 string GrokBrain::sendRequest(const string& jsonBody) {
     CURL* curl;
-    CURLcode res;
+    CURLcode res = CURLE_FAILED_INIT;
     string readBuffer;
+    SYNAPSE_PROBE1(grok_request_entry, jsonBody.size());
 
     curl = curl_easy_init();
     if (curl) {
@@ -84,15 +110,19 @@ string GrokBrain::sendRequest(const string& jsonBody) {
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
         curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L); 
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // 多线程下超时不能靠 SIGALRM
 
         res = curl_easy_perform(curl);
 
         if (res != CURLE_OK) {
             cerr << "[GrokBrain] Request failed: " << curl_easy_strerror(res) << endl;
+        } else {
+            UsageLedger::instance().recordResponse("grok", readBuffer);
         }
 
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
     }
+    SYNAPSE_PROBE2(grok_request_return, readBuffer.size(), static_cast<int>(res));
     return readBuffer; 
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "IntentClassifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+using namespace std;
+
+const char* const IntentClassifier::LABELS[NUM_CLASSES] = {"CREATE", "DELETE", "OTHER"};
+
+// 模型文件头："SYNI" + 版本号
+// v2 起 trained 只计不同样本，并带留出准确率；v1 的计数被多轮冷启动放大过，不再加载 (从日志重新冷启动)
+// v3 加上每类的样本数和留出准确率；旧模型没有这些统计，同样重新冷启动
+static const char MODEL_MAGIC[4] = {'S', 'Y', 'N', 'I'};
+static const uint32_t MODEL_VERSION = 3;
+
+// 留出准确率按最近这么多条样本滑动 (不足时就是简单平均)
+static const uint64_t ACCURACY_WINDOW = 100;
+
+static uint32_t hashGram(const uint32_t* cps, size_t n) {
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= cps[i];
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    return static_cast<uint32_t>(h) & (IntentClassifier::NUM_BUCKETS - 1);
+}
+
+IntentClassifier::IntentClassifier() : weights(static_cast<size_t>(NUM_BUCKETS) * NUM_CLASSES, 0.0f) {}
+
+void IntentClassifier::features(string_view text, vector<uint32_t>& out) {
+    out.clear();
+    thread_local vector<uint32_t> cps;
+    cps.clear();
+    cps.push_back(0x02); // 句首标记，让 "删..." 开头和句中 "删" 区分开
+
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = text[i];
+        uint32_t cp;
+        size_t len;
+        if (c < 0x80) { cp = c; len = 1; }
+        else if ((c >> 5) == 0x6) { cp = c & 0x1F; len = 2; }
+        else if ((c >> 4) == 0xE) { cp = c & 0x0F; len = 3; }
+        else if ((c >> 3) == 0x1E) { cp = c & 0x07; len = 4; }
+        else { i++; continue; }
+        if (i + len > text.size()) break;
+        for (size_t k = 1; k < len; ++k) cp = (cp << 6) | (text[i + k] & 0x3F);
+        i += len;
+
+        if (cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == 0x3000) continue;
+        if (cp >= 'A' && cp <= 'Z') cp += 'a' - 'A';
+        cps.push_back(cp);
+    }
+    cps.push_back(0x03); // 句尾标记
+
+    for (size_t i = 0; i < cps.size(); ++i) {
+        for (size_t n = 1; n <= 3 && i + n <= cps.size(); ++n) {
+            out.push_back(hashGram(&cps[i], n));
+        }
+    }
+}
+
+int IntentClassifier::labelIndex(const string& label) {
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        if (label == LABELS[c]) return c;
+    }
+    return -1;
+}
+
+void IntentClassifier::scores(const vector<uint32_t>& feats, array<double, NUM_CLASSES>& probs) const {
+    // 特征值取 1/sqrt(n)，长短句的分数尺度一致
+    double x = feats.empty() ? 0.0 : 1.0 / sqrt(static_cast<double>(feats.size()));
+    array<double, NUM_CLASSES> z;
+    for (int c = 0; c < NUM_CLASSES; ++c) z[c] = bias[c];
+    for (uint32_t f : feats) {
+        const float* w = &weights[static_cast<size_t>(f) * NUM_CLASSES];
+        for (int c = 0; c < NUM_CLASSES; ++c) z[c] += w[c] * x;
+    }
+
+    double maxZ = z[0];
+    for (int c = 1; c < NUM_CLASSES; ++c) maxZ = max(maxZ, z[c]);
+    double sum = 0.0;
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        probs[c] = exp(z[c] - maxZ);
+        sum += probs[c];
+    }
+    for (int c = 0; c < NUM_CLASSES; ++c) probs[c] /= sum;
+}
+
+IntentPrediction IntentClassifier::predict(string_view text) const {
+    thread_local vector<uint32_t> feats;
+    features(text, feats);
+
+    array<double, NUM_CLASSES> probs;
+    {
+        shared_lock<shared_mutex> lock(mtx);
+        scores(feats, probs);
+    }
+
+    int best = 0;
+    for (int c = 1; c < NUM_CLASSES; ++c) {
+        if (probs[c] > probs[best]) best = c;
+    }
+    IntentPrediction pred;
+    pred.label = LABELS[best];
+    pred.confidence = probs[best];
+    return pred;
+}
+
+void IntentClassifier::update(string_view text, const string& label, double learningRate, bool newExample) {
+    int y = labelIndex(label);
+    if (y < 0) return;
+
+    thread_local vector<uint32_t> feats;
+    features(text, feats);
+    double x = feats.empty() ? 0.0 : 1.0 / sqrt(static_cast<double>(feats.size()));
+
+    unique_lock<shared_mutex> lock(mtx);
+    array<double, NUM_CLASSES> probs;
+    scores(feats, probs);
+
+    if (newExample) {
+        // 梯度之前的 probs 就是模型对一条没见过的样本的预测
+        int best = 0;
+        for (int c = 1; c < NUM_CLASSES; ++c) {
+            if (probs[c] > probs[best]) best = c;
+        }
+        double hit = best == y ? 1.0 : 0.0;
+        evaluated++;
+        accuracy += (hit - accuracy) / static_cast<double>(min(evaluated, ACCURACY_WINDOW));
+        classTrained[y]++;
+        classAccuracy[y] += (hit - classAccuracy[y]) / static_cast<double>(min(classTrained[y], ACCURACY_WINDOW));
+        trained++;
+    }
+
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        double grad = probs[c] - (c == y ? 1.0 : 0.0);
+        bias[c] -= static_cast<float>(learningRate * grad);
+        float step = static_cast<float>(learningRate * grad * x);
+        for (uint32_t f : feats) weights[static_cast<size_t>(f) * NUM_CLASSES + c] -= step;
+    }
+}
+
+bool IntentClassifier::labelFor(const TrainingExample& ex, string& text, string& label) {
+    text = ex.userInput.empty() ? ex.input : ex.userInput;
+    if (text.empty()) return false;
+
+    if (ex.type == "ROUTER_CORRECTION") {
+        if (ex.outputIsNull) return false;
+        for (const char* l : LABELS) {
+            if (ex.output.find(l) != string::npos) {
+                label = l;
+                return true;
+            }
+        }
+        return false;
+    }
+    // 评分 > 0 或给出了执行修正，都说明意图本身分对了
+    if (ex.type == "EXEC_CORRECTION" || ex.score > 0) {
+        label = ex.taskType;
+        return true;
+    }
+    return false;
+}
+
+bool IntentClassifier::save(const string& path) const {
+    shared_lock<shared_mutex> lock(mtx);
+
+    // 只写非零权重：<桶号, 3 个 float>
+    vector<uint32_t> nonzero;
+    for (uint32_t b = 0; b < NUM_BUCKETS; ++b) {
+        const float* w = &weights[static_cast<size_t>(b) * NUM_CLASSES];
+        if (w[0] != 0.0f || w[1] != 0.0f || w[2] != 0.0f) nonzero.push_back(b);
+    }
+
+    string tmpPath = path + ".tmp";
+    ofstream out(tmpPath, ios::binary | ios::trunc);
+    if (!out.is_open()) return false;
+
+    uint32_t numClasses = NUM_CLASSES;
+    uint32_t numBuckets = NUM_BUCKETS;
+    uint32_t count = static_cast<uint32_t>(nonzero.size());
+    out.write(MODEL_MAGIC, sizeof(MODEL_MAGIC));
+    out.write(reinterpret_cast<const char*>(&MODEL_VERSION), sizeof(MODEL_VERSION));
+    out.write(reinterpret_cast<const char*>(&numClasses), sizeof(numClasses));
+    out.write(reinterpret_cast<const char*>(&numBuckets), sizeof(numBuckets));
+    out.write(reinterpret_cast<const char*>(&trained), sizeof(trained));
+    out.write(reinterpret_cast<const char*>(&evaluated), sizeof(evaluated));
+    out.write(reinterpret_cast<const char*>(&accuracy), sizeof(accuracy));
+    out.write(reinterpret_cast<const char*>(classTrained.data()), sizeof(uint64_t) * NUM_CLASSES);
+    out.write(reinterpret_cast<const char*>(classAccuracy.data()), sizeof(double) * NUM_CLASSES);
+    out.write(reinterpret_cast<const char*>(bias.data()), sizeof(float) * NUM_CLASSES);
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (uint32_t b : nonzero) {
+        out.write(reinterpret_cast<const char*>(&b), sizeof(b));
+        out.write(reinterpret_cast<const char*>(&weights[static_cast<size_t>(b) * NUM_CLASSES]),
+                  sizeof(float) * NUM_CLASSES);
+    }
+    out.close();
+    if (!out) return false;
+
+    // 先写临时文件再改名，进程中途退出也不会留下半个模型
+    return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool IntentClassifier::load(const string& path) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+
+    char magic[4];
+    uint32_t version = 0, numClasses = 0, numBuckets = 0, count = 0;
+    uint64_t trainedCount = 0, evaluatedCount = 0;
+    double savedAccuracy = 0;
+    array<uint64_t, NUM_CLASSES> savedClassTrained;
+    array<double, NUM_CLASSES> savedClassAccuracy;
+    array<float, NUM_CLASSES> newBias;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&numClasses), sizeof(numClasses));
+    in.read(reinterpret_cast<char*>(&numBuckets), sizeof(numBuckets));
+    in.read(reinterpret_cast<char*>(&trainedCount), sizeof(trainedCount));
+    in.read(reinterpret_cast<char*>(&evaluatedCount), sizeof(evaluatedCount));
+    in.read(reinterpret_cast<char*>(&savedAccuracy), sizeof(savedAccuracy));
+    in.read(reinterpret_cast<char*>(savedClassTrained.data()), sizeof(uint64_t) * NUM_CLASSES);
+    in.read(reinterpret_cast<char*>(savedClassAccuracy.data()), sizeof(double) * NUM_CLASSES);
+    in.read(reinterpret_cast<char*>(newBias.data()), sizeof(float) * NUM_CLASSES);
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || memcmp(magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0 || version != MODEL_VERSION ||
+        numClasses != NUM_CLASSES || numBuckets != NUM_BUCKETS || count > NUM_BUCKETS) {
+        return false;
+    }
+
+    vector<float> newWeights(static_cast<size_t>(NUM_BUCKETS) * NUM_CLASSES, 0.0f);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t b = 0;
+        in.read(reinterpret_cast<char*>(&b), sizeof(b));
+        if (!in || b >= NUM_BUCKETS) return false;
+        in.read(reinterpret_cast<char*>(&newWeights[static_cast<size_t>(b) * NUM_CLASSES]), sizeof(float) * NUM_CLASSES);
+    }
+    if (!in) return false;
+
+    unique_lock<shared_mutex> lock(mtx);
+    weights.swap(newWeights);
+    bias = newBias;
+    trained = trainedCount;
+    evaluated = evaluatedCount;
+    accuracy = savedAccuracy;
+    classTrained = savedClassTrained;
+    classAccuracy = savedClassAccuracy;
+    return true;
+}
+
+uint64_t IntentClassifier::trainedExamples() const {
+    shared_lock<shared_mutex> lock(mtx);
+    return trained;
+}
+
+double IntentClassifier::heldOutAccuracy() const {
+    shared_lock<shared_mutex> lock(mtx);
+    return accuracy;
+}
+
+uint64_t IntentClassifier::minClassExamples() const {
+    shared_lock<shared_mutex> lock(mtx);
+    return *min_element(classTrained.begin(), classTrained.end());
+}
+
+double IntentClassifier::minClassAccuracy() const {
+    shared_lock<shared_mutex> lock(mtx);
+    return *min_element(classAccuracy.begin(), classAccuracy.end());
+}
@@ -1,9 +1,19 @@
 #include "JudgmentLogger.h"
+#include "JudgmentParser.h"
+#include "DatasetLoader.h"
+#include "HarvestedKnowledge.h"
+#include "SessionChannel.h"
+#include "EventLoop.h"
+#include "BackendScheduler.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "UsageLedger.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -12,7 +22,8 @@ JudgmentLogger::JudgmentLogger() {}
 
 string JudgmentLogger::currentTimestamp() {
     auto now = time(nullptr);
-    auto tm = *localtime(&now);
+    struct tm tm;
+    localtime_r(&now, &tm);
     ostringstream oss;
     oss << put_time(&tm, "%Y-%m-%d_%H-%M-%S");
     return oss.str();
@@ -25,14 +36,81 @@ void JudgmentLogger::record(const string& actor, const string& action) {
     sessionLog << "[" << actor << "] " << action << endl;
 }
 
-void JudgmentLogger::finalizeSession(CloudBrain* cloudBrain) {
+// 审计结果和日志写盘共用一把锁：daemon 下多个会话可能在同一秒内写文件
+static mutex fileMutex;
+
+// 同一秒内文件名冲突时追加序号；调用方持有 fileMutex
+static string uniqueLogPath(const string& logDir, const string& timestamp) {
+    if (!fs::exists(logDir)) fs::create_directories(logDir);
+    string stem = logDir + "/log_" + timestamp;
+    string filename = stem + ".txt";
+    for (int seq = 1; fs::exists(filename); ++seq) {
+        filename = stem + "_" + to_string(seq) + ".txt";
+    }
+    return filename;
+}
+
+Task<void> JudgmentLogger::finalizeSession(CloudBrain* cloudBrain) {
     string finalLog = sessionLog.str();
-    if (finalLog.empty()) return;
+    clear(); // 清理内存，防止污染下一轮
+    if (finalLog.empty()) co_return;
+
+    // 审计是后台请求，排在交互请求后面。排队已满、DeepSeek 限速或日预算用完时不等，
+    // 日志先存进 deferred/，等额度恢复后由后面的审计顺带补上
+    BackendSlot slot = co_await BackendScheduler::instance().acquire("cloud", RequestPriority::Background);
+    string denied = slot ? "" : "queue_full";
+    if (!slot || !UsageLedger::instance().tryAcquire("cloud", &denied)) {
+        static Counter& deferred = Metrics::instance().counter("synapse_audits_total", "审计次数", "result=\"deferred\"");
+        deferred.inc();
+        unique_lock<mutex> fileLock(fileMutex);
+        string filename = uniqueLogPath(string("training_data/") + DatasetLoader::DEFERRED_DIR, currentTimestamp());
+        ofstream outfile(filename);
+        outfile << finalLog;
+        if (outfile.good()) {
+            sessionEvent(EventType::Info) << "[System] DeepSeek 审计延后 (" << denied << ")，日志暂存: " << filename;
+        } else {
+            cerr << "[Error] 无法保存日志文件。" << endl;
+        }
+        co_return;
+    }
+    co_await audit(cloudBrain, finalLog);
+
+    // 额度还有富余时，每轮顺带补审一条之前延后的日志 (最早的一条)，积压随使用慢慢消化
+    string backlog;
+    {
+        lock_guard<mutex> fileLock(fileMutex);
+        error_code ec;
+        fs::path oldest;
+        for (const auto& entry : fs::directory_iterator(string("training_data/") + DatasetLoader::DEFERRED_DIR, ec)) {
+            if (entry.path().extension() == ".txt" && (oldest.empty() || entry.path() < oldest)) oldest = entry.path();
+        }
+        if (!oldest.empty() && UsageLedger::instance().tryAcquire("cloud")) {
+            ifstream in(oldest);
+            stringstream content;
+            content << in.rdbuf();
+            backlog = content.str();
+            fs::remove(oldest, ec); // 先取走再审，别的会话不会重复补审
+            sessionEvent(EventType::Info) << "[System] 补审一条延后的日志: " << oldest.string();
+        }
+    }
+    if (!backlog.empty()) co_await audit(cloudBrain, backlog);
+}
 
-    cout << "\n[System] 正在请求 DeepSeek 审计本轮操作..." << endl;
+Task<void> JudgmentLogger::audit(CloudBrain* cloudBrain, const string& finalLog) {
+    TraceSpan span("audit", "audit");
+    span.arg("log_bytes", finalLog.size());
+    // 正在等 DeepSeek 的审计数 (daemon 下各会话并发审计，相当于审计队列深度)
+    static Gauge& inFlight = Metrics::instance().gauge("synapse_audits_in_flight", "进行中的审计数");
+    static Counter& saved = Metrics::instance().counter("synapse_audits_total", "审计次数", "result=\"saved\"");
+    static Counter& pruned = Metrics::instance().counter("synapse_audits_total", "审计次数", "result=\"pruned\"");
+    static Counter& failed = Metrics::instance().counter("synapse_audits_total", "审计次数", "result=\"write_failed\"");
+    inFlight.add(1);
+
+    sessionEvent(EventType::Progress) << "[System] 正在请求 DeepSeek 审计本轮操作...";
     
     // 1. 调用云端大脑进行判别
-    string judgment = cloudBrain->evaluateLog(finalLog);
+    string judgment = co_await offload([&] { return cloudBrain->evaluateLog(finalLog); }, RequestPriority::Background);
+    inFlight.add(-1);
     
     // 2. 构造完整存档内容
     stringstream fileContent;
@@ -41,22 +119,38 @@ void JudgmentLogger::finalizeSession(CloudBrain* cloudBrain) {
     fileContent << "========= DEEPSEEK JUDGMENT =========" << endl;
     fileContent << judgment << endl;
 
-    // 3. 写入文件
+    // 3. 近重复检查：同一簇的样本已经够多了，就归档到 pruned/，不进训练集
+    //    没被剔除的修正会立刻进入运行时索引 (few-shot 检索、纠错记忆、意图分类器)
     string logDir = "training_data";
-    if (!fs::exists(logDir)) fs::create_directory(logDir);
-    
-    string filename = logDir + "/log_" + currentTimestamp() + ".txt";
+    bool prunedSample = false;
+    TrainingExample example;
+    JudgmentParser::parseSession(fileContent.str(), example);
+    if (!example.userInput.empty()) {
+        DedupResult dedup = HarvestedKnowledge::instance().ingest(example);
+        if (dedup.verdict == DedupVerdict::Pruned) {
+            prunedSample = true;
+            logDir += string("/") + DatasetLoader::PRUNED_DIR;
+            sessionEvent(EventType::Info) << "[System] 近重复样本 (相似度 " << static_cast<int>(dedup.similarity * 100)
+                 << "%，簇 #" << dedup.clusterId << " 已有 " << dedup.clusterSize << " 个代表)，不再入库。";
+        }
+    }
+
+    // 4. 写入文件
+    TraceSpan writeSpan("audit", "audit.write");
+    unique_lock<mutex> fileLock(fileMutex);
+    string filename = uniqueLogPath(logDir, currentTimestamp());
     ofstream outfile(filename);
     if (outfile.is_open()) {
         outfile << fileContent.str();
         outfile.close();
-        cout << "[System] 审计完成。训练数据已保存至: " << filename << endl;
-        cout << ">>> 裁判意见: " << judgment << endl; // 把 AI 的评价打出来看看
+        fileLock.unlock();
+        (prunedSample ? pruned : saved).inc();
+        sessionEvent(EventType::Info) << "[System] 审计完成。训练数据已保存至: " << filename;
+        sessionEvent(EventType::Info) << ">>> 裁判意见: " << judgment; // 把 AI 的评价打出来看看
     } else {
+        failed.inc();
         cerr << "[Error] 无法保存日志文件。" << endl;
     }
-    
-    clear(); // 清理内存，防止污染下一轮
 }
 
 void JudgmentLogger::clear() {
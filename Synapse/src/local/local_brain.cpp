@@ -1,10 +1,23 @@
 #include "local_brain.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <iomanip>
 #include <curl/curl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "BrainConfig.h"
+#include "BackendTrace.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Probes.h"
+#include "UsageLedger.h"
+#include "SingleFlight.h"
+#include "BackendScheduler.h"
 
 using namespace std;
 
@@ -13,7 +26,7 @@ static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* use
     return size * nmemb;
 }
 
-static std::string escapeJsonString(const std::string& input) {
+std::string LocalBrain::jsonEscape(const std::string& input) {
     std::ostringstream ss;
     for (char c : input) {
         switch (c) {
@@ -35,7 +48,12 @@ static std::string escapeJsonString(const std::string& input) {
     return ss.str();
 }
 
-LocalBrain::LocalBrain() {}
+LocalBrain::LocalBrain() : warm(std::make_shared<WarmState>()) {
+    BrainEndpoint endpoint = BrainConfig::local();
+    apiUrl = endpoint.url;
+    modelName = endpoint.model;
+    keepAlive = endpoint.keepAlive;
+}
 LocalBrain::~LocalBrain() {}
 
 // ✨✨✨ 究极进化版解析器 ✨✨✨
@@ -90,45 +108,199 @@ std::string LocalBrain::extractResponse(const std::string& json) {
     return result;
 }
 
-std::string LocalBrain::talk(const std::string& prompt) {
-    CURL* curl;
-    CURLcode res;
-    std::string readBuffer;
+// Ollama 的 options 字段，profile 里没设的项不传
+static std::string ollamaOptions(const ModelProfile& profile, int numPredict) {
+    std::string options;
+    auto add = [&](const std::string& field) { options += (options.empty() ? "" : ", ") + field; };
+    if (numPredict > 0) add("\"num_predict\": " + std::to_string(numPredict));
+    if (profile.temperature >= 0) {
+        std::ostringstream temperature;
+        temperature << profile.temperature;
+        add("\"temperature\": " + temperature.str());
+    }
+    if (profile.numCtx > 0) add("\"num_ctx\": " + std::to_string(profile.numCtx));
+    if (!profile.stop.empty()) {
+        std::string stop;
+        for (const auto& s : profile.stop) stop += (stop.empty() ? "\"" : ", \"") + LocalBrain::jsonEscape(s) + "\"";
+        add("\"stop\": [" + stop + "]");
+    }
+    return options.empty() ? "" : ", \"options\": {" + options + "}";
+}
 
-    curl = curl_easy_init();
-    if(curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, "http://localhost:11434/api/generate");
-        
-        struct curl_slist *headers = NULL;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+std::string LocalBrain::talk(const std::string& prompt, const ModelProfile* profile) {
+    TraceSpan span("brain", "local.talk");
+    span.arg("prompt_bytes", prompt.size());
+    static CallMetrics metrics = CallMetrics::make("synapse_brain", "brain=\"local\"");
+    metrics.calls.inc();
+    // 没指定任务的调用按 "other" 处理 (未知任务只有模型名，不带生成参数)
+    static const ModelProfile other = BrainConfig::profile("local", "other");
+    if (!profile) profile = &other;
+    // 按任务再记一份，调 profile 时对比各任务 / 各模型的延迟
+    const CallMetrics& taskMetrics = *profile->metrics;
+    taskMetrics.calls.inc();
+    SYNAPSE_PROBE1(local_talk_entry, prompt.size());
+    std::string response;
+    {
+        LatencyTimer timer(metrics.latency);
+        LatencyTimer taskTimer(taskMetrics.latency);
+        // 录制 / 回放的键仍然是 prompt (旧轨迹照样能回放)；合并请求时模型不同不能算同一个请求
+        std::string key = profile->model + "\n" + prompt;
+        response = BackendTrace::instance().call("local", prompt, [&] {
+            return SingleFlight::instance().run("local", key, [&] { return request(prompt, *profile); });
+        });
+    }
+    bool failed = response.rfind("[Error", 0) == 0 || response.rfind("[Ollama Error", 0) == 0;
+    if (failed) {
+        metrics.errors.inc();
+        taskMetrics.errors.inc();
+    }
+    SYNAPSE_PROBE2(local_talk_return, response.size(), failed);
+    return response;
+}
 
-        std::string safePrompt = escapeJsonString(prompt);
-        // ⚠️ 确保你的模型名字正确，常用名: qwen2.5:1.5b, qwen:1.5b, qwen2:1.5b
-       // 新代码 (加上 -coder)
-        std::string jsonBody = "{\"model\": \"qwen2.5-coder:1.5b\", \"prompt\": \"" + safePrompt + "\", \"stream\": false}";
+// POST 一个 JSON 请求体，成功时 out 是原始响应
+static CURLcode postJson(const std::string& url, const std::string& body, long timeoutSec, std::string& out) {
+    CURL* curl = curl_easy_init();
+    if (!curl) return CURLE_FAILED_INIT;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
 
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, jsonBody.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); 
+    struct curl_slist *headers = NULL;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    // 经 synapse_gateway 时用来区分实例和优先级，直连 Ollama 会被忽略
+    static const std::string clientHeader = "X-Synapse-Client: " + std::to_string(getpid());
+    headers = curl_slist_append(headers, clientHeader.c_str());
+    headers = curl_slist_append(headers, currentRequestPriority() == RequestPriority::Background
+                                             ? "X-Synapse-Priority: background" : "X-Synapse-Priority: interactive");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
-        res = curl_easy_perform(curl);
-        
-        if(res != CURLE_OK) {
-            std::cerr << "curl error: " << curl_easy_strerror(res) << std::endl;
-            return "[Error: Connection failed]";
-        }
-        
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &out);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeoutSec);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // 多线程下超时不能靠 SIGALRM
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(headers);
+    return res;
+}
+
+std::string LocalBrain::request(const std::string& prompt, const ModelProfile& profile) {
+    std::string readBuffer;
+    std::string safePrompt = jsonEscape(prompt);
+    // ⚠️ 确保你的模型名字正确，常用名: qwen2.5-coder:1.5b, qwen2.5:1.5b, qwen:1.5b
+    std::string jsonBody = "{\"model\": \"" + profile.model + "\", \"prompt\": \"" + safePrompt + "\", \"stream\": false, "
+                           "\"keep_alive\": \"" + keepAlive + "\"" +
+                           ollamaOptions(profile, profile.numPredict) + "}";
+
+    CURLcode res = postJson(apiUrl, jsonBody, 30L, readBuffer);
+    if (res != CURLE_OK) {
+        std::cerr << "curl error: " << curl_easy_strerror(res) << std::endl;
+        return "[Error: Connection failed]";
     }
 
     if (readBuffer.empty()) return "[Error: Empty response]";
+    UsageLedger::instance().recordResponse("local", readBuffer);
 
     // ✨✨✨ 关键调试：打印 Ollama 到底回了什么 ✨✨✨
     // 如果再出错，请把这行打印出来的东西发给我，我一眼就能看出问题
     //std::cout << "[DEBUG-RAW-JSON] " << readBuffer << std::endl;
     
     return extractResponse(readBuffer);
-}
\ No newline at end of file
+}
+
+void LocalBrain::startWarmUp(const std::vector<WarmupTarget>& targets) {
+    const char* env = getenv("SYNAPSE_WARMUP");
+    bool disabled = (env && strcmp(env, "0") == 0) || BackendTrace::instance().replaying();
+    {
+        std::lock_guard<std::mutex> lock(warm->mtx);
+        if (warm->started) return;
+        warm->started = true;
+        // 不预热也算结束：已经登记的等待方不会再收到回调，之后也不再登记
+        if (disabled) {
+            warm->done = true;
+            warm->listeners.clear();
+            return;
+        }
+    }
+    // 线程里只用拷贝出来的配置和 shared_ptr 持有的状态，LocalBrain 先析构也不要紧
+    std::thread([state = warm, url = apiUrl, keep = keepAlive, targets] {
+        static Gauge& ready = Metrics::instance().gauge("synapse_brain_ready", "预热完成 (模型已驻留) 为 1", "brain=\"local\"");
+        static Histogram& loadLatency = Metrics::instance().histogram("synapse_brain_warmup_seconds", "预热耗时",
+                                                                      "brain=\"local\",phase=\"load\"");
+        static Histogram& primeLatency = Metrics::instance().histogram("synapse_brain_warmup_seconds", "预热耗时",
+                                                                       "brain=\"local\",phase=\"prime\"");
+        TraceSpan span("brain", "local.warmup");
+        WarmupReport report;
+        auto elapsedMs = [](std::chrono::steady_clock::time_point since) {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+        };
+
+        // 失败不中断：记下原因，其余目标照样预热
+        auto fail = [&](const std::string& step, CURLcode res, const std::string& reply) {
+            std::string reason = res != CURLE_OK ? curl_easy_strerror(res) : reply;
+            report.error += (report.error.empty() ? "" : "; ") + step + ": " + reason;
+        };
+        auto failed = [](CURLcode res, const std::string& reply) {
+            return res != CURLE_OK || reply.find("\"error\"") != std::string::npos;
+        };
+
+        // 1. 不带 prompt 的请求只把模型加载进内存，keep_alive 决定空闲多久后卸载 (num_ctx 也在加载时定下)
+        //    同一 (模型, num_ctx) 只加载一次；加载失败的组合不再预填
+        std::vector<std::pair<std::string, int>> loaded, unavailable;
+        auto start = std::chrono::steady_clock::now();
+        std::string reply;
+        for (const auto& target : targets) {
+            std::pair<std::string, int> key(target.profile.model, target.profile.numCtx);
+            if (std::find(loaded.begin(), loaded.end(), key) != loaded.end() ||
+                std::find(unavailable.begin(), unavailable.end(), key) != unavailable.end()) {
+                continue;
+            }
+            reply.clear();
+            CURLcode res = postJson(url, "{\"model\": \"" + key.first + "\", \"keep_alive\": \"" + keep + "\"" +
+                                             ollamaOptions(target.profile, 1) + "}", 300L, reply);
+            if (failed(res, reply)) {
+                fail("load " + key.first, res, reply);
+                unavailable.push_back(key);
+            } else {
+                loaded.push_back(key);
+            }
+        }
+        report.loadMs = elapsedMs(start);
+        loadLatency.record(static_cast<uint64_t>(report.loadMs * 1000));
+
+        // 2. 把各任务固定的 prompt 跑一遍 (只生成 1 个 token)：前缀进 KV 缓存，首次推理的额外开销也在这里付掉
+        if (!loaded.empty()) {
+            start = std::chrono::steady_clock::now();
+            for (const auto& target : targets) {
+                std::pair<std::string, int> key(target.profile.model, target.profile.numCtx);
+                if (std::find(loaded.begin(), loaded.end(), key) == loaded.end()) continue;
+                std::string options = ollamaOptions(target.profile, 1);
+                for (const auto& prompt : target.primePrompts) {
+                    reply.clear();
+                    CURLcode res = postJson(url, "{\"model\": \"" + key.first + "\", \"prompt\": \"" + jsonEscape(prompt) +
+                                                     "\", \"stream\": false, \"keep_alive\": \"" + keep + "\"" + options + "}",
+                                            120L, reply);
+                    if (failed(res, reply)) fail("prime " + target.profile.task, res, reply);
+                }
+            }
+            report.primeMs = elapsedMs(start);
+            primeLatency.record(static_cast<uint64_t>(report.primeMs * 1000));
+        }
+        report.ok = report.error.empty();
+        if (report.ok) ready.set(1);
+
+        std::vector<std::function<void(const WarmupReport&)>> listeners;
+        {
+            std::lock_guard<std::mutex> lock(state->mtx);
+            state->done = true;
+            listeners.swap(state->listeners);
+        }
+        for (auto& listener : listeners) listener(report);
+    }).detach();
+}
+
+void LocalBrain::onWarm(std::function<void(const WarmupReport&)> callback) {
+    std::lock_guard<std::mutex> lock(warm->mtx);
+    if (!warm->done) warm->listeners.push_back(std::move(callback));
+}
@@ -1,47 +1,207 @@
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <memory>
+#include <thread>
+#include <chrono>
 #include <unistd.h>
+#include <sys/resource.h>
+#include <curl/curl.h>
 
-// 只引入 Router
-#include "systemExecutor/SystemExecutor.h" 
+#include "session/SessionServer.h"
+#include "session/Session.h"
+#include "session/OutputWriter.h"
+#include "session/BatchRunner.h"
+#include "utils/BackendTrace.h"
+#include "utils/AllocStats.h"
+#include "utils/Tracer.h"
+#include "utils/Metrics.h"
+#include "utils/MetricsServer.h"
+#include "utils/UsageLedger.h"
 
 using namespace std;
 
-string globalTrim(const string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r");
-    if (string::npos == first) return "";
-    size_t last = str.find_last_not_of(" \t\n\r");
-    return str.substr(first, (last - first + 1));
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [--daemon [--metrics PORT|PATH] | --client | --batch FILE] [--socket PATH] [--protocol text|json] [--jobs N]\n"
+         << "       " << prog << " [--record TRACE | --replay TRACE [--replay-timing]] [--trace-out FILE]\n"
+         << "  (无参数)   从 stdin 读指令，单会话\n"
+         << "  --daemon   监听 Unix socket，每个连接一个独立会话，大脑与缓存共用\n"
+         << "  --client   连接到 daemon，转发 stdin / stdout\n"
+         << "  --socket   socket 路径 (默认 " << SessionServer::defaultSocketPath() << ")\n"
+         << "  --metrics  daemon 的 Prometheus 指标端点：端口号监听 127.0.0.1，否则为 Unix socket 路径 (默认 <socket>.metrics)\n"
+         << "  --protocol 输出协议：text (默认，给人看) / json (一行一个事件，给 GUI)\n"
+         << "  --batch    非交互批量模式：FILE 为 JSONL 指令文件 (- 表示 stdin)，每条指令输出一行 JSON 结果\n"
+         << "  --jobs     --batch 同时执行的指令数 (默认 " << EventLoop::DEFAULT_BLOCKING_THREADS << ")\n"
+         << "  --record   stdin 模式：把大脑回复、find 结果和用户输入录进 TRACE\n"
+         << "  --replay   按 TRACE 重跑会话，不连模型、不读 stdin，结束时报告 CPU 时间和分配次数\n"
+         << "  --replay-timing  回放时按录下的耗时等待后端，墙钟时间和原会话可比\n"
+         << "  --trace-out 阶段耗时 span 的导出文件 (Chrome / Perfetto JSON，默认 synapse_trace_<pid>.json)；\n"
+         << "             kill -USR1 <pid> 随时导出；指定时 stdin / --batch 模式退出时也导出" << endl;
 }
 
-int main() {
-    setbuf(stdout, NULL);
-    cout << "Synapse Core Started. PID: " << getpid() << endl;
+// 录制 / 回放结束时的资源报告，不同版本对同一个 trace 的结果可以直接对比
+static void reportUsage(chrono::steady_clock::time_point start) {
+    BackendTrace::instance().report(cerr);
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto ms = [](const timeval& tv) { return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0; };
+    AllocStats::Snapshot allocs = AllocStats::snapshot();
+    cerr << "[Trace] 墙钟 " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()
+         << " ms | CPU user " << ms(usage.ru_utime) << " ms, sys " << ms(usage.ru_stime)
+         << " ms | 分配 " << allocs.allocations << " 次, " << allocs.bytes / 1024 << " KB"
+         << " | 峰值 RSS " << usage.ru_maxrss << " KB" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool daemonMode = false;
+    bool clientMode = false;
+    string socketPath = SessionServer::defaultSocketPath();
+    SessionChannel::Protocol protocol = SessionChannel::Protocol::Text;
+    string batchFile;
+    size_t batchJobs = EventLoop::DEFAULT_BLOCKING_THREADS;
+    string recordFile;
+    string replayFile;
+    bool replayTiming = false;
+    string traceOut;
+    string metricsListen;
 
-    // ❌ 删掉这行：auto fileAgent = make_unique<FileCreator>();
-    
-    // ✅ 只保留这行：
-    auto systemAgent = make_unique<SystemExecutor>();
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--daemon") daemonMode = true;
+        else if (arg == "--client") clientMode = true;
+        else if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--batch" && i + 1 < argc) batchFile = argv[++i];
+        else if (arg == "--record" && i + 1 < argc) recordFile = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc) replayFile = argv[++i];
+        else if (arg == "--replay-timing") replayTiming = true;
+        else if (arg == "--trace-out" && i + 1 < argc) traceOut = argv[++i];
+        else if (arg == "--metrics" && i + 1 < argc) metricsListen = argv[++i];
+        else if (arg == "--jobs" && i + 1 < argc) {
+            try { batchJobs = stoul(argv[++i]); } catch (...) { batchJobs = 0; }
+            if (batchJobs == 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--protocol" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name == "json") protocol = SessionChannel::Protocol::JsonLines;
+            else if (name != "text") {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if ((daemonMode ? 1 : 0) + (clientMode ? 1 : 0) + (batchFile.empty() ? 0 : 1) > 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!metricsListen.empty() && !daemonMode) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // trace 按类别顺序对齐，只对单会话的 stdin 模式有意义
+    bool tracing = !recordFile.empty() || !replayFile.empty();
+    if (tracing && (daemonMode || clientMode || !batchFile.empty() || (!recordFile.empty() && !replayFile.empty()))) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    auto started = chrono::steady_clock::now();
+    if (tracing) AllocStats::enable();
+    if (!recordFile.empty() && !BackendTrace::instance().startRecording(recordFile)) {
+        cerr << "[Error] 无法写入 trace: " << recordFile << endl;
+        return 1;
+    }
+    if (!replayFile.empty() && !BackendTrace::instance().loadReplay(replayFile, replayTiming)) {
+        cerr << "[Error] 无法读取 trace: " << replayFile << endl;
+        return 1;
+    }
 
-    cout << "[System] Ready." << endl;
+    if (clientMode) return SessionServer::runClient(socketPath);
 
-    string line;
-    while (getline(cin, line)) {
-        if (line == "exit") break;
+    Tracer& tracer = Tracer::instance();
+    bool exportOnExit = !traceOut.empty();
+    if (traceOut.empty()) traceOut = "synapse_trace_" + to_string(getpid()) + ".json";
+    if (tracer.enabled()) tracer.installDumpSignal(traceOut);
+    // 指定了 --trace-out 时正常退出导出一次 (daemon 靠信号退出，用 SIGUSR1 导出)
+    auto exportSpans = [&] {
+        if (!exportOnExit || !tracer.enabled()) return;
+        if (tracer.writeChromeJson(traceOut)) cerr << "[Trace] span 已导出到 " << traceOut << endl;
+        else cerr << "[Error] 无法写入 span 文件: " << traceOut << endl;
+    };
 
-        string cleanLine = globalTrim(line);
-        if (cleanLine.empty()) continue;
+    // libcurl 的全局初始化不是线程安全的，必须在起任何线程之前做一次
+    curl_global_init(CURL_GLOBAL_DEFAULT);
 
-        // ❌ 删掉 fileAgent 的优先处理
-        
-        // ✅ 唯一的入口
-        if (systemAgent->processInput(cleanLine)) {
-            continue;
+    if (!batchFile.empty()) {
+        ifstream file;
+        if (batchFile != "-") {
+            file.open(batchFile);
+            if (!file.is_open()) {
+                cerr << "[Error] 无法打开批量指令文件: " << batchFile << endl;
+                curl_global_cleanup();
+                return 1;
+            }
         }
+        BatchRunner runner(SharedBrains::create(), batchJobs, EventLoop::defaultWorkers());
+        size_t failures = runner.run(batchFile == "-" ? cin : file, STDOUT_FILENO);
+        OutputWriter::instance().shutdown();
+        exportSpans();
+        Metrics::instance().writeSummary(cerr);
+        UsageLedger::instance().writeSummary(cerr);
+        curl_global_cleanup();
+        return failures == 0 ? 0 : 2;
+    }
 
-        cout << "[THINK] 无法理解该指令 (" << cleanLine << ")" << endl;
+    if (daemonMode) {
+        SessionServer server(socketPath, protocol);
+        if (!server.start()) return 1;
+        MetricsServer metrics(metricsListen.empty() ? socketPath + ".metrics" : metricsListen);
+        if (!metrics.start()) return 1;
+        server.run();
+        return 0;
     }
 
+    // 流水线：读线程只负责读 stdin -> 会话协程跑在事件循环上 -> 输出交给写线程
+    // 审计、搜索再慢也不会卡住读输入和往 GUI 送输出
+    // stdout 不再逐字节无缓冲写：输出在事件边界成块交给写线程
+    auto channel = make_unique<FdChannel>(STDOUT_FILENO);
+    channel->setProtocol(protocol);
+    SessionChannel::bind(channel.get());
+    sessionEvent(EventType::Info) << "Synapse Core Started. PID: " << getpid();
+    SessionChannel::bind(nullptr);
+
+    EventLoop loop;
+    auto session = make_shared<Session>(0, move(channel));
+    session->start(loop, SharedBrains::create(), [&loop] { loop.stop(); });
+
+    thread reader([session] {
+        BackendTrace& trace = BackendTrace::instance();
+        if (trace.replaying()) {
+            for (const auto& line : trace.recordedInputs()) session->deliver(line);
+        } else {
+            string line;
+            while (getline(cin, line)) {
+                trace.recordInput(line);
+                session->deliver(line);
+            }
+        }
+        session->close();
+    });
+    // 输入 exit 时会话先结束，读线程可能还卡在 getline 上，不等它
+    reader.detach();
+
+    loop.run();
+    OutputWriter::instance().shutdown(); // 把排队的输出写完再退出
+    if (tracing) reportUsage(started);
+    exportSpans();
+    Metrics::instance().writeSummary(cerr);
+    UsageLedger::instance().writeSummary(cerr);
+
+    curl_global_cleanup();
     return 0;
-}
\ No newline at end of file
+}
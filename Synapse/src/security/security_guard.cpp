@@ -1,7 +1,10 @@
 #include "security_guard.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include <iostream>
 #include <algorithm>
 #include <vector>
+#include <map>
 #include <cctype> // 必须加这个，不然 std::tolower 会报错
 
 using namespace std;
@@ -43,40 +46,53 @@ SecurityGuard::SecurityGuard() {
         "/home/ubuntu/documents",  // 保护文档
         "/home/ubuntu/downloads"   // 保护下载
     };
-    
-    cout << "[System] Security Guard initialized (Enhanced Mode)." << endl;
 }
 
 SecurityGuard::~SecurityGuard() {}
 
 bool SecurityGuard::check(const string& cmd) {
-    if (cmd.empty()) return false;
+    SYNAPSE_PROBE2(security_check_entry, cmd.c_str(), cmd.size());
+    const char* blocked = evaluate(cmd);
+    SYNAPSE_PROBE2(security_check_return, blocked == nullptr, blocked ? blocked : "");
+    // 原因都是字面量，按指针缓存在本线程，热路径不查注册表、不拼字符串
+    static thread_local map<const char*, Counter*> counters;
+    Counter*& counter = counters[blocked];
+    if (!counter) {
+        string labels = blocked ? string("verdict=\"blocked\",reason=\"") + blocked + "\"" : "verdict=\"allowed\"";
+        counter = &Metrics::instance().counter("synapse_security_verdicts_total", "SecurityGuard 判定次数", labels);
+    }
+    counter->inc();
+    return blocked == nullptr;
+}
+
+const char* SecurityGuard::evaluate(const string& cmd) {
+    if (cmd.empty()) return "empty";
 
     string lowerCmd = toLower(cmd);
 
     // 1. 检查指令是否有效
     if (cmd.find("UNKNOWN_CMD") != string::npos) {
         cerr << "[Security] 拦截：AI 无法生成有效指令。" << endl;
-        return false;
+        return "unknown_cmd";
     }
 
     // 2. 格式检查 (白名单)
     if (!isFormatValid(cmd)) {
         cerr << "[Security] 拦截：指令不在白名单中 (" << cmd << ")" << endl;
-        return false;
+        return "not_whitelisted";
     }
 
     // 3. 深度危险检查 (黑名单)
     if (containsDangerousPattern(cmd)) {
         cerr << "[Security] 🔴 严重警告：检测到毁灭性指令！已拦截！" << endl;
-        return false;
+        return "dangerous_pattern";
     }
 
     // 4. ✨ 专门针对删除命令的智能审查 ✨
     // 只有通过了这里的检查，才允许 SystemExecutor 去处理 (移入回收站)
     if (lowerCmd.find("rm ") == 0) {
         if (!isSafeDeletion(cmd)) {
-            return false; 
+            return "unsafe_deletion"; 
         }
     }
 
@@ -84,11 +100,11 @@ bool SecurityGuard::check(const string& cmd) {
     if (lowerCmd.find("mv ") == 0) {
         if (lowerCmd.find("/dev/null") != string::npos) {
             cerr << "[Security] 拦截：禁止将文件移动到黑洞。" << endl;
-            return false;
+            return "mv_to_dev_null";
         }
     }
 
-    return true; // 检查通过
+    return nullptr; // 检查通过
 }
 
 bool SecurityGuard::isFormatValid(const string& cmd) {
@@ -0,0 +1,181 @@
+#include "BackendScheduler.h"
+#include "BrainConfig.h"
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+static uint64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* priorityName(int priority) {
+    return priority == static_cast<int>(RequestPriority::Interactive) ? "interactive" : "background";
+}
+
+RequestPriority currentRequestPriority() {
+    return SessionChannel::current().isBackground() ? RequestPriority::Background : RequestPriority::Interactive;
+}
+
+// ==========================================
+// BackendSlot
+// ==========================================
+
+BackendSlot::BackendSlot(BackendSlot&& other) noexcept
+    : scheduler(other.scheduler), backend(other.backend), granted(other.granted), counted(other.counted) {
+    other.granted = false;
+}
+
+BackendSlot& BackendSlot::operator=(BackendSlot&& other) noexcept {
+    if (this != &other) {
+        if (granted && counted) scheduler->release(backend);
+        scheduler = other.scheduler;
+        backend = other.backend;
+        granted = other.granted;
+        counted = other.counted;
+        other.granted = false;
+    }
+    return *this;
+}
+
+BackendSlot::~BackendSlot() {
+    if (granted && counted) scheduler->release(backend);
+}
+
+// ==========================================
+// 调度器
+// ==========================================
+
+BackendScheduler& BackendScheduler::instance() {
+    static BackendScheduler scheduler;
+    return scheduler;
+}
+
+BackendScheduler::BackendScheduler() {
+    // 默认并发：Ollama 默认并行 4 路 (OLLAMA_NUM_PARALLEL)，云端 API 按账号限速，8 路足够
+    const pair<const char*, int> defaults[] = {{"local", 4}, {"cloud", 8}, {"grok", 8}};
+    Metrics& metrics = Metrics::instance();
+    for (size_t i = 0; i < size(defaults); ++i) {
+        Backend& backend = backends[i];
+        string prefix = BrainConfig::envPrefix(defaults[i].first);
+        backend.name = defaults[i].first;
+        backend.capacity = max(1, static_cast<int>(BrainConfig::envNumber(prefix + "_CONCURRENCY", defaults[i].second)));
+        backend.queueLimit = static_cast<size_t>(BrainConfig::envNumber(prefix + "_QUEUE", 256));
+
+        string labels = "backend=\"" + backend.name + "\"";
+        backend.inFlightGauge = &metrics.gauge("synapse_scheduler_in_flight", "正在进行的模型请求数", labels);
+        backend.rejected = &metrics.counter("synapse_scheduler_rejected_total", "排队已满被拒绝的后台请求数", labels);
+        for (int p = 0; p < 2; ++p) {
+            string withPriority = labels + ",priority=\"" + priorityName(p) + "\"";
+            backend.queueDepth[p] = &metrics.gauge("synapse_scheduler_queued", "等待并发名额的请求数", withPriority);
+            backend.wait[p] = &metrics.histogram("synapse_scheduler_wait_seconds", "等待并发名额的时间", withPriority);
+        }
+    }
+}
+
+size_t BackendScheduler::totalCapacity() const {
+    size_t total = 0;
+    for (const auto& backend : backends) total += backend.capacity;
+    return total;
+}
+
+BackendScheduler::Awaiter BackendScheduler::acquire(const string& backend, RequestPriority priority) {
+    for (int i = 0; i < 3; ++i) {
+        if (backends[i].name == backend) return Awaiter(*this, i, priority);
+    }
+    return Awaiter(*this, -1, priority);
+}
+
+bool BackendScheduler::Awaiter::await_ready() {
+    // 不在事件循环里 (离线工具、synapse_bench) 没有并发可言，直接放行
+    if (backend < 0 || EventLoop::current() == nullptr) {
+        state = State::Unscheduled;
+        return true;
+    }
+    return false;
+}
+
+bool BackendScheduler::Awaiter::await_suspend(coroutine_handle<> h) {
+    int p = static_cast<int>(priority);
+    Backend& b = scheduler.backends[backend];
+    lock_guard<mutex> lock(scheduler.mtx);
+    // 有名额且没有同级或更高优先级的请求在排队：直接放行
+    bool ahead = b.queued[0] > 0 || (priority == RequestPriority::Background && b.queued[1] > 0);
+    if (!ahead && b.inFlight < b.capacity) {
+        b.inFlight++;
+        b.inFlightGauge->set(b.inFlight);
+        b.wait[p]->record(0);
+        state = State::Granted;
+        return false;
+    }
+    if (priority == RequestPriority::Background && b.queued[p] >= b.queueLimit) {
+        b.rejected->inc();
+        state = State::Rejected;
+        return false;
+    }
+    handle = h;
+    loop = EventLoop::current();
+    strand = EventLoop::Strand::current();
+    channel = &SessionChannel::current();
+    sessionId = channel->id();
+    enqueuedNs = nowNs();
+    b.queues[p][sessionId].push_back(this);
+    b.queueDepth[p]->set(++b.queued[p]);
+    // 解锁之后随时可能被别的线程放行并恢复，不能再碰 this
+    return true;
+}
+
+BackendSlot BackendScheduler::Awaiter::await_resume() {
+    if (state == State::Rejected) return BackendSlot();
+    return BackendSlot(&scheduler, backend, state == State::Granted);
+}
+
+BackendScheduler::Awaiter* BackendScheduler::popNext(Backend& b) {
+    if (b.inFlight >= b.capacity) return nullptr;
+    for (int p = 0; p < 2; ++p) {
+        if (b.queued[p] == 0) continue;
+        // 从上次放行的会话之后开始轮转
+        auto& queues = b.queues[p];
+        auto it = queues.upper_bound(b.lastSession[p]);
+        if (it == queues.end()) it = queues.begin();
+        Awaiter* waiter = it->second.front();
+        it->second.pop_front();
+        b.lastSession[p] = it->first;
+        if (it->second.empty()) queues.erase(it);
+        b.queueDepth[p]->set(--b.queued[p]);
+        b.wait[p]->record((nowNs() - waiter->enqueuedNs) / 1000);
+        return waiter;
+    }
+    return nullptr;
+}
+
+void BackendScheduler::release(int backend) {
+    Backend& b = backends[backend];
+    vector<Awaiter*> granted;
+    {
+        lock_guard<mutex> lock(mtx);
+        b.inFlight--;
+        while (Awaiter* waiter = popNext(b)) {
+            b.inFlight++;
+            waiter->state = Awaiter::State::Granted;
+            granted.push_back(waiter);
+        }
+        b.inFlightGauge->set(b.inFlight);
+    }
+    for (Awaiter* waiter : granted) resume(waiter);
+}
+
+void BackendScheduler::resume(Awaiter* waiter) {
+    // 和 offload 一样回到会话自己的 Strand 上恢复
+    coroutine_handle<> h = waiter->handle;
+    if (waiter->strand) {
+        waiter->strand->post([h] { h.resume(); });
+    } else {
+        SessionChannel* channel = waiter->channel;
+        waiter->loop->post([h, channel] {
+            SessionChannel::bind(channel);
+            h.resume();
+            SessionChannel::bind(nullptr);
+        });
+    }
+}
@@ -0,0 +1,171 @@
+#include "BatchRunner.h"
+#include "SessionChannel.h"
+#include "OutputWriter.h"
+#include "SystemExecutor.h"
+#include "JsonUtil.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+struct BatchRunner::Job {
+    BatchCommand cmd;
+    MemoryChannel channel;
+    shared_ptr<EventLoop::Strand> strand;
+    chrono::steady_clock::time_point started;
+    double queuedMs = 0;
+    bool understood = false;
+};
+
+BatchRunner::BatchRunner(shared_ptr<SharedBrains> brains, size_t jobs, size_t workers)
+    : brains(move(brains)), jobs(jobs > 0 ? jobs : 1), workers(workers > 0 ? workers : 1) {}
+
+bool BatchRunner::parseCommand(const string& line, BatchCommand& cmd, string& error) {
+    if (JsonUtil::findObject(line).empty()) {
+        error = "not a JSON object";
+        return false;
+    }
+    if (!JsonUtil::extractString(line, "command", cmd.command) || cmd.command.empty()) {
+        error = "missing \"command\"";
+        return false;
+    }
+    JsonUtil::extractString(line, "id", cmd.id);
+    if (line.find("\"answers\"") != string::npos &&
+        !JsonUtil::extractStringArray(line, "answers", cmd.answers)) {
+        error = "\"answers\" must be an array of strings";
+        return false;
+    }
+    return true;
+}
+
+double BatchRunner::msSince(chrono::steady_clock::time_point t) const {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t).count();
+}
+
+// 一条指令 = 一个新的 SystemExecutor (会话状态独立，构造很轻：不打印横幅、不触发预热)，追问从预置的 answers 里读
+static Task<void> runCommand(shared_ptr<SharedBrains> brains, string command, bool& understood) {
+    SystemExecutor agent(brains);
+    understood = co_await agent.processInput(command);
+}
+
+void BatchRunner::startNext() {
+    while (true) {
+        shared_ptr<Job> job;
+        {
+            lock_guard<mutex> lock(scheduleMutex);
+            if (inFlight >= jobs || nextCommand >= commands.size()) return;
+            job = make_shared<Job>();
+            job->cmd = move(commands[nextCommand++]);
+            inFlight++;
+        }
+
+        job->channel.setProtocol(SessionChannel::Protocol::JsonLines);
+        job->channel.setSessionId(job->cmd.index);
+        job->channel.setBackground(true);
+        job->strand = make_shared<EventLoop::Strand>(*loop, &job->channel);
+        job->strand->post([this, job] {
+            job->started = chrono::steady_clock::now();
+            job->queuedMs = chrono::duration<double, milli>(job->started - batchStart).count();
+            for (const auto& answer : job->cmd.answers) job->channel.deliver(answer);
+            job->channel.close();
+            spawn(runCommand(brains, job->cmd.command, job->understood), [this, job] {
+                finishJob(job, job->understood);
+            });
+        });
+    }
+}
+
+void BatchRunner::finishJob(const shared_ptr<Job>& job, bool understood) {
+    double elapsedMs = msSince(job->started);
+    if (!understood) failures++;
+
+    // MemoryChannel 里是一行一个 JSON 事件，拼成数组
+    string events = job->channel.takeOutput();
+    while (!events.empty() && events.back() == '\n') events.pop_back();
+    for (char& c : events) {
+        if (c == '\n') c = ',';
+    }
+
+    // 每个事件相对指令开始的时间，和 events 一一对应
+    ostringstream eventMs;
+    eventMs << fixed << setprecision(1);
+    const auto& times = job->channel.lineTimes();
+    for (size_t i = 0; i < times.size(); ++i) {
+        if (i > 0) eventMs << ",";
+        eventMs << chrono::duration<double, milli>(times[i] - job->started).count();
+    }
+
+    size_t answersLeft = job->channel.pendingInput();
+    ostringstream record;
+    record << fixed << setprecision(1)
+           << "{\"index\":" << job->cmd.index
+           << ",\"id\":\"" << JsonUtil::escape(job->cmd.id) << "\""
+           << ",\"command\":\"" << JsonUtil::escape(job->cmd.command) << "\""
+           << ",\"understood\":" << (understood ? "true" : "false")
+           << ",\"answers_used\":" << (job->cmd.answers.size() - answersLeft)
+           << ",\"answers_left\":" << answersLeft
+           << ",\"starved\":" << (job->channel.inputStarved() ? "true" : "false")
+           << ",\"queued_ms\":" << job->queuedMs
+           << ",\"elapsed_ms\":" << elapsedMs
+           << ",\"events\":[" << events << "]"
+           << ",\"event_ms\":[" << eventMs.str() << "]}\n";
+    writeRecord(record.str());
+
+    bool done;
+    {
+        lock_guard<mutex> lock(scheduleMutex);
+        inFlight--;
+        done = inFlight == 0 && nextCommand >= commands.size();
+    }
+    if (done) loop->stop();
+    else startNext();
+}
+
+void BatchRunner::writeRecord(const string& record) {
+    OutputEvent event;
+    event.fd = outFd;
+    event.data = record;
+    OutputWriter::instance().push(move(event));
+}
+
+size_t BatchRunner::run(istream& in, int fd) {
+    outFd = fd;
+
+    string line;
+    size_t lineNo = 0;
+    while (getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == string::npos || line[first] == '#') continue;
+
+        BatchCommand cmd;
+        string error;
+        if (!parseCommand(line, cmd, error)) {
+            failures++;
+            writeRecord("{\"index\":" + to_string(lineNo) + ",\"error\":\"" + JsonUtil::escape(error) + "\"}\n");
+            continue;
+        }
+        cmd.index = lineNo;
+        commands.push_back(move(cmd));
+    }
+    if (commands.empty()) return failures;
+
+    size_t total = commands.size();
+    size_t rejected = failures;
+    // 模型调用都在阻塞线程池里，池子按并发指令数开，不然 jobs 再大也会排队等线程
+    loop = make_unique<EventLoop>(jobs);
+    SystemExecutor::warmUp(brains);
+    batchStart = chrono::steady_clock::now();
+    startNext();
+    loop->run(workers);
+
+    double seconds = msSince(batchStart) / 1000.0;
+    cerr << "[Batch] " << total << " 条指令, " << (total - (failures - rejected)) << " 条被理解, 用时 "
+         << fixed << setprecision(2) << seconds << " s ("
+         << (seconds > 0 ? total / seconds : 0.0) << " 条/秒, jobs=" << jobs << ", workers=" << workers << ")" << endl;
+
+    loop.reset();
+    return failures;
+}
@@ -0,0 +1,163 @@
+#include "EventLoop.h"
+
+using namespace std;
+
+static thread_local EventLoop* runningLoop = nullptr;
+static thread_local EventLoop::Strand* runningStrand = nullptr;
+
+// 一个 Strand 连续执行的任务上限，防止一个忙碌的会话霸占工作线程
+static const size_t STRAND_BATCH = 64;
+
+// ==========================================
+// Strand
+// ==========================================
+
+EventLoop::Strand* EventLoop::Strand::current() {
+    return runningStrand;
+}
+
+void EventLoop::Strand::post(function<void()> fn) {
+    bool needSchedule = false;
+    {
+        lock_guard<mutex> lock(mtx);
+        tasks.push_back(move(fn));
+        if (!scheduled) {
+            scheduled = true;
+            needSchedule = true;
+        }
+    }
+    // 同一时刻只有一个 runBatch 在跑，这就是串行保证
+    if (needSchedule) loop.post([self = shared_from_this()] { self->runBatch(); });
+}
+
+void EventLoop::Strand::runBatch() {
+    Strand* previousStrand = runningStrand;
+    runningStrand = this;
+    SessionChannel::bind(channel);
+
+    bool drained = false;
+    for (size_t i = 0; i < STRAND_BATCH && !drained; ++i) {
+        function<void()> fn;
+        {
+            lock_guard<mutex> lock(mtx);
+            if (tasks.empty()) {
+                // 清掉 scheduled 之后别的线程可能立刻调度新批次，这里不能再碰队列
+                scheduled = false;
+                drained = true;
+                continue;
+            }
+            fn = move(tasks.front());
+            tasks.pop_front();
+        }
+        fn();
+    }
+
+    SessionChannel::bind(nullptr);
+    runningStrand = previousStrand;
+    if (drained) return;
+
+    // 批次用完还有任务：排到队尾，让别的会话先走
+    bool more = false;
+    {
+        lock_guard<mutex> lock(mtx);
+        more = !tasks.empty();
+        if (!more) scheduled = false;
+    }
+    if (more) loop.post([self = shared_from_this()] { self->runBatch(); });
+}
+
+// ==========================================
+// EventLoop
+// ==========================================
+
+EventLoop::EventLoop(size_t blockingThreads) {
+    if (blockingThreads == 0) blockingThreads = 1;
+    for (size_t i = 0; i < blockingThreads; ++i) {
+        pool.emplace_back(&EventLoop::blockingWorker, this);
+    }
+}
+
+EventLoop::~EventLoop() {
+    {
+        lock_guard<mutex> lock(poolMutex);
+        poolStopping = true;
+    }
+    poolCv.notify_all();
+    for (auto& t : pool) t.join();
+}
+
+EventLoop* EventLoop::current() {
+    return runningLoop;
+}
+
+size_t EventLoop::defaultWorkers() {
+    size_t cores = thread::hardware_concurrency();
+    return cores < 2 ? 2 : cores;
+}
+
+void EventLoop::post(function<void()> fn) {
+    {
+        lock_guard<mutex> lock(mtx);
+        ready.push_back(move(fn));
+    }
+    cv.notify_one();
+}
+
+void EventLoop::runBlocking(function<void()> fn, RequestPriority priority) {
+    {
+        lock_guard<mutex> lock(poolMutex);
+        blockingQueue[static_cast<int>(priority)].push_back(move(fn));
+    }
+    poolCv.notify_one();
+}
+
+void EventLoop::run(size_t workers) {
+    vector<thread> extra;
+    for (size_t i = 1; i < workers; ++i) {
+        extra.emplace_back(&EventLoop::workerLoop, this);
+    }
+    workerLoop();
+    for (auto& t : extra) t.join();
+}
+
+void EventLoop::workerLoop() {
+    EventLoop* previous = runningLoop;
+    runningLoop = this;
+
+    while (true) {
+        function<void()> fn;
+        {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [this] { return stopping || !ready.empty(); });
+            if (ready.empty()) break; // stopping 且没有剩余任务
+            fn = move(ready.front());
+            ready.pop_front();
+        }
+        fn();
+    }
+
+    runningLoop = previous;
+}
+
+void EventLoop::stop() {
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+}
+
+void EventLoop::blockingWorker() {
+    while (true) {
+        function<void()> fn;
+        {
+            unique_lock<mutex> lock(poolMutex);
+            poolCv.wait(lock, [this] { return poolStopping || !blockingQueue[0].empty() || !blockingQueue[1].empty(); });
+            auto& queue = blockingQueue[0].empty() ? blockingQueue[1] : blockingQueue[0];
+            if (queue.empty()) return;
+            fn = move(queue.front());
+            queue.pop_front();
+        }
+        fn();
+    }
+}
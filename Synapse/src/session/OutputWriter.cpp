@@ -0,0 +1,145 @@
+#include "OutputWriter.h"
+#include "Metrics.h"
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 退出时慢客户端迟迟不读，最多再等这么久
+static const int SHUTDOWN_GRACE_MS = 3000;
+static const int SHUTDOWN_POLL_MS = 100;
+
+// 单个 fd 最多积压这么多没写出去的输出 (与 SessionServer 的输入积压上限相同)
+// 超过就当对端不再读：丢掉积压和之后的输出，shutdown 连接让会话那边读到 EOF 收尾
+// stdout (--batch / 标准输入模式) 是阻塞写，积压只是写线程一次取出的量，不算客户端不读
+static const size_t MAX_PENDING_BYTES = 1 << 20;
+
+OutputWriter& OutputWriter::instance() {
+    static OutputWriter writerInstance;
+    return writerInstance;
+}
+
+OutputWriter::OutputWriter() {
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    writer = thread(&OutputWriter::run, this);
+}
+
+OutputWriter::~OutputWriter() {
+    shutdown();
+    if (wakeFd >= 0) close(wakeFd);
+}
+
+void OutputWriter::push(OutputEvent event) {
+    queue.push(move(event));
+    // 写线程可能正准备睡：只有它真的在睡时才花一次 syscall 叫醒
+    if (sleeping.load(memory_order_seq_cst) && sleeping.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void OutputWriter::shutdown() {
+    if (!writer.joinable()) return;
+    stopping.store(true);
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+    writer.join();
+}
+
+void OutputWriter::drainQueue() {
+    OutputEvent event;
+    while (queue.tryPop(event)) {
+        Sink& sink = sinks[event.fd];
+        if (!sink.broken) sink.pending += event.data;
+        if (event.afterWrite) sink.callbacks.push_back(move(event.afterWrite));
+        if (sink.pending.size() > MAX_PENDING_BYTES && !sink.unbounded) dropSink(event.fd, sink);
+    }
+}
+
+void OutputWriter::dropSink(int fd, Sink& sink) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        sink.unbounded = true;
+        return;
+    }
+    static Counter& overflows = Metrics::instance().counter("synapse_output_overflow_total",
+                                                            "输出积压超限被断开的连接数");
+    overflows.inc();
+    sink.broken = true;
+    sink.pending.clear();
+    sink.pending.shrink_to_fit();
+    ::shutdown(fd, SHUT_RDWR);
+}
+
+bool OutputWriter::flushSink(int fd, Sink& sink) {
+    size_t written = 0;
+    while (!sink.broken && written < sink.pending.size()) {
+        ssize_t n = write(fd, sink.pending.data() + written, sink.pending.size() - written);
+        if (n > 0) {
+            written += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            sink.pending.erase(0, written);
+            return false;
+        }
+        sink.broken = true; // EPIPE 等：对端没了，之后的输出直接丢掉
+    }
+    sink.pending.clear();
+    return true;
+}
+
+void OutputWriter::run() {
+    vector<pollfd> fds;
+    int graceLeft = SHUTDOWN_GRACE_MS;
+
+    while (true) {
+        drainQueue();
+
+        // 1. 写出各 fd 积压的数据；写完的触发回调并丢掉状态 (fd 随后可能被关闭、复用)
+        fds.clear();
+        fds.push_back({ wakeFd, POLLIN, 0 });
+        for (auto it = sinks.begin(); it != sinks.end();) {
+            if (!flushSink(it->first, it->second)) {
+                fds.push_back({ it->first, POLLOUT, 0 });
+                ++it;
+                continue;
+            }
+            vector<function<void()>> callbacks = move(it->second.callbacks);
+            it = sinks.erase(it);
+            for (auto& cb : callbacks) cb();
+        }
+
+        bool stopNow = stopping.load();
+        if (stopNow && queue.empty() && (fds.size() == 1 || graceLeft <= 0)) break;
+
+        // 2. 没活干就睡，直到有新事件或某个 socket 可写
+        sleeping.store(true, memory_order_seq_cst);
+        if (!queue.empty()) {
+            sleeping.store(false);
+            continue;
+        }
+        int timeout = stopNow ? SHUTDOWN_POLL_MS : -1;
+        int ready = poll(fds.data(), fds.size(), timeout);
+        sleeping.store(false);
+        if (stopNow && ready == 0) graceLeft -= SHUTDOWN_POLL_MS;
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            uint64_t counter;
+            ssize_t ignored = read(wakeFd, &counter, sizeof(counter));
+            (void)ignored;
+        }
+    }
+
+    // 放弃仍写不出去的连接，但回调 (关闭连接) 照常执行
+    for (auto& [fd, sink] : sinks) {
+        for (auto& cb : sink.callbacks) cb();
+    }
+    sinks.clear();
+}
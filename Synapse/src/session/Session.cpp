@@ -0,0 +1,100 @@
+#include "Session.h"
+#include "SystemExecutor.h"
+#include "Metrics.h"
+
+using namespace std;
+
+static string trim(const string& str) {
+    size_t first = str.find_first_not_of(" \t\n\r");
+    if (string::npos == first) return "";
+    size_t last = str.find_last_not_of(" \t\n\r");
+    return str.substr(first, (last - first + 1));
+}
+
+Session::Session(uint64_t id, unique_ptr<SessionChannel> channel)
+    : sessionId(id), channel(move(channel)) {
+    this->channel->setSessionId(id);
+}
+
+void Session::start(EventLoop& eventLoop, shared_ptr<SharedBrains> brains, function<void()> onFinished) {
+    strand = make_shared<EventLoop::Strand>(eventLoop, channel.get());
+    auto self = shared_from_this();
+    strand->post([self, brains, onFinished] {
+        // 回调里持有 self，保证协程跑完之前 Session 不会被释放
+        spawn(self->main(brains), [self, onFinished] {
+            {
+                lock_guard<mutex> lock(self->stateMutex);
+                self->finished = true;
+            }
+            if (onFinished) onFinished();
+        });
+    });
+}
+
+void Session::deliver(string line) {
+    if (line == "exit") {
+        close();
+        return;
+    }
+    auto self = shared_from_this();
+    size_t bytes = line.size() + 1;
+    inTransitBytes.fetch_add(bytes, memory_order_relaxed);
+    post([self, bytes, line = move(line)]() mutable {
+        self->channel->deliver(move(line));
+        self->inTransitBytes.fetch_sub(bytes, memory_order_relaxed);
+    });
+}
+
+void Session::close() {
+    auto self = shared_from_this();
+    post([self] { self->channel->close(); });
+}
+
+void Session::post(function<void()> fn) {
+    lock_guard<mutex> lock(stateMutex);
+    if (finished) return;
+    strand->post(move(fn));
+}
+
+Task<void> Session::main(shared_ptr<SharedBrains> brains) {
+    SystemExecutor agent(brains);
+    // 本地模型还在后台预热时，就绪后单独报告一次 (已经预热完就不报；会话已经结束也不报)
+    weak_ptr<Session> weak = weak_from_this();
+    brains->local->onWarm([weak](const WarmupReport& report) {
+        auto self = weak.lock();
+        if (!self) return;
+        self->post([report] {
+            if (report.ok) {
+                sessionEvent(EventType::Info) << "[System] 本地模型已就绪 (加载 " << static_cast<int>(report.loadMs)
+                                              << " ms，预填 " << static_cast<int>(report.primeMs) << " ms)";
+            } else {
+                sessionEvent(EventType::Error) << "本地模型预热失败，第一条指令可能较慢: " << report.error;
+            }
+        });
+    });
+    // 先登记再触发预热 (stdin 模式在这里才开始)，失败得很快时也能报出来
+    SystemExecutor::announce(brains);
+    sessionEvent(EventType::Info) << "[System] Ready.";
+
+    static Counter& understoodCount = Metrics::instance().counter("synapse_commands_total", "处理完的指令数", "result=\"understood\"");
+    static Counter& notUnderstoodCount = Metrics::instance().counter("synapse_commands_total", "处理完的指令数", "result=\"not_understood\"");
+    // 从收到指令到 done，含追问时等用户回答的时间
+    static Histogram& commandLatency = Metrics::instance().histogram("synapse_command_latency_seconds", "单条指令耗时 (含追问)");
+
+    string line;
+    while (co_await sessionReadLine(line)) {
+        string cleanLine = trim(line);
+        if (cleanLine.empty()) continue;
+
+        bool understood;
+        {
+            LatencyTimer timer(commandLatency);
+            understood = co_await agent.processInput(cleanLine);
+        }
+        (understood ? understoodCount : notUnderstoodCount).inc();
+        if (!understood) sessionEvent(EventType::Thinking) << "无法理解该指令 (" << cleanLine << ")";
+        // GUI 据此复位状态，压测工具据此计时
+        sessionEvent(EventType::Done) << (understood ? "understood" : "not_understood");
+    }
+    sessionOut().flush();
+}
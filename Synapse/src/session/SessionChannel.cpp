@@ -0,0 +1,280 @@
+#include "SessionChannel.h"
+#include "OutputWriter.h"
+#include "JsonUtil.h"
+#include "Tracer.h"
+#include <iostream>
+
+using namespace std;
+
+static StdioChannel& stdioChannel() {
+    static StdioChannel channel;
+    return channel;
+}
+
+static thread_local SessionChannel* boundChannel = nullptr;
+
+SessionChannel& SessionChannel::current() {
+    return boundChannel ? *boundChannel : stdioChannel();
+}
+
+void SessionChannel::bind(SessionChannel* channel) {
+    boundChannel = channel;
+}
+
+ostream& sessionOut() {
+    return SessionChannel::current().out();
+}
+
+SessionChannel::LineAwaiter sessionReadLine(string& line) {
+    return SessionChannel::current().nextLine(line);
+}
+
+// ==========================================
+// 类型化事件
+// ==========================================
+
+const char* eventTypeName(EventType type) {
+    switch (type) {
+        case EventType::Thinking:   return "thinking";
+        case EventType::Prompt:     return "prompt";
+        case EventType::Result:     return "result";
+        case EventType::Candidates: return "candidates";
+        case EventType::Progress:   return "progress";
+        case EventType::Error:      return "error";
+        case EventType::Info:       return "info";
+        case EventType::Done:       return "done";
+    }
+    return "info";
+}
+
+EventBuilder::~EventBuilder() {
+    SessionEvent event;
+    event.type = type;
+    event.text = text.str();
+    SessionChannel::current().emit(event);
+}
+
+EventBuilder sessionEvent(EventType type) {
+    return EventBuilder(type);
+}
+
+void sessionCandidates(const string& title, vector<string> items, CandidateLayout layout, const string& skip) {
+    SessionEvent event;
+    event.type = EventType::Candidates;
+    event.text = title;
+    event.items = move(items);
+    event.layout = layout;
+    event.skip = skip;
+    SessionChannel::current().emit(event);
+}
+
+string SessionChannel::encode(const SessionEvent& event) {
+    string frame;
+    if (protocol == Protocol::JsonLines) {
+        frame = "{\"session\":" + to_string(sessionId) +
+                ",\"seq\":" + to_string(++seq) +
+                ",\"type\":\"" + eventTypeName(event.type) +
+                "\",\"text\":\"" + JsonUtil::escape(event.text) + "\"";
+        if (event.type == EventType::Candidates) {
+            frame += ",\"items\":[";
+            for (size_t i = 0; i < event.items.size(); ++i) {
+                if (i > 0) frame += ",";
+                frame += "\"" + JsonUtil::escape(event.items[i]) + "\"";
+            }
+            frame += "]";
+            if (!event.skip.empty()) frame += ",\"skip\":\"" + JsonUtil::escape(event.skip) + "\"";
+        }
+        frame += "}\n";
+        return frame;
+    }
+
+    // 文本模式：逐字节保持 GUI 改版前的输出，老脚本 (stress_test.py) 照样能匹配
+    // Progress 不加前缀：改版前这些行 (定位文件、移入回收站、请求审计、DeepSeek Thinking) 就是裸打印的；
+    // 改版前带 [THINK] 的进度行 (全盘搜索路径) 发的是 Thinking
+    if (event.type == EventType::Done) return frame;
+    switch (event.type) {
+        case EventType::Thinking: frame = "[THINK] "; break;
+        case EventType::Result:   frame = "[RESULT] "; break;
+        case EventType::Error:    frame = "[ERROR] "; break;
+        default: break;
+    }
+    frame += event.text;
+    // 以空格结尾的提问 (如 "请输入序号: ") 改版前不换行，光标停在同一行等输入
+    bool inlinePrompt = event.type == EventType::Prompt && !event.text.empty() && event.text.back() == ' ';
+    if (!inlinePrompt && (!event.text.empty() || event.type != EventType::Candidates)) frame += "\n";
+
+    const char* indent = event.layout == CandidateLayout::IndentedLines ? " " : "";
+    for (size_t i = 0; i < event.items.size(); ++i) {
+        frame += indent;
+        frame += "[" + to_string(i + 1) + "] " + event.items[i];
+        frame += event.layout == CandidateLayout::Inline ? " " : "\n";
+    }
+    if (event.layout == CandidateLayout::Inline && event.type == EventType::Candidates) frame += "\n";
+    if (!event.skip.empty()) frame += string(indent) + "[0] " + event.skip + "\n";
+    return frame;
+}
+
+void SessionChannel::emit(const SessionEvent& event) {
+    out().flush();
+    string frame = encode(event);
+    if (!frame.empty()) writeRaw(move(frame));
+}
+
+void SessionChannel::writeText(string text) {
+    if (text.empty()) return;
+    if (protocol == Protocol::Text) {
+        writeRaw(move(text));
+        return;
+    }
+
+    // 一次刷新里的多行拆成多个 info 事件，整块一起交给 writeRaw
+    string frames;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == string::npos) end = text.size();
+        if (end > start) {
+            SessionEvent event;
+            event.text = text.substr(start, end - start);
+            frames += encode(event);
+        }
+        start = end + 1;
+    }
+    if (!frames.empty()) writeRaw(move(frames));
+}
+
+// ==========================================
+// 协程式输入
+// ==========================================
+
+bool SessionChannel::LineAwaiter::await_ready() {
+    // 提示语 (如 "请输入序号: ") 不带换行，等输入前先推给对端
+    channel.out().flush();
+    return !channel.pendingLines.empty() || channel.closed;
+}
+
+void SessionChannel::LineAwaiter::await_suspend(coroutine_handle<> h) {
+    if (Tracer::instance().enabled()) suspendedNs = Tracer::nowNs();
+    channel.waiter = h;
+}
+
+bool SessionChannel::LineAwaiter::await_resume() {
+    // 用户思考 / 打字的时间，和模型、find 的耗时分开
+    if (suspendedNs) Tracer::instance().record("session", "input.wait", suspendedNs, Tracer::nowNs());
+    if (channel.pendingLines.empty()) {
+        channel.starved = true;
+        return false;
+    }
+    line = move(channel.pendingLines.front());
+    channel.pendingLines.pop_front();
+    channel.pendingBytes.fetch_sub(line.size() + 1, memory_order_relaxed);
+    return true;
+}
+
+void SessionChannel::deliver(string line) {
+    if (closed) return;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    pendingBytes.fetch_add(line.size() + 1, memory_order_relaxed);
+    pendingLines.push_back(move(line));
+    wakeWaiter();
+}
+
+void SessionChannel::close() {
+    closed = true;
+    wakeWaiter();
+}
+
+void SessionChannel::wakeWaiter() {
+    if (!waiter) return;
+    coroutine_handle<> h = waiter;
+    waiter = nullptr;
+
+    SessionChannel* previous = boundChannel;
+    bind(this);
+    h.resume();
+    bind(previous);
+}
+
+// ==========================================
+// StdioChannel
+// ==========================================
+
+ostream& StdioChannel::out() {
+    return cout;
+}
+
+// 兜底通道的裸输出直接进 cout，不经过 writeText
+void StdioChannel::writeRaw(string data) {
+    cout << data << flush;
+}
+
+// ==========================================
+// TextBuf
+// ==========================================
+
+SessionChannel::TextBuf::TextBuf(SessionChannel& owner) : owner(owner) {
+    setp(buffer, buffer + sizeof(buffer));
+}
+
+void SessionChannel::TextBuf::flushBuffer() {
+    if (pptr() > pbase()) {
+        string text(pbase(), pptr());
+        setp(buffer, buffer + sizeof(buffer));
+        owner.writeText(move(text));
+    }
+    setp(buffer, buffer + sizeof(buffer));
+}
+
+SessionChannel::TextBuf::int_type SessionChannel::TextBuf::overflow(int_type ch) {
+    flushBuffer();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int SessionChannel::TextBuf::sync() {
+    flushBuffer();
+    return 0;
+}
+
+// ==========================================
+// FdChannel
+// ==========================================
+
+FdChannel::FdChannel(int fd) : fd(fd), outBuf(*this), stream(&outBuf) {}
+
+FdChannel::~FdChannel() {
+    stream.flush();
+}
+
+void FdChannel::writeRaw(string data) {
+    OutputEvent event;
+    event.fd = fd;
+    event.data = move(data);
+    OutputWriter::instance().push(move(event));
+}
+
+// ==========================================
+// MemoryChannel
+// ==========================================
+
+MemoryChannel::MemoryChannel() : outBuf(*this), stream(&outBuf) {}
+
+MemoryChannel::~MemoryChannel() {
+    stream.flush();
+}
+
+string MemoryChannel::takeOutput() {
+    stream.flush();
+    return move(captured);
+}
+
+void MemoryChannel::writeRaw(string data) {
+    auto now = chrono::steady_clock::now();
+    for (char c : data) {
+        if (c == '\n') times.push_back(now);
+    }
+    captured += data;
+}
@@ -0,0 +1,312 @@
+#include "SessionServer.h"
+#include "Session.h"
+#include "HarvestedKnowledge.h"
+#include "OutputWriter.h"
+#include "Metrics.h"
+#include "SystemExecutor.h"
+#include "BackendScheduler.h"
+#include <iostream>
+#include <map>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <cstdlib>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+static bool fillAddress(const string& path, sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "[Error] socket 路径过长: " << path << endl;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 收到 SIGINT / SIGTERM 时删掉 socket 文件再退出 (信号处理函数里只能用 async-signal-safe 调用)
+static char cleanupPath[sizeof(sockaddr_un::sun_path)];
+
+static void onTerminate(int) {
+    if (cleanupPath[0]) unlink(cleanupPath);
+    _exit(0);
+}
+
+SessionServer::SessionServer(const string& socketPath, SessionChannel::Protocol protocol)
+    : socketPath(socketPath), protocol(protocol) {}
+
+SessionServer::~SessionServer() {
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+    if (wakeFd >= 0) close(wakeFd);
+}
+
+string SessionServer::defaultSocketPath() {
+    const char* runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && runtimeDir[0]) return string(runtimeDir) + "/synapse.sock";
+    return "/tmp/synapse-" + to_string(getuid()) + ".sock";
+}
+
+bool SessionServer::start() {
+    sockaddr_un addr;
+    if (!fillAddress(socketPath, addr)) return false;
+
+    // 上一次没正常退出会留下 socket 文件：连得上说明已有 daemon，连不上就是残留
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0) {
+        bool alive = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        close(probe);
+        if (alive) {
+            cerr << "[Error] 已有 daemon 在监听: " << socketPath << endl;
+            return false;
+        }
+    }
+    unlink(socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        cerr << "[Error] 创建 socket 失败: " << strerror(errno) << endl;
+        return false;
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd, 64) < 0) {
+        cerr << "[Error] 监听 " << socketPath << " 失败: " << strerror(errno) << endl;
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    // 会话能删文件，只允许本用户连接
+    chmod(socketPath.c_str(), 0600);
+
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0) {
+        cerr << "[Error] 创建 eventfd 失败: " << strerror(errno) << endl;
+        return false;
+    }
+
+    memcpy(cleanupPath, addr.sun_path, sizeof(cleanupPath));
+    signal(SIGINT, onTerminate);
+    signal(SIGTERM, onTerminate);
+    // 客户端中途断开时 write 返回 EPIPE 即可，别让整个 daemon 被信号杀掉
+    signal(SIGPIPE, SIG_IGN);
+
+    // 大脑和已收割知识在第一个连接到来前就准备好
+    brains = SharedBrains::create();
+    SystemExecutor::warmUp(brains);
+    // 阻塞线程池要装得下所有后端同时在途的请求 (再加上搜索等不经调度器的阻塞调用)，
+    // 否则拿到名额的交互请求还得在线程池里等后台审计
+    loop = make_unique<EventLoop>(EventLoop::DEFAULT_BLOCKING_THREADS + BackendScheduler::instance().totalCapacity());
+    size_t harvested = HarvestedKnowledge::instance().loadedExamples();
+    cerr << "[System] Daemon listening on " << socketPath << " (已加载 " << harvested << " 条历史修正样本)" << endl;
+    return true;
+}
+
+void SessionServer::onSessionFinished(int fd) {
+    {
+        lock_guard<mutex> lock(finishedMutex);
+        finishedFds.push_back(fd);
+    }
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+// 一个连接在 I/O 线程这边的状态
+struct Connection {
+    shared_ptr<Session> session;
+    string pending;     // 还没凑成一行的输入
+    bool reading = true; // 对端关闭写端后不再 poll 它，但连接要等会话结束才关
+};
+
+// 输入背压：客户端写得比会话处理得快时，积压超过上限就暂停读这个连接 (内核缓冲满了对端自然被阻塞)，
+// 会话读走一部分后再恢复；单行超过上限的连接当作坏客户端，不再读它的输入
+static const size_t MAX_INPUT_BACKLOG = 1 << 20;
+static const size_t MAX_LINE_BYTES = 64 * 1024;
+// 有连接被暂停时 poll 的超时 (毫秒)，到点重新看积压有没有降下来
+static const int BACKPRESSURE_POLL_MS = 50;
+
+void SessionServer::run() {
+    thread loopThread([this] { loop->run(EventLoop::defaultWorkers()); });
+
+    map<int, Connection> connections;
+    uint64_t nextSessionId = 1;
+    Gauge& activeSessions = Metrics::instance().gauge("synapse_sessions_active", "当前连接的会话数");
+    Counter& totalSessions = Metrics::instance().counter("synapse_sessions_total", "累计接入的会话数");
+    Counter& pausedReads = Metrics::instance().counter("synapse_session_input_paused_total", "输入积压超限、暂停读连接的次数");
+    Counter& oversizedLines = Metrics::instance().counter("synapse_session_input_oversized_total", "单行输入超长被断开输入的连接数");
+    vector<pollfd> fds;
+    char buf[4096];
+
+    while (true) {
+        fds.clear();
+        fds.push_back({ listenFd, POLLIN, 0 });
+        fds.push_back({ wakeFd, POLLIN, 0 });
+        bool throttled = false;
+        for (auto& [fd, conn] : connections) {
+            if (!conn.reading) continue;
+            if (conn.session->queuedInputBytes() >= MAX_INPUT_BACKLOG) {
+                throttled = true;
+                continue;
+            }
+            fds.push_back({ fd, POLLIN, 0 });
+        }
+
+        if (poll(fds.data(), fds.size(), throttled ? BACKPRESSURE_POLL_MS : -1) < 0) {
+            if (errno == EINTR) continue;
+            cerr << "[Error] poll 失败: " << strerror(errno) << endl;
+            break;
+        }
+
+        // 1. 新连接
+        if (fds[0].revents & POLLIN) {
+            // 非阻塞：读由本线程 poll，写由 OutputWriter 处理 EAGAIN，慢客户端谁也拖不住
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0) {
+                uint64_t id = nextSessionId++;
+                auto channel = make_unique<FdChannel>(fd);
+                channel->setProtocol(protocol);
+                auto session = make_shared<Session>(id, move(channel));
+                connections[fd].session = session;
+                activeSessions.set(connections.size());
+                totalSessions.inc();
+                cerr << "[Session " << id << "] connected (active: " << connections.size() << ")" << endl;
+                // 会话结束后，等写线程把它排队的输出都发完，再通知本线程关连接
+                session->start(*loop, brains, [this, fd] {
+                    OutputEvent closing;
+                    closing.fd = fd;
+                    closing.afterWrite = [this, fd] { onSessionFinished(fd); };
+                    OutputWriter::instance().push(move(closing));
+                });
+            } else if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN) {
+                cerr << "[Error] accept 失败: " << strerror(errno) << endl;
+            }
+        }
+
+        // 2. 结束的会话：到这里才真正关闭连接，避免事件循环还在往已关闭的 fd 写
+        if (fds[1].revents & POLLIN) {
+            uint64_t counter;
+            ssize_t ignored = read(wakeFd, &counter, sizeof(counter));
+            (void)ignored;
+            vector<int> finished;
+            {
+                lock_guard<mutex> lock(finishedMutex);
+                finished.swap(finishedFds);
+            }
+            for (int fd : finished) {
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                uint64_t id = it->second.session->id();
+                connections.erase(it);
+                activeSessions.set(connections.size());
+                close(fd);
+                cerr << "[Session " << id << "] closed (active: " << connections.size() << ")" << endl;
+            }
+        }
+
+        // 3. 各连接的输入，按行投递给会话
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            auto it = connections.find(fds[i].fd);
+            if (it == connections.end()) continue;
+            Connection& conn = it->second;
+
+            ssize_t n = read(fds[i].fd, buf, sizeof(buf));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+            if (n <= 0) {
+                // 最后一行没有换行也交出去
+                if (!conn.pending.empty()) conn.session->deliver(move(conn.pending));
+                conn.pending.clear();
+                conn.reading = false;
+                conn.session->close();
+                continue;
+            }
+            conn.pending.append(buf, n);
+            size_t start = 0, nl;
+            while ((nl = conn.pending.find('\n', start)) != string::npos) {
+                conn.session->deliver(conn.pending.substr(start, nl - start));
+                start = nl + 1;
+            }
+            conn.pending.erase(0, start);
+            if (conn.pending.size() > MAX_LINE_BYTES) {
+                cerr << "[Session " << conn.session->id() << "] 单行输入超过 " << MAX_LINE_BYTES << " 字节，不再读取该连接" << endl;
+                oversizedLines.inc();
+                conn.pending.clear();
+                conn.pending.shrink_to_fit();
+                conn.reading = false;
+                conn.session->close();
+                continue;
+            }
+            if (conn.session->queuedInputBytes() >= MAX_INPUT_BACKLOG) pausedReads.inc();
+        }
+    }
+
+    loop->stop();
+    loopThread.join();
+}
+
+// ==========================================
+// 瘦客户端
+// ==========================================
+
+static bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+int SessionServer::runClient(const string& socketPath) {
+    sockaddr_un addr;
+    if (!fillAddress(socketPath, addr)) return 1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        cerr << "[Error] 无法连接 daemon (" << socketPath << "): " << strerror(errno) << endl;
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // 单线程 poll：stdin -> socket，socket -> stdout
+    // stdin 结束后半关闭写端，等 daemon 把剩余输出发完再退出
+    pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { fd, POLLIN, 0 } };
+    char buf[4096];
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            if (!writeAll(STDOUT_FILENO, buf, n)) break;
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0 || !writeAll(fd, buf, n)) {
+                shutdown(fd, SHUT_WR);
+                fds[0].fd = -1; // 不再关注 stdin
+            }
+        }
+    }
+    close(fd);
+    return 0;
+}
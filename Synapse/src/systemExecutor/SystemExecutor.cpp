@@ -1,14 +1,23 @@
 #include "SystemExecutor.h" // 注意路径根据实际情况调整
+#include "HarvestedKnowledge.h"
+#include "SessionChannel.h"
+#include "EventLoop.h"
+#include "BackendScheduler.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "UsageLedger.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <vector>
 
-// 定义一些输出前缀，方便前端解析颜色
-const std::string PREFIX_THINK = "[THINK] ";
-const std::string PREFIX_RESULT = "[RESULT] ";
-const std::string PREFIX_ERROR = "[ERROR] ";
+// 本地意图分类器的置信度达到阈值、见过足够多的不同样本、且留出准确率够高时，直接跳过 Local Brain 和 Grok
+const double CLASSIFIER_BYPASS_CONFIDENCE = 0.9;
+const uint64_t CLASSIFIER_MIN_TRAINED = 200;
+const double CLASSIFIER_MIN_ACCURACY = 0.9;
+// 每一类 (含 OTHER) 至少要有这么多条留出样本，且各自的准确率也要达标
+const uint64_t CLASSIFIER_MIN_PER_CLASS = 30;
 
 using namespace std;
 
@@ -20,14 +29,44 @@ static string trim(const string& str) {
     return str.substr(first, (last - first + 1));
 }
 
-SystemExecutor::SystemExecutor() {
-    localBrain = make_unique<LocalBrain>();
-    cloudBrain = make_unique<CloudBrain>();
-    grokBrain  = make_unique<GrokBrain>(); // [新增] 初始化 Grok
+SystemExecutor::SystemExecutor() : SystemExecutor(SharedBrains::create()) {}
+
+SystemExecutor::SystemExecutor(shared_ptr<SharedBrains> brains) {
+    localBrain = brains->local;
+    cloudBrain = brains->cloud;
+    grokBrain  = brains->grok; // [新增] 初始化 Grok
     
-    // 初始化干活的特种兵
-    fileCreator = make_unique<FileCreator>();
-    fileDeleter = make_unique<FileDeleter>();
+    // 初始化干活的特种兵 (会话状态各自独立，大脑共用)
+    fileCreator = make_unique<FileCreator>(brains);
+    fileDeleter = make_unique<FileDeleter>(brains);
+}
+
+void SystemExecutor::announce(const shared_ptr<SharedBrains>& brains) {
+    sessionEvent(EventType::Info) << "[System] Security Guard initialized (Enhanced Mode).";
+    // 预热已收割的修正样本 (few-shot 检索等)，别让第一条指令去等加载
+    size_t harvested = HarvestedKnowledge::instance().loadedExamples();
+    sessionEvent(EventType::Info) << "[System] 已加载 " << harvested << " 条历史修正样本。";
+    warmUp(brains);
+}
+
+void SystemExecutor::warmUp(const shared_ptr<SharedBrains>& brains) {
+    // 本地模型上的三个任务各自的 profile (模型、num_ctx 可以分别配置) 都要预热
+    // 预填的是各自 prompt 的固定部分，随便代入一句指令即可
+    vector<WarmupTarget> targets(3);
+    targets[0].profile = BrainConfig::profile("local", "router");
+    targets[1].profile = BrainConfig::profile("local", "create");
+    targets[2].profile = BrainConfig::profile("local", "delete");
+
+    // 和 processInput 的渲染方式保持一致，预填的才是真实请求的前缀；没有模板就只加载模型
+    string router = loadPrompt("exec_router.txt");
+    if (!router.empty()) {
+        size_t pos = router.find("{{USER_INPUT}}");
+        if (pos != string::npos) router.replace(pos, 14, "新建一个文件");
+        targets[0].primePrompts.push_back(router);
+    }
+    targets[1].primePrompts.push_back(FileCreator::extractionPrompt("新建一个文件", ""));
+    targets[2].primePrompts.push_back(FileDeleter::extractionPrompt("删除1.txt", ""));
+    brains->local->startWarmUp(targets);
 }
 
 SystemExecutor::~SystemExecutor() {}
@@ -47,26 +86,15 @@ string SystemExecutor::loadPrompt(const string& filename) {
     return "";
 }
 
-bool SystemExecutor::processInput(const string& userQuery) {
+Task<bool> SystemExecutor::processInput(string userQuery) {
     string cleanInput = trim(userQuery);
-    if (cleanInput.empty()) return false;
+    if (cleanInput.empty()) co_return false;
+    // 整条指令一个 span，路由、仲裁、创建/删除、追问和审计都嵌在它下面
+    TraceSpan commandSpan("executor", "command");
+    commandSpan.arg("input_bytes", cleanInput.size());
 
-    // ✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨
-    // 🚑【核心修复】优先查岗机制
-    // 如果特种兵正在忙（比如等着你输名字），直接放行，不要过 AI！
-    // ✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨
-    
-    if (fileCreator->isBusy()) {
-        return fileCreator->processInput(cleanInput);
-    }
-
-    // if (fileDeleter->isBusy()) {
-    //      return fileDeleter->processInput(cleanInput);
-    // }
-    
-    // ✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨
-    // 只有大家都不忙的时候，才往下走去问 Brain
-    // ✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨✨
+    // 追问 (文件名、后缀、路径、删除确认) 由 FileCreator / FileDeleter 在协程里直接 co_await 读取，
+    // 走到这里的一定是一条新指令，不再需要 "特种兵是否在忙" 的查岗
 
     // 1. === 处理强制 Cloud 指令 (保留逻辑) ===
     bool forceCloud = false;
@@ -85,8 +113,32 @@ bool SystemExecutor::processInput(const string& userQuery) {
     string promptTemplate = loadPrompt("exec_router.txt");
     string intent = "OTHER";
 
-    if (promptTemplate.empty()) {
-        cout << PREFIX_ERROR << "缺少 prompts/exec_router.txt，回退到关键词匹配..." << endl;
+    // --- 第零轮：CPU 意图分类器 (微秒级) ---
+    const IntentClassifier& classifier = HarvestedKnowledge::instance().intentClassifier();
+    IntentPrediction prediction;
+    {
+        TraceSpan span("executor", "classifier");
+        prediction = classifier.predict(cleanInput);
+    }
+    bool classifierConfident = classifier.trainedExamples() >= CLASSIFIER_MIN_TRAINED &&
+                               classifier.heldOutAccuracy() >= CLASSIFIER_MIN_ACCURACY &&
+                               classifier.minClassExamples() >= CLASSIFIER_MIN_PER_CLASS &&
+                               classifier.minClassAccuracy() >= CLASSIFIER_MIN_ACCURACY &&
+                               prediction.confidence >= CLASSIFIER_BYPASS_CONFIDENCE;
+    // 分类器直接给出意图 = 命中，省掉一次路由模型调用
+    static Counter& classifierHits = Metrics::instance().counter("synapse_cache_lookups_total", "运行时缓存查询次数",
+                                                                 "cache=\"intent_classifier\",task=\"router\",result=\"hit\"");
+    static Counter& classifierMisses = Metrics::instance().counter("synapse_cache_lookups_total", "运行时缓存查询次数",
+                                                                   "cache=\"intent_classifier\",task=\"router\",result=\"miss\"");
+    (classifierConfident ? classifierHits : classifierMisses).inc();
+
+    if (classifierConfident) {
+        intent = prediction.label;
+        sessionEvent(EventType::Thinking) << "⚡ 本地分类器判定: " << intent << " (置信度 "
+             << static_cast<int>(prediction.confidence * 100) << "%)，跳过 Local Brain / Grok";
+    }
+    else if (promptTemplate.empty()) {
+        sessionEvent(EventType::Error) << "缺少 prompts/exec_router.txt，回退到关键词匹配...";
         if (cleanInput.find("删") != string::npos) intent = "DELETE";
         else if (cleanInput.find("建") != string::npos) intent = "CREATE";
     } 
@@ -96,15 +148,27 @@ bool SystemExecutor::processInput(const string& userQuery) {
         size_t pos = prompt.find("{{USER_INPUT}}");
         if (pos != string::npos) prompt.replace(pos, 14, cleanInput);
 
-        cout << PREFIX_THINK << "Local Brain 正在思考意图..." << endl;
-        string intentRaw = localBrain->talk(prompt);
+        sessionEvent(EventType::Thinking) << "Local Brain 正在思考意图...";
+        string intentRaw;
+        {
+            TraceSpan span("executor", "router.local");
+            BackendSlot slot = co_await scheduleBackend("local");
+            static const ModelProfile profile = BrainConfig::profile("local", "router");
+            intentRaw = co_await offload([&] { return localBrain->talk(prompt, &profile); });
+        }
         intent = trim(intentRaw);
-        cout << PREFIX_THINK << "Local Brain 判定: " << intent << endl;
+        sessionEvent(EventType::Thinking) << "Local Brain 判定: " << intent;
 
         // --- 第二轮：Grok (灵芽) 兜底机制 ---
         // 触发条件：Local 判不出 (OTHER) 且 用户没开强制 DeepSeek 模式
-        if (intent.find("OTHER") != string::npos && !forceCloud) {
-            cout << PREFIX_THINK << "⚠️ Local Brain 不确定，呼叫 Grok 进行云端仲裁..." << endl;
+        // Grok 限速或预算用完时不等额度，直接放弃仲裁，按 OTHER 处理
+        string denied;
+        if (intent.find("OTHER") != string::npos && !forceCloud &&
+            !UsageLedger::instance().tryAcquire("grok", &denied)) {
+            sessionEvent(EventType::Thinking) << "⚠️ Local Brain 不确定，但 Grok 额度已用完 (" << denied << ")，跳过云端仲裁。";
+        }
+        else if (intent.find("OTHER") != string::npos && !forceCloud) {
+            sessionEvent(EventType::Thinking) << "⚠️ Local Brain 不确定，呼叫 Grok 进行云端仲裁...";
             
             // 构造极简 Prompt，强制 Grok 做选择题
             string grokPrompt = "你是一个意图分类器。用户输入：\"" + cleanInput + "\"。\n"
@@ -112,43 +176,61 @@ bool SystemExecutor::processInput(const string& userQuery) {
                                 "CREATE代表创建文件/文件夹，DELETE代表删除/移除，OTHER代表其他。\n"
                                 "不要解释，只输出单词。";
                                 
-            string grokResult = grokBrain->think(grokPrompt);
+            string grokResult;
+            {
+                TraceSpan span("executor", "router.grok");
+                BackendSlot slot = co_await scheduleBackend("grok");
+                grokResult = co_await offload([&] { return grokBrain->think(grokPrompt); });
+            }
             string grokIntent = trim(grokResult);
             
-            cout << PREFIX_THINK << "Grok 仲裁结果: " << grokIntent << endl;
+            sessionEvent(EventType::Thinking) << "Grok 仲裁结果: " << grokIntent;
 
             // 修正 intent
             if (grokIntent.find("CREATE") != string::npos) intent = "CREATE";
             else if (grokIntent.find("DELETE") != string::npos) intent = "DELETE";
             // 如果 Grok 也说是 OTHER，那就真的是 OTHER 了
         }
+
+        // OTHER 会话不产生审计日志，路由模型的结论就是分类器唯一能拿到的 OTHER 标签
+        if (intent.find("OTHER") != string::npos) {
+            HarvestedKnowledge::instance().learnIntent(cleanInput, "OTHER");
+        }
     }
 
     // 3. === 任务分发 ===
     
     if (intent.find("CREATE") != string::npos) {
-        cout << PREFIX_THINK << "✅ 最终识别为【创建】意图，执行 FileCreator..." << endl;
-        return fileCreator->processInput(cleanInput);
+        sessionEvent(EventType::Thinking) << "✅ 最终识别为【创建】意图，执行 FileCreator...";
+        co_return co_await fileCreator->processInput(cleanInput);
     }
     else if (intent.find("DELETE") != string::npos) {
-        cout << PREFIX_THINK << "✅ 最终识别为【删除】意图，执行 FileDeleter..." << endl;
-        return fileDeleter->processInput(cleanInput);
+        sessionEvent(EventType::Thinking) << "✅ 最终识别为【删除】意图，执行 FileDeleter...";
+        co_return co_await fileDeleter->processInput(cleanInput);
     }
     
     // 4. === 兜底逻辑：OTHER ===
     
     if (forceCloud) {
-        cout << PREFIX_THINK << "🚀 意图为 OTHER，但收到强制指令，直连 Cloud..." << endl;
+        string denied;
+        if (!UsageLedger::instance().tryAcquire("cloud", &denied)) {
+            sessionEvent(EventType::Error) << "DeepSeek 额度已用完 (" << denied << ")，本次不生成建议命令。";
+            co_return false;
+        }
+        sessionEvent(EventType::Thinking) << "🚀 意图为 OTHER，但收到强制指令，直连 Cloud...";
         string prompt = "你是一个 Linux 专家。用户需求：" + cleanInput + "\n规则：只输出 Linux 命令，不要代码块，不解释。";
-        string rawCommand = cloudBrain->think(prompt);
+        TraceSpan span("executor", "cloud.suggest");
+        BackendSlot slot = co_await scheduleBackend("cloud");
+        static const ModelProfile profile = BrainConfig::profile("cloud", "suggest");
+        string rawCommand = co_await offload([&] { return cloudBrain->think(prompt, &profile); });
         
         if (!rawCommand.empty()) {
-            cout << PREFIX_RESULT << "AI 生成的建议命令 (未执行): " << rawCommand << endl;
+            sessionEvent(EventType::Result) << "AI 生成的建议命令 (未执行): " << rawCommand;
         }
-        return true;
+        co_return true;
     }
     else {
-        cout << PREFIX_THINK << "❌ 双大脑均未识别为操作指令，且未开启深度思考，待机中。" << endl;
-        return false;
+        sessionEvent(EventType::Thinking) << "❌ 双大脑均未识别为操作指令，且未开启深度思考，待机中。";
+        co_return false;
     }
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "BackendTrace.h"
+#include "JsonUtil.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+static uint64_t fnv1a(const string& s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static string hex64(uint64_t v) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+BackendTrace& BackendTrace::instance() {
+    static BackendTrace trace;
+    return trace;
+}
+
+bool BackendTrace::startRecording(const string& path) {
+    lock_guard<mutex> lock(mtx);
+    out.open(path, ios::binary | ios::trunc);
+    if (!out.is_open()) return false;
+    out << "{\"synapse_trace\":1}\n";
+    out.flush();
+    mode = Mode::Record;
+    return true;
+}
+
+bool BackendTrace::loadReplay(const string& path, bool timing) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) return false;
+
+    lock_guard<mutex> lock(mtx);
+    string line;
+    if (!getline(in, line) || line.find("\"synapse_trace\"") == string::npos) return false;
+    while (getline(in, line)) {
+        string kind, response;
+        if (!JsonUtil::extractString(line, "k", kind) || !JsonUtil::extractString(line, "r", response)) continue;
+        if (kind == "input") {
+            inputs.push_back(move(response));
+            continue;
+        }
+        Entry entry;
+        string hash;
+        if (JsonUtil::extractString(line, "h", hash)) entry.hash = strtoull(hash.c_str(), nullptr, 16);
+        size_t pos = line.find("\"ms\":");
+        if (pos != string::npos) entry.ms = atof(line.c_str() + pos + 5);
+        entry.response = move(response);
+        pending[kind].push_back(move(entry));
+    }
+    keepTiming = timing;
+    mode = Mode::Replay;
+    return true;
+}
+
+void BackendTrace::writeLine(const string& line) {
+    // 每条都刷盘：会话被 Ctrl-C 打断时前面录下的仍然可用
+    out << line;
+    out.flush();
+}
+
+string BackendTrace::call(const char* kind, const string& request, const function<string()>& live) {
+    if (mode == Mode::Off) return live();
+
+    uint64_t hash = fnv1a(request);
+    if (mode == Mode::Record) {
+        auto start = chrono::steady_clock::now();
+        string response = live();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        ostringstream line;
+        line << fixed << setprecision(1) << "{\"k\":\"" << kind << "\",\"h\":\"" << hex64(hash)
+             << "\",\"ms\":" << ms << ",\"r\":\"" << JsonUtil::escape(response) << "\"}\n";
+        lock_guard<mutex> lock(mtx);
+        calls[kind]++;
+        writeLine(line.str());
+        return response;
+    }
+
+    Entry entry;
+    {
+        lock_guard<mutex> lock(mtx);
+        calls[kind]++;
+        auto& queue = pending[kind];
+        if (queue.empty()) {
+            missing++;
+            return "";
+        }
+        // 同类调用偶尔会交错 (审计和下一条指令并发)，先按哈希找，找不到再按顺序取
+        auto it = queue.begin();
+        while (it != queue.end() && it->hash != hash) ++it;
+        if (it == queue.end()) {
+            mismatches++;
+            it = queue.begin();
+        }
+        entry = move(*it);
+        queue.erase(it);
+    }
+    if (keepTiming && entry.ms > 0) {
+        this_thread::sleep_for(chrono::duration<double, milli>(entry.ms));
+    }
+    return entry.response;
+}
+
+void BackendTrace::recordInput(const string& line) {
+    if (mode != Mode::Record) return;
+    lock_guard<mutex> lock(mtx);
+    writeLine("{\"k\":\"input\",\"r\":\"" + JsonUtil::escape(line) + "\"}\n");
+}
+
+vector<string> BackendTrace::recordedInputs() const {
+    lock_guard<mutex> lock(mtx);
+    return inputs;
+}
+
+void BackendTrace::report(ostream& os) const {
+    lock_guard<mutex> lock(mtx);
+    if (mode == Mode::Off) return;
+    size_t total = 0;
+    os << (mode == Mode::Record ? "[Trace] 录制" : "[Replay] 回放") << " 后端调用";
+    for (const auto& [kind, n] : calls) {
+        os << " " << kind << "=" << n;
+        total += n;
+    }
+    os << " (共 " << total << ")";
+    if (mode == Mode::Replay) {
+        size_t left = 0;
+        for (const auto& [kind, queue] : pending) left += queue.size();
+        os << " | 请求不匹配 " << mismatches << " | trace 缺失 " << missing << " | 未用完 " << left;
+    }
+    os << endl;
+}
@@ -0,0 +1,119 @@
+#include "BrainConfig.h"
+#include "Metrics.h"
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+static string envOr(const char* name, const string& fallback) {
+    const char* value = getenv(name);
+    return (value && *value) ? string(value) : fallback;
+}
+
+// 去掉末尾的 '/'，拼路径时不会出现 "//"
+static string mockBase() {
+    string base = envOr("SYNAPSE_MOCK_LLM", "");
+    while (!base.empty() && base.back() == '/') base.pop_back();
+    return base;
+}
+
+static BrainEndpoint resolve(const string& prefix, BrainEndpoint defaults, const string& mockPath) {
+    string base = mockBase();
+    if (!base.empty()) {
+        defaults.url = base + mockPath;
+        // CloudBrain 只认 "sk-" 开头的 Key，mock 不校验
+        defaults.apiKey = "sk-mock";
+    }
+    BrainEndpoint endpoint;
+    endpoint.url = envOr(("SYNAPSE_" + prefix + "_URL").c_str(), defaults.url);
+    endpoint.model = envOr(("SYNAPSE_" + prefix + "_MODEL").c_str(), defaults.model);
+    endpoint.apiKey = envOr(("SYNAPSE_" + prefix + "_KEY").c_str(), defaults.apiKey);
+    return endpoint;
+}
+
+namespace BrainConfig {
+
+BrainEndpoint local() {
+    BrainEndpoint endpoint = resolve("OLLAMA", {"http://localhost:11434/api/generate", "qwen2.5-coder:1.5b", "", ""}, "/api/generate");
+    endpoint.keepAlive = envOr("SYNAPSE_OLLAMA_KEEP_ALIVE", "30m");
+    return endpoint;
+}
+
+BrainEndpoint cloud() {
+    return resolve("DEEPSEEK", {"https://api.deepseek.com/chat/completions", "deepseek-chat", "密钥", ""},
+                   "/chat/completions");
+}
+
+BrainEndpoint grok() {
+    return resolve("GROK", {"https://api.lingyaai.cn/v1/chat/completions", "grok-4-1-fast-non-reasoning", "灵芽密钥", ""},
+                   "/v1/chat/completions");
+}
+
+ModelProfile profile(const string& provider, const string& task) {
+    // 默认值对着 prompt 定：路由回答 "AI: " 后面的一个词，抽取只回 "Output: " / "Out: " 后面的一行，
+    // 停止序列拦住模型接着编下一条样例；建议命令只要一行 shell
+    struct Defaults { const char* provider; const char* task; int numPredict; const char* stop; double temperature; };
+    const Defaults defaults[] = {
+        {"local", "router", 8, "\nUser:", 0},
+        {"local", "create", 48, "\nInput:", 0},
+        {"local", "delete", 64, "\nIn:", 0},
+        {"cloud", "suggest", 256, "", 0},
+    };
+    ModelProfile result;
+    result.task = task;
+    string stop;
+    for (const auto& d : defaults) {
+        if (provider != d.provider || task != d.task) continue;
+        result.numPredict = d.numPredict;
+        result.temperature = d.temperature;
+        stop = d.stop;
+    }
+
+    string taskPrefix = envPrefix(provider) + "_";
+    for (char c : task) taskPrefix += static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    BrainEndpoint endpoint = provider == "local" ? local() : provider == "cloud" ? cloud() : grok();
+    result.model = envOr((taskPrefix + "_MODEL").c_str(), endpoint.model);
+    result.numPredict = static_cast<int>(envNumber(taskPrefix + "_NUM_PREDICT", result.numPredict));
+    result.temperature = envNumber(taskPrefix + "_TEMPERATURE", result.temperature);
+    result.numCtx = static_cast<int>(envNumber(taskPrefix + "_NUM_CTX", 0));
+    stop = envOr((taskPrefix + "_STOP").c_str(), stop);
+    if (stop == "none") stop.clear();
+
+    // 环境变量里写不了真正的换行，"\n" 按换行处理
+    for (size_t pos; (pos = stop.find("\\n")) != string::npos;) stop.replace(pos, 2, "\n");
+    size_t begin = 0;
+    while (begin < stop.size()) {
+        size_t end = stop.find(';', begin);
+        if (end == string::npos) end = stop.size();
+        if (end > begin) result.stop.push_back(stop.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    // 同一个 task / model 只注册一次 (Metrics 返回的对象地址不变)，profile 拷来拷去也指向同一份
+    static mutex metricsMutex;
+    static map<string, CallMetrics> registered;
+    string labels = "task=\"" + task + "\",model=\"" + result.model + "\"";
+    lock_guard<mutex> lock(metricsMutex);
+    auto it = registered.find(labels);
+    if (it == registered.end()) it = registered.emplace(labels, CallMetrics::make("synapse_task", labels)).first;
+    result.metrics = &it->second;
+    return result;
+}
+
+string envPrefix(const string& provider) {
+    if (provider == "local") return "SYNAPSE_OLLAMA";
+    if (provider == "cloud") return "SYNAPSE_DEEPSEEK";
+    return "SYNAPSE_GROK";
+}
+
+double envNumber(const string& name, double fallback) {
+    const char* value = getenv(name.c_str());
+    if (!value || !*value) return fallback;
+    char* end = nullptr;
+    double parsed = strtod(value, &end);
+    return (end != value && parsed >= 0) ? parsed : fallback;
+}
+
+}
@@ -0,0 +1,187 @@
+#include "JsonUtil.h"
+#include <cstdio>
+#include <utility>
+
+namespace JsonUtil {
+
+std::string escape(std::string_view input) {
+    std::string out;
+    out.reserve(input.size() + 16);
+    for (char c : input) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned char>(c));
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+static void appendUtf8(std::string& out, unsigned int cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+static bool parseHex4(std::string_view s, size_t pos, unsigned int& value) {
+    if (pos + 4 > s.size()) return false;
+    value = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        char c = s[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+// i 指向开头的引号；成功时 i 停在结尾引号上
+static bool parseStringAt(std::string_view json, size_t& i, std::string& out) {
+    if (i >= json.size() || json[i] != '"') return false;
+    out.clear();
+    for (++i; i < json.size(); ++i) {
+        char c = json[i];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++i >= json.size()) break;
+        char next = json[i];
+        switch (next) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                unsigned int cp = 0;
+                if (!parseHex4(json, i + 1, cp)) return false;
+                i += 4;
+                // 代理对 (emoji 等)
+                if (cp >= 0xD800 && cp <= 0xDBFF && json.compare(i + 1, 2, "\\u") == 0) {
+                    unsigned int low = 0;
+                    if (parseHex4(json, i + 3, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out += next; break;
+        }
+    }
+    return false; // 字符串没闭合
+}
+
+static void skipSpaces(std::string_view json, size_t& i) {
+    while (i < json.size() && (json[i] == ' ' || json[i] == '\t' || json[i] == '\n' || json[i] == '\r')) i++;
+}
+
+// 找到 "key": 之后值的起始位置
+static bool findValue(std::string_view json, std::string_view key, size_t& valuePos) {
+    std::string quotedKey = "\"" + std::string(key) + "\"";
+    size_t pos = 0;
+    while ((pos = json.find(quotedKey, pos)) != std::string_view::npos) {
+        size_t i = pos + quotedKey.size();
+        skipSpaces(json, i);
+        if (i >= json.size() || json[i] != ':') {
+            pos = i; // 只是值里碰巧出现了同名字符串，继续找
+            continue;
+        }
+        i++;
+        skipSpaces(json, i);
+        valuePos = i;
+        return true;
+    }
+    return false;
+}
+
+bool extractString(std::string_view json, std::string_view key, std::string& out, bool* isNull) {
+    if (isNull) *isNull = false;
+
+    size_t i = 0;
+    if (!findValue(json, key, i)) return false;
+    if (json.compare(i, 4, "null") == 0) {
+        out.clear();
+        if (isNull) *isNull = true;
+        return true;
+    }
+    return parseStringAt(json, i, out);
+}
+
+bool extractStringArray(std::string_view json, std::string_view key, std::vector<std::string>& out) {
+    out.clear();
+    size_t i = 0;
+    if (!findValue(json, key, i)) return false;
+    if (i >= json.size() || json[i] != '[') return false;
+
+    for (++i; ; ++i) {
+        skipSpaces(json, i);
+        if (i >= json.size()) return false;
+        if (json[i] == ']') return true;
+        std::string item;
+        if (!parseStringAt(json, i, item)) return false;
+        out.push_back(std::move(item));
+        ++i;
+        skipSpaces(json, i);
+        if (i >= json.size()) return false;
+        if (json[i] == ']') return true;
+        if (json[i] != ',') return false;
+    }
+}
+
+std::string_view findObject(std::string_view text, size_t pos) {
+    size_t start = text.find('{', pos);
+    while (start != std::string_view::npos) {
+        int depth = 0;
+        bool inString = false;
+        bool escaped = false;
+        for (size_t i = start; i < text.size(); ++i) {
+            char c = text[i];
+            if (inString) {
+                if (escaped) escaped = false;
+                else if (c == '\\') escaped = true;
+                else if (c == '"') inString = false;
+                continue;
+            }
+            if (c == '"') inString = true;
+            else if (c == '{') depth++;
+            else if (c == '}') {
+                if (--depth == 0) return text.substr(start, i - start + 1);
+            }
+        }
+        // 没闭合，试试下一个 '{'
+        start = text.find('{', start + 1);
+    }
+    return std::string_view();
+}
+
+}
@@ -0,0 +1,144 @@
+#include "Metrics.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+// ==========================================
+// 直方图
+// ==========================================
+
+int Histogram::bucketOf(uint64_t micros) {
+    if (micros < SUB_BUCKETS) return static_cast<int>(micros);
+    int exponent = 63 - __builtin_clzll(micros); // >= 3
+    int sub = static_cast<int>(micros >> (exponent - 3)) - SUB_BUCKETS;
+    int bucket = (exponent - 2) * SUB_BUCKETS + sub;
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+uint64_t Histogram::upperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    int exponent = bucket / SUB_BUCKETS + 2;
+    uint64_t width = 1ULL << (exponent - 3);
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 3);
+    return lower + width - 1;
+}
+
+void Histogram::record(uint64_t micros) {
+    buckets[bucketOf(micros)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(micros, memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * n);
+    if (rank >= n) rank = n - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b].load(memory_order_relaxed);
+        if (seen > rank) return upperBound(b);
+    }
+    return upperBound(BUCKETS - 1);
+}
+
+uint64_t Histogram::countBelow(uint64_t bound) const {
+    uint64_t n = 0;
+    for (int b = 0; b < BUCKETS && upperBound(b) < bound; ++b) n += buckets[b].load(memory_order_relaxed);
+    return n;
+}
+
+// ==========================================
+// 注册表
+// ==========================================
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Family& Metrics::family(const string& name, const string& help, Kind kind) {
+    auto [it, inserted] = families.try_emplace(name);
+    if (inserted) {
+        it->second.kind = kind;
+        it->second.help = help;
+    }
+    return it->second;
+}
+
+Counter& Metrics::counter(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(mtx);
+    auto& slot = family(name, help, Kind::Counter).counters[labels];
+    if (!slot) slot = make_unique<Counter>();
+    return *slot;
+}
+
+Gauge& Metrics::gauge(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(mtx);
+    auto& slot = family(name, help, Kind::Gauge).gauges[labels];
+    if (!slot) slot = make_unique<Gauge>();
+    return *slot;
+}
+
+Histogram& Metrics::histogram(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> lock(mtx);
+    auto& slot = family(name, help, Kind::Histogram).histograms[labels];
+    if (!slot) slot = make_unique<Histogram>();
+    return *slot;
+}
+
+CallMetrics CallMetrics::make(const string& prefix, const string& labels) {
+    Metrics& m = Metrics::instance();
+    return {m.counter(prefix + "_requests_total", "请求次数", labels),
+            m.counter(prefix + "_errors_total", "失败次数 (连接失败、空回复、错误字段)", labels),
+            m.histogram(prefix + "_latency_seconds", "请求耗时", labels)};
+}
+
+static string withLabels(const string& name, const string& labels, const string& extra = "") {
+    if (labels.empty() && extra.empty()) return name;
+    string joined = labels;
+    if (!extra.empty()) joined += (joined.empty() ? "" : ",") + extra;
+    return name + "{" + joined + "}";
+}
+
+void Metrics::writePrometheus(ostream& out) const {
+    lock_guard<mutex> lock(mtx);
+    for (const auto& [name, fam] : families) {
+        const char* type = fam.kind == Kind::Counter ? "counter" : fam.kind == Kind::Gauge ? "gauge" : "histogram";
+        out << "# HELP " << name << " " << fam.help << "\n# TYPE " << name << " " << type << "\n";
+        for (const auto& [labels, c] : fam.counters) out << withLabels(name, labels) << " " << c->get() << "\n";
+        for (const auto& [labels, g] : fam.gauges) out << withLabels(name, labels) << " " << g->get() << "\n";
+        for (const auto& [labels, h] : fam.histograms) {
+            // 桶边界取 2^k 微秒 (64 µs ~ 4.8 h)，和内部的桶对齐
+            for (int k = 6; k <= 34; ++k) {
+                ostringstream le;
+                le << "le=\"" << setprecision(6) << (1ULL << k) / 1e6 << "\"";
+                out << withLabels(name + "_bucket", labels, le.str()) << " " << h->countBelow(1ULL << k) << "\n";
+            }
+            out << withLabels(name + "_bucket", labels, "le=\"+Inf\"") << " " << h->count() << "\n";
+            out << withLabels(name + "_sum", labels) << " " << h->sumMicros() / 1e6 << "\n";
+            out << withLabels(name + "_count", labels) << " " << h->count() << "\n";
+        }
+    }
+}
+
+void Metrics::writeSummary(ostream& out) const {
+    lock_guard<mutex> lock(mtx);
+    out << "[Metrics]" << endl;
+    auto ms = [](uint64_t micros) { return micros / 1000.0; };
+    for (const auto& [name, fam] : families) {
+        for (const auto& [labels, c] : fam.counters) {
+            if (c->get()) out << "  " << withLabels(name, labels) << " = " << c->get() << endl;
+        }
+        for (const auto& [labels, g] : fam.gauges) {
+            if (g->get()) out << "  " << withLabels(name, labels) << " = " << g->get() << endl;
+        }
+        for (const auto& [labels, h] : fam.histograms) {
+            if (!h->count()) continue;
+            out << "  " << withLabels(name, labels) << fixed << setprecision(1) << " n=" << h->count()
+                << " p50=" << ms(h->percentile(0.5)) << "ms p90=" << ms(h->percentile(0.9))
+                << "ms p99=" << ms(h->percentile(0.99)) << "ms" << defaultfloat << endl;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include "MetricsServer.h"
+#include "Metrics.h"
+#include <charconv>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+MetricsServer::MetricsServer(const string& listen) : listenSpec(listen) {}
+
+MetricsServer::~MetricsServer() {
+    // 后台线程是 detach 的，随进程退出；这里只清理 socket 文件
+    if (listenFd >= 0 && unixSocket) unlink(listenSpec.c_str());
+}
+
+bool MetricsServer::start() {
+    unixSocket = listenSpec.empty() || listenSpec.find_first_not_of("0123456789") != string::npos;
+    if (unixSocket) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (listenSpec.size() >= sizeof(addr.sun_path)) {
+            cerr << "[Error] 指标 socket 路径过长: " << listenSpec << endl;
+            return false;
+        }
+        memcpy(addr.sun_path, listenSpec.c_str(), listenSpec.size() + 1);
+        unlink(listenSpec.c_str()); // 上次没正常退出留下的
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            cerr << "[Error] 指标端点绑定失败 " << listenSpec << ": " << strerror(errno) << endl;
+            return false;
+        }
+        chmod(listenSpec.c_str(), 0600);
+    } else {
+        // 全是数字才走到这里，但可能超出端口范围 (stoi 会抛、强转 uint16_t 会悄悄回绕)
+        unsigned port = 0;
+        auto [end, ec] = from_chars(listenSpec.data(), listenSpec.data() + listenSpec.size(), port);
+        if (ec != errc() || end != listenSpec.data() + listenSpec.size() || port < 1 || port > 65535) {
+            cerr << "[Error] 无效的指标端口 (1-65535): " << listenSpec << endl;
+            return false;
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 只给本机抓
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (listenFd >= 0) setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            cerr << "[Error] 指标端点绑定失败 127.0.0.1:" << listenSpec << ": " << strerror(errno) << endl;
+            return false;
+        }
+    }
+    if (listen(listenFd, 16) < 0) {
+        cerr << "[Error] 指标端点监听失败: " << strerror(errno) << endl;
+        return false;
+    }
+    thread([this] { serve(); }).detach();
+    cerr << "[System] 指标端点: " << (unixSocket ? listenSpec : "http://127.0.0.1:" + listenSpec + "/metrics") << endl;
+    return true;
+}
+
+void MetricsServer::serve() {
+    char buf[2048];
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            cerr << "[Error] 指标端点 accept 失败: " << strerror(errno) << endl;
+            return;
+        }
+        // 慢客户端最多拖 2 秒；读到请求头结束就回，不解析路径
+        timeval timeout{2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        string request;
+        ssize_t n;
+        while (request.find("\r\n\r\n") == string::npos && request.size() < 8192 && (n = read(fd, buf, sizeof(buf))) > 0) {
+            request.append(buf, n);
+        }
+
+        ostringstream body;
+        Metrics::instance().writePrometheus(body);
+        string payload = body.str();
+        string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                          to_string(payload.size()) + "\r\nConnection: close\r\n\r\n" + payload;
+        const char* data = response.data();
+        size_t left = response.size();
+        while (left > 0 && (n = send(fd, data, left, MSG_NOSIGNAL)) > 0) {
+            data += n;
+            left -= n;
+        }
+        close(fd);
+    }
+}
@@ -0,0 +1,53 @@
+#include "SingleFlight.h"
+#include "Metrics.h"
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+SingleFlight& SingleFlight::instance() {
+    static SingleFlight singleFlight;
+    return singleFlight;
+}
+
+SingleFlight::SingleFlight() {
+    const char* env = getenv("SYNAPSE_SINGLEFLIGHT");
+    if (env && strcmp(env, "0") == 0) enabled = false;
+}
+
+string SingleFlight::run(const string& kind, const string& key, const function<string()>& fn) {
+    if (!enabled) return fn();
+
+    string slot = kind;
+    slot += '\0';
+    slot += key;
+    promise<string> leader;
+    unique_lock<mutex> lock(mtx);
+    auto it = inFlight.find(slot);
+    if (it != inFlight.end()) {
+        shared_future<string> pending = it->second;
+        lock.unlock(); // 解锁后再等，别挡住其他 prompt
+        Metrics::instance().counter("synapse_brain_coalesced_total", "合并到在途相同请求、没有真正发出的调用数",
+                                    "brain=\"" + kind + "\"").inc();
+        return pending.get();
+    }
+    inFlight.emplace(slot, leader.get_future().share());
+    lock.unlock();
+
+    // 先摘掉再交结果：之后到的相同请求重新发送，已经拿到 future 的照样能取到值
+    string result;
+    try {
+        result = fn();
+    } catch (...) {
+        lock.lock();
+        inFlight.erase(slot);
+        lock.unlock();
+        leader.set_exception(current_exception());
+        throw;
+    }
+    lock.lock();
+    inFlight.erase(slot);
+    lock.unlock();
+    leader.set_value(result);
+    return result;
+}
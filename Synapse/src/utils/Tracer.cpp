@@ -0,0 +1,113 @@
+#include "Tracer.h"
+#include "JsonUtil.h"
+#include "SessionChannel.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+static uint32_t currentThreadId() {
+    static thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+}
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer() : slots(new Slot[CAPACITY]), originNs(nowNs()) {
+    const char* env = getenv("SYNAPSE_TRACE");
+    if (env && strcmp(env, "0") == 0) on.store(false, memory_order_relaxed);
+}
+
+uint64_t Tracer::nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char* category, const char* name, uint64_t startNs, uint64_t endNs,
+                    const char* argName, int64_t argValue) {
+    uint64_t index = head.fetch_add(1, memory_order_relaxed);
+    Slot& slot = slots[index & (CAPACITY - 1)];
+    // 顺序锁：导出线程读到奇数或者前后不一致就丢掉这一条
+    slot.seq.store(2 * index + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot.category = category;
+    slot.name = name;
+    slot.argName = argName;
+    slot.argValue = argValue;
+    slot.startNs = startNs;
+    slot.durNs = endNs > startNs ? endNs - startNs : 0;
+    slot.session = SessionChannel::current().id();
+    slot.thread = currentThreadId();
+    slot.seq.store(2 * (index + 1), memory_order_release);
+}
+
+void Tracer::writeChromeJson(ostream& out) const {
+    uint64_t end = head.load(memory_order_acquire);
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    set<uint64_t> sessions;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << getpid() << ",\"args\":{\"name\":\"synapse\"}}";
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = slots[index & (CAPACITY - 1)];
+        uint64_t seq = slot.seq.load(memory_order_acquire);
+        if (seq != 2 * (index + 1)) continue;
+        Slot copy;
+        copy.category = slot.category;
+        copy.name = slot.name;
+        copy.argName = slot.argName;
+        copy.argValue = slot.argValue;
+        copy.startNs = slot.startNs;
+        copy.durNs = slot.durNs;
+        copy.session = slot.session;
+        copy.thread = slot.thread;
+        atomic_thread_fence(memory_order_acquire);
+        if (slot.seq.load(memory_order_relaxed) != seq) continue;
+
+        sessions.insert(copy.session);
+        // Chrome trace 的时间单位是微秒
+        out << ",\n{\"ph\":\"X\",\"cat\":\"" << copy.category << "\",\"name\":\"" << copy.name
+            << "\",\"pid\":" << getpid() << ",\"tid\":" << copy.session
+            << ",\"ts\":" << (copy.startNs - min(copy.startNs, originNs)) / 1000.0 << ",\"dur\":" << copy.durNs / 1000.0
+            << ",\"args\":{\"thread\":" << copy.thread;
+        if (copy.argName) out << ",\"" << copy.argName << "\":" << copy.argValue;
+        out << "}}";
+    }
+    for (uint64_t session : sessions) {
+        out << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << getpid() << ",\"tid\":" << session
+            << ",\"args\":{\"name\":\"session " << session << "\"}}";
+    }
+    out << "]}\n";
+}
+
+bool Tracer::writeChromeJson(const string& path) const {
+    ofstream out(path);
+    if (!out.is_open()) return false;
+    writeChromeJson(out);
+    return out.good();
+}
+
+void Tracer::installDumpSignal(const string& path) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    // 之后创建的线程都继承这个屏蔽字，SIGUSR1 只会被下面的线程 sigwait 收走
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    thread([this, set, path] {
+        int sig = 0;
+        while (sigwait(&set, &sig) == 0) {
+            if (writeChromeJson(path)) cerr << "[Trace] span 已导出到 " << path << endl;
+            else cerr << "[Error] 无法写入 span 文件: " << path << endl;
+        }
+    }).detach();
+}
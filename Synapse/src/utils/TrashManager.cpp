@@ -1,10 +1,14 @@
 #include "TrashManager.h"
+#include "Tracer.h"
+#include "Metrics.h"
+#include "Probes.h"
 #include <iostream>
 #include <filesystem>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
 #include <cstdlib>
+#include <mutex>
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -33,7 +37,8 @@ string TrashManager::getHomeDir() {
 // 获取时间戳，防止同名文件冲突
 string TrashManager::getTimestamp() {
     auto now = time(nullptr);
-    auto tm = *localtime(&now);
+    struct tm tm;
+    localtime_r(&now, &tm);
     ostringstream oss;
     oss << put_time(&tm, "%Y%m%d_%H%M%S");
     return oss.str();
@@ -41,6 +46,17 @@ string TrashManager::getTimestamp() {
 
 // 核心功能：移入回收站
 pair<bool, string> TrashManager::moveToTrash(const string& rawPath) {
+    TraceSpan span("trash", "trash.move");
+    static Counter& ok = Metrics::instance().counter("synapse_trash_operations_total", "回收站操作次数", "op=\"move\",result=\"ok\"");
+    static Counter& failed = Metrics::instance().counter("synapse_trash_operations_total", "回收站操作次数", "op=\"move\",result=\"failed\"");
+    SYNAPSE_PROBE1(trash_move_entry, rawPath.c_str());
+    auto result = moveToTrashImpl(rawPath);
+    (result.first ? ok : failed).inc();
+    SYNAPSE_PROBE2(trash_move_return, result.first, rawPath.c_str());
+    return result;
+}
+
+pair<bool, string> TrashManager::moveToTrashImpl(const string& rawPath) {
     try {
         fs::path target(rawPath);
         
@@ -51,12 +67,21 @@ pair<bool, string> TrashManager::moveToTrash(const string& rawPath) {
 
         // 2. 构造新名字：原文件名_时间戳
         // 例如: test.txt -> test.txt_20231010_123000
+        //    多个会话同一秒删同名文件时追加序号，rename 不能覆盖回收站里已有的文件
         string filename = target.filename().string();
         string safeName = filename + "_" + getTimestamp();
         fs::path dest = fs::path(trashPath) / safeName;
 
         // 3. 移动文件 (相当于 rename)
-        fs::rename(target, dest);
+        {
+            static mutex renameMutex;
+            lock_guard<mutex> lock(renameMutex);
+            for (int seq = 1; fs::exists(dest); ++seq) {
+                dest = fs::path(trashPath) / (safeName + "_" + to_string(seq));
+            }
+            safeName = dest.filename().string();
+            fs::rename(target, dest);
+        }
 
         // 4. 记入账本 (为了能撤销)
         // 必须保存绝对路径，否则换个目录就找不到了
@@ -70,6 +95,15 @@ pair<bool, string> TrashManager::moveToTrash(const string& rawPath) {
 
 // 核心功能：后悔药 (撤销)
 pair<bool, string> TrashManager::undoLastDelete() {
+    TraceSpan span("trash", "trash.undo");
+    static Counter& ok = Metrics::instance().counter("synapse_trash_operations_total", "回收站操作次数", "op=\"undo\",result=\"ok\"");
+    static Counter& failed = Metrics::instance().counter("synapse_trash_operations_total", "回收站操作次数", "op=\"undo\",result=\"failed\"");
+    auto result = undoLastDeleteImpl();
+    (result.first ? ok : failed).inc();
+    return result;
+}
+
+pair<bool, string> TrashManager::undoLastDeleteImpl() {
     // 1. 检查有没有后悔药吃
     if (historyStack.empty()) {
         return {false, "没有可撤销的操作。"};
@@ -0,0 +1,178 @@
+#include "UsageLedger.h"
+#include "BrainConfig.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+
+using namespace std;
+
+static int64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int localDay() {
+    time_t now = time(nullptr);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    return (tm.tm_year + 1900) * 1000 + tm.tm_yday;
+}
+
+// 在 json 里找 "key": <整数>，找不到返回 false
+static bool extractNumber(string_view json, string_view key, uint64_t& out) {
+    string quoted = "\"" + string(key) + "\"";
+    size_t pos = json.find(quoted);
+    if (pos == string_view::npos) return false;
+    pos += quoted.size();
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == ':')) ++pos;
+    if (pos >= json.size() || json[pos] < '0' || json[pos] > '9') return false;
+    uint64_t value = 0;
+    while (pos < json.size() && json[pos] >= '0' && json[pos] <= '9') value = value * 10 + (json[pos++] - '0');
+    out = value;
+    return true;
+}
+
+static const char* const DENIAL_REASONS[] = {"daily_usd", "daily_tokens", "tpm", "rpm"};
+
+UsageLedger& UsageLedger::instance() {
+    static UsageLedger ledger;
+    return ledger;
+}
+
+UsageLedger::UsageLedger() {
+    // 默认价格取自各家公开价 (美元 / 百万 token)，本地 Ollama 不花钱，也不限额
+    struct Defaults { const char* name; double priceIn; double priceOut; bool limited; };
+    const Defaults defaults[] = {{"local", 0, 0, false}, {"cloud", 0.28, 0.42, true}, {"grok", 0.20, 0.50, true}};
+    Metrics& metrics = Metrics::instance();
+    for (size_t i = 0; i < size(defaults); ++i) {
+        string prefix = BrainConfig::envPrefix(defaults[i].name);
+        Account& account = accounts[i];
+        account.name = defaults[i].name;
+        if (defaults[i].limited) {
+            account.limits.rpm = BrainConfig::envNumber(prefix + "_RPM", 0);
+            account.limits.tpm = BrainConfig::envNumber(prefix + "_TPM", 0);
+            account.limits.dailyTokens = BrainConfig::envNumber(prefix + "_DAILY_TOKENS", 0);
+            account.limits.dailyUsd = BrainConfig::envNumber(prefix + "_DAILY_USD", 0);
+            account.limits.priceIn = BrainConfig::envNumber(prefix + "_PRICE_IN", defaults[i].priceIn);
+            account.limits.priceOut = BrainConfig::envNumber(prefix + "_PRICE_OUT", defaults[i].priceOut);
+        }
+
+        string labels = "provider=\"" + account.name + "\"";
+        account.requestCounter = &metrics.counter("synapse_provider_requests_total", "实际发出的模型请求数", labels);
+        account.promptCounter = &metrics.counter("synapse_provider_tokens_total", "模型 token 用量", labels + ",kind=\"prompt\"");
+        account.completionCounter = &metrics.counter("synapse_provider_tokens_total", "模型 token 用量", labels + ",kind=\"completion\"");
+        // 计数器是整数，费用按百万分之一美元记
+        account.costCounter = &metrics.counter("synapse_provider_cost_microdollars_total", "估算费用 (百万分之一美元)", labels);
+        for (size_t r = 0; r < size(DENIAL_REASONS); ++r) {
+            account.denials[r] = &metrics.counter("synapse_budget_denials_total", "因限速 / 预算被拒的调用数",
+                                                  labels + ",reason=\"" + DENIAL_REASONS[r] + "\"");
+        }
+    }
+}
+
+bool UsageLedger::parseUsage(string_view json, TokenUsage& usage) {
+    size_t block = json.rfind("\"usage\"");
+    if (block != string_view::npos) {
+        string_view tail = json.substr(block);
+        bool found = extractNumber(tail, "prompt_tokens", usage.prompt);
+        found |= extractNumber(tail, "completion_tokens", usage.completion);
+        return found;
+    }
+    bool found = extractNumber(json, "prompt_eval_count", usage.prompt);
+    found |= extractNumber(json, "eval_count", usage.completion);
+    return found;
+}
+
+UsageLedger::Account* UsageLedger::find(const string& provider) {
+    for (auto& account : accounts) {
+        if (account.name == provider) return &account;
+    }
+    return nullptr;
+}
+
+void UsageLedger::refill(Account& account, int64_t now) {
+    const Limits& limits = account.limits;
+    if (account.refilledAtNs == 0) {
+        account.requestTokens = limits.rpm;
+        account.tokenBudget = limits.tpm;
+    } else {
+        double minutes = (now - account.refilledAtNs) / 60e9;
+        account.requestTokens = min(limits.rpm, account.requestTokens + minutes * limits.rpm);
+        account.tokenBudget = min(limits.tpm, account.tokenBudget + minutes * limits.tpm);
+    }
+    account.refilledAtNs = now;
+
+    int today = localDay();
+    if (account.day != today) {
+        account.day = today;
+        account.requests = account.promptTokens = account.completionTokens = account.denied = 0;
+        account.usd = 0;
+    }
+}
+
+bool UsageLedger::tryAcquire(const string& provider, string* reason) {
+    lock_guard<mutex> lock(mtx);
+    Account* account = find(provider);
+    if (!account) return true;
+    refill(*account, nowNs());
+
+    const Limits& limits = account->limits;
+    int denied = -1; // DENIAL_REASONS 的下标
+    if (limits.dailyUsd > 0 && account->usd >= limits.dailyUsd) denied = 0;
+    else if (limits.dailyTokens > 0 && account->promptTokens + account->completionTokens >= limits.dailyTokens) denied = 1;
+    else if (limits.tpm > 0 && account->tokenBudget <= 0) denied = 2;
+    else if (limits.rpm > 0 && account->requestTokens < 1) denied = 3;
+
+    if (denied >= 0) {
+        ++account->denied;
+        account->denials[denied]->inc();
+        if (reason) *reason = DENIAL_REASONS[denied];
+        return false;
+    }
+    if (limits.rpm > 0) account->requestTokens -= 1;
+    return true;
+}
+
+void UsageLedger::record(const string& provider, const TokenUsage& usage) {
+    lock_guard<mutex> lock(mtx);
+    Account* account = find(provider);
+    if (!account) return;
+    refill(*account, nowNs());
+
+    const Limits& limits = account->limits;
+    double usd = (usage.prompt * limits.priceIn + usage.completion * limits.priceOut) / 1e6;
+    ++account->requests;
+    account->promptTokens += usage.prompt;
+    account->completionTokens += usage.completion;
+    account->usd += usd;
+    if (limits.tpm > 0) account->tokenBudget -= static_cast<double>(usage.prompt + usage.completion);
+
+    account->requestCounter->inc();
+    account->promptCounter->inc(usage.prompt);
+    account->completionCounter->inc(usage.completion);
+    account->costCounter->inc(static_cast<uint64_t>(usd * 1e6 + 0.5));
+}
+
+void UsageLedger::recordResponse(const string& provider, string_view json) {
+    TokenUsage usage;
+    parseUsage(json, usage);
+    record(provider, usage);
+}
+
+void UsageLedger::writeSummary(ostream& out) const {
+    lock_guard<mutex> lock(mtx);
+    bool header = false;
+    for (const auto& account : accounts) {
+        if (account.requests == 0 && account.denied == 0) continue;
+        if (!header) {
+            out << "[Usage] 今日模型用量" << endl;
+            header = true;
+        }
+        out << "  " << account.name << ": " << account.requests << " 次请求, token " << account.promptTokens
+            << " 入 / " << account.completionTokens << " 出, 约 $" << fixed << setprecision(4) << account.usd
+            << defaultfloat;
+        if (account.limits.dailyUsd > 0) out << " (日预算 $" << account.limits.dailyUsd << ")";
+        if (account.denied) out << ", 被限额拒绝 " << account.denied << " 次";
+        out << endl;
+    }
+}
@@ -0,0 +1,431 @@
+// synapse_bench: 热路径微基准 (解析、安全检查、搜索)
+//
+// 每个被测函数分别喂"真实尺寸"和"对抗尺寸"的合成输入，报告每次调用的耗时和吞吐；
+// 结果可以存成 JSON 基线，下次用 --baseline 对比，退化超过阈值的函数单独标出来，
+// 退化时退出码为 3，方便挂在 CI 上。
+// --fixture 指向 synapse_fixture 生成的大树时，额外测路径搜索的热缓存耗时；
+// 再加 --cold 会在每次调用前清页缓存 (需要 root)，测冷缓存耗时。
+//
+// 用法: synapse_bench [--filter SUBSTR] [--min-time MS] [--json FILE] [--baseline FILE] [--threshold F]
+//                     [--fixture DIR [--cold]]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "security_guard.h"
+#include "local_brain.h"
+#include "cloud_brain.h"
+#include "GrokBrain.h"
+#include "FileCreator.h"
+#include "FileDeleter.h"
+#include "JsonUtil.h"
+#include "SessionChannel.h"
+#include "Tracer.h"
+
+#ifndef SYNAPSE_BUILD_TYPE
+#define SYNAPSE_BUILD_TYPE "unknown"
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+using Clock = chrono::steady_clock;
+
+struct BenchCase {
+    string name;              // 函数/输入规模，如 SecurityGuard::check/realistic
+    size_t bytes = 0;         // 每次调用处理的输入字节数，用来算吞吐
+    function<size_t()> body;  // 返回值累加进 sink，防止整段调用被优化掉
+};
+
+struct BenchResult {
+    string name;
+    double nsPerOp = 0;
+    double mbPerSec = 0;
+    size_t iterations = 0;
+};
+
+static volatile size_t sink = 0;
+
+// 先倍增迭代次数直到单轮超过 minTime，再跑 5 轮取中位数
+static BenchResult runCase(const BenchCase& bench, double minTimeMs) {
+    size_t iterations = 1;
+    auto timeRound = [&](size_t n) {
+        auto start = Clock::now();
+        size_t acc = 0;
+        for (size_t i = 0; i < n; ++i) acc += bench.body();
+        sink = sink + acc;
+        return chrono::duration<double, milli>(Clock::now() - start).count();
+    };
+    while (true) {
+        double ms = timeRound(iterations);
+        if (ms >= minTimeMs || iterations >= (1ull << 30)) break;
+        iterations *= (ms < minTimeMs / 10) ? 10 : 2;
+    }
+
+    vector<double> samples;
+    for (int round = 0; round < 5; ++round) samples.push_back(timeRound(iterations) * 1e6 / iterations);
+    sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = bench.name;
+    result.iterations = iterations;
+    result.nsPerOp = samples[samples.size() / 2];
+    if (bench.bytes > 0) result.mbPerSec = (bench.bytes / 1048576.0) / (result.nsPerOp / 1e9);
+    return result;
+}
+
+// ==========================================
+// 合成输入
+// ==========================================
+
+static string repeat(const string& unit, size_t totalBytes) {
+    string out;
+    out.reserve(totalBytes + unit.size());
+    while (out.size() < totalBytes) out += unit;
+    return out;
+}
+
+// 中英混排的提示词，带引号、换行和少量控制字符
+static string promptText(size_t bytes) {
+    return repeat("用户说：\"在桌面建个 report.txt\"\n规则：严格输出一行\t{Names|Quantity|Path}\\ \x01", bytes);
+}
+
+static string ollamaResponse(const string& content, size_t contextInts) {
+    string json = "{\"model\":\"qwen2.5-coder:1.5b\",\"created_at\":\"2026-10-19T07:00:00Z\",\"response\":\"" +
+                  JsonUtil::escape(content) + "\",\"done\":true,\"context\":[";
+    for (size_t i = 0; i < contextInts; ++i) json += (i ? "," : "") + to_string(151643 + i % 1000);
+    return json + "],\"total_duration\":812345678,\"eval_count\":12}";
+}
+
+static string chatResponse(const string& content) {
+    return "{\"id\":\"chatcmpl-1\",\"object\":\"chat.completion\",\"model\":\"deepseek-chat\",\"choices\":[{\"index\":0,"
+           "\"message\":{\"role\":\"assistant\",\"content\":\"" + JsonUtil::escape(content) +
+           "\"},\"finish_reason\":\"stop\"}],\"usage\":{\"prompt_tokens\":812,\"completion_tokens\":64,\"total_tokens\":876}}";
+}
+
+// 合成的 home：top 个一级目录，每层 fanout 个子目录，共 depth 层；部分目录名带 project
+static size_t buildHome(const fs::path& root, size_t top, size_t fanout, int depth) {
+    size_t count = 0;
+    function<void(const fs::path&, int)> grow = [&](const fs::path& dir, int level) {
+        if (level >= depth) return;
+        for (size_t i = 0; i < fanout; ++i) {
+            fs::path child = dir / ((i % 7 == 3 ? "project_" : "dir_") + to_string(level) + "_" + to_string(i));
+            fs::create_directories(child);
+            count++;
+            grow(child, level + 1);
+        }
+    };
+    for (const char* name : {"Desktop", "Documents", "Downloads"}) fs::create_directories(root / name);
+    for (size_t i = 0; i < top; ++i) {
+        fs::path dir = root / ("work_" + to_string(i));
+        fs::create_directories(dir);
+        count++;
+        grow(dir, 1);
+    }
+    return count;
+}
+
+// 参照实现：进程内遍历，不 fork find、不跟符号链接，深度和 find -maxdepth 4 一致
+// 用来衡量换成进程内索引/遍历能省多少
+static size_t walkFind(const string& root, const string& name) {
+    size_t hits = 0;
+    error_code ec;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        if (it->path().filename() == name) hits++;
+        if (it.depth() >= 3) it.disable_recursion_pending();
+    }
+    return hits;
+}
+
+// 清页缓存 (dentry/inode 一起)，失败说明没权限
+static bool dropCaches() {
+    sync();
+    ofstream out("/proc/sys/vm/drop_caches");
+    if (!out.is_open()) return false;
+    out << "3" << endl;
+    return out.good();
+}
+
+// ==========================================
+// 用例
+// ==========================================
+
+static vector<BenchCase> buildCases(SecurityGuard& guard, const fs::path& smallHome, const fs::path& largeHome) {
+    vector<BenchCase> cases;
+    auto add = [&](string name, size_t bytes, function<size_t()> body) {
+        cases.push_back({move(name), bytes, move(body)});
+    };
+
+    // --- SecurityGuard::check ---
+    static const string guardRealistic = "rm -rf /home/ubuntu/Desktop/old_report_2026.txt";
+    static const string guardLs = "ls -la /home/ubuntu/Documents/project";
+    static const string guardLong = "cat " + repeat("/home/ubuntu/Documents/a/", 64 * 1024);
+    static const string guardManyRm = "rm " + repeat("/home/ubuntu/Desktop/notes_01.txt ", 16 * 1024);
+    add("SecurityGuard::check/realistic_rm", guardRealistic.size(), [&] { return (size_t)guard.check(guardRealistic); });
+    add("SecurityGuard::check/realistic_ls", guardLs.size(), [&] { return (size_t)guard.check(guardLs); });
+    add("SecurityGuard::check/adversarial_64k_path", guardLong.size(), [&] { return (size_t)guard.check(guardLong); });
+    add("SecurityGuard::check/adversarial_16k_rm_args", guardManyRm.size(), [&] { return (size_t)guard.check(guardManyRm); });
+
+    // --- LocalBrain::extractResponse ---
+    static const string ollamaSmall = ollamaResponse("CREATE", 64);
+    static const string ollamaContext = ollamaResponse("report.txt|1|桌面", 8192);
+    static const string ollamaEscapes = ollamaResponse(promptText(64 * 1024), 0);
+    add("LocalBrain::extractResponse/realistic", ollamaSmall.size(), [&] { return LocalBrain::extractResponse(ollamaSmall).size(); });
+    add("LocalBrain::extractResponse/adversarial_8k_context", ollamaContext.size(), [&] { return LocalBrain::extractResponse(ollamaContext).size(); });
+    add("LocalBrain::extractResponse/adversarial_64k_escapes", ollamaEscapes.size(), [&] { return LocalBrain::extractResponse(ollamaEscapes).size(); });
+
+    // --- CloudBrain::extractContent ---
+    static const string chatSmall = chatResponse("【评分】92\n【审计结论】流程正常\n【是否入库】是\n{\"type\":\"EXEC_CORRECTION\",\"input\":\"在桌面建个a\",\"output\":\"a|1|桌面\"}");
+    static const string chatLarge = chatResponse(promptText(64 * 1024));
+    add("CloudBrain::extractContent/realistic", chatSmall.size(), [&] { return CloudBrain::extractContent(chatSmall).size(); });
+    add("CloudBrain::extractContent/adversarial_64k_escapes", chatLarge.size(), [&] { return CloudBrain::extractContent(chatLarge).size(); });
+
+    // --- JSON 转义 (四份实现) ---
+    static const string promptSmall = promptText(2 * 1024);
+    static const string promptLarge = promptText(1024 * 1024);
+    static const string quotesLarge = repeat("\"\\\n\t", 1024 * 1024);
+    struct Escaper { const char* name; string (*fn)(const string&); };
+    static const Escaper escapers[] = {
+        {"JsonUtil::escape", [](const string& s) { return JsonUtil::escape(s); }},
+        {"LocalBrain::jsonEscape", [](const string& s) { return LocalBrain::jsonEscape(s); }},
+        {"CloudBrain::jsonEscape", [](const string& s) { return CloudBrain::jsonEscape(s); }},
+        {"GrokBrain::jsonEscape", [](const string& s) { return GrokBrain::jsonEscape(s); }},
+    };
+    for (const auto& e : escapers) {
+        auto fn = e.fn;
+        add(string(e.name) + "/realistic_2k_prompt", promptSmall.size(), [fn] { return fn(promptSmall).size(); });
+        add(string(e.name) + "/adversarial_1m_prompt", promptLarge.size(), [fn] { return fn(promptLarge).size(); });
+        add(string(e.name) + "/adversarial_1m_quotes", quotesLarge.size(), [fn] { return fn(quotesLarge).size(); });
+    }
+
+    // --- FileCreator::parseNames / splitString ---
+    static const string namesSmall = "report，notes、main.cpp, 周报";
+    static const string namesLarge = repeat("周报_2026，", 64 * 1024);
+    static const string slotsSmall = "report.txt,notes|2|桌面";
+    static const string slotsLarge = repeat("a_long_file_name.txt|", 64 * 1024);
+    add("FileCreator::parseNames/realistic", namesSmall.size(), [&] { return FileCreator::parseNames(namesSmall).size(); });
+    add("FileCreator::parseNames/adversarial_64k_cjk_commas", namesLarge.size(), [&] { return FileCreator::parseNames(namesLarge).size(); });
+    add("FileCreator::splitString/realistic", slotsSmall.size(), [&] { return FileCreator::splitString(slotsSmall, '|').size(); });
+    add("FileCreator::splitString/adversarial_64k", slotsLarge.size(), [&] { return FileCreator::splitString(slotsLarge, '|').size(); });
+
+    // --- FileDeleter 正则兜底 ---
+    static const string deleteSmall = "帮我把 /tmp/build.log 和 周报.docx 删了";
+    static const string deleteNoMatch = repeat("帮我把那个没有后缀的文件删掉吧 ", 4 * 1024);
+    static const string deleteManyPaths = repeat("/var/log/app/err.log ", 4 * 1024);
+    add("FileDeleter::extractTargetsByPattern/realistic", deleteSmall.size(), [&] { return FileDeleter::extractTargetsByPattern(deleteSmall).size(); });
+    add("FileDeleter::extractTargetsByPattern/adversarial_4k_nomatch", deleteNoMatch.size(), [&] { return FileDeleter::extractTargetsByPattern(deleteNoMatch).size(); });
+    add("FileDeleter::extractTargetsByPattern/adversarial_4k_paths", deleteManyPaths.size(), [&] { return FileDeleter::extractTargetsByPattern(deleteManyPaths).size(); });
+
+    // --- TraceSpan：常开的 span 记录本身的开销 ---
+    add("TraceSpan/record", 0, [] {
+        TraceSpan span("bench", "span");
+        span.arg("n", 1);
+        return (size_t)1;
+    });
+
+    // --- FileCreator::searchDirectories (searchPaths 的同步部分，含 find) ---
+    string small = smallHome.string(), large = largeHome.string();
+    add("FileCreator::searchPaths/realistic_small_home", 0, [small] { return FileCreator::searchDirectories("project", small).size(); });
+    add("FileCreator::searchPaths/alias_hit", 0, [small] { return FileCreator::searchDirectories("Desk", small).size(); });
+    add("FileCreator::searchPaths/adversarial_large_home_nomatch", 0, [large] { return FileCreator::searchDirectories("zz_nothing", large).size(); });
+    return cases;
+}
+
+// synapse_fixture 生成的树：针在第 1/3/5/最深层，find 只到 4 层，命中数本身也是结果的一部分
+static vector<BenchCase> buildFixtureCases(const string& fixture) {
+    vector<BenchCase> cases;
+    auto add = [&](string name, function<size_t()> body) { cases.push_back({"fixture/" + move(name), 0, move(body)}); };
+    add("FileCreator::searchPaths/needle_dir", [fixture] { return FileCreator::searchDirectories("synapse_needle", fixture).size(); });
+    add("FileCreator::searchPaths/cjk_needle_dir", [fixture] { return FileCreator::searchDirectories("项目_needle", fixture).size(); });
+    add("FileCreator::searchPaths/nomatch", [fixture] { return FileCreator::searchDirectories("zz_nothing", fixture).size(); });
+    add("FileDeleter::searchFileInSystem/needle_file", [fixture] { return FileDeleter::findFiles("synapse_needle.txt", fixture).size(); });
+    add("reference_walk/needle_file", [fixture] { return walkFind(fixture, "synapse_needle.txt"); });
+    return cases;
+}
+
+// ==========================================
+// 基线
+// ==========================================
+
+static string toJson(const vector<BenchResult>& results) {
+    ostringstream out;
+    out << fixed << setprecision(1);
+    out << "{\n  \"build\": \"" << SYNAPSE_BUILD_TYPE << "\",\n  \"results\": {\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    \"" << JsonUtil::escape(r.name) << "\": {\"ns_per_op\": " << r.nsPerOp
+            << ", \"mb_per_s\": " << r.mbPerSec << ", \"iterations\": " << r.iterations << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  }\n}\n";
+    return out.str();
+}
+
+// 只取每个用例的 ns_per_op；格式就是 toJson 写出的那种
+static bool loadBaseline(const string& path, vector<pair<string, double>>& out, string& build) {
+    ifstream in(path);
+    if (!in.is_open()) return false;
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    JsonUtil::extractString(text, "build", build);
+    size_t pos = 0;
+    while ((pos = text.find("\": {\"ns_per_op\": ", pos)) != string::npos) {
+        size_t nameEnd = pos;
+        size_t nameStart = text.rfind('"', nameEnd - 1);
+        if (nameStart == string::npos) break;
+        string name = text.substr(nameStart + 1, nameEnd - nameStart - 1);
+        pos += 17;
+        out.emplace_back(name, atof(text.c_str() + pos));
+    }
+    return true;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options]\n"
+         << "  --filter SUBSTR   只跑名字包含 SUBSTR 的用例\n"
+         << "  --min-time MS     每轮最短时长 (默认 100)\n"
+         << "  --json FILE       把结果写成 JSON 基线\n"
+         << "  --baseline FILE   与已有基线对比\n"
+         << "  --threshold F     比基线慢多少算退化 (默认 0.15 = 15%)\n"
+         << "  --fixture DIR     额外在 synapse_fixture 生成的树上测路径搜索\n"
+         << "  --cold            fixture 用例再测冷缓存 (每次调用前清页缓存，需要 root)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string filter, jsonPath, baselinePath, fixture;
+    double minTimeMs = 100, threshold = 0.15;
+    bool cold = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) filter = argv[++i];
+        else if (arg == "--min-time" && hasValue) minTimeMs = atof(argv[++i]);
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = atof(argv[++i]);
+        else if (arg == "--fixture" && hasValue) fixture = argv[++i];
+        else if (arg == "--cold") cold = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // SecurityGuard 构造和拦截时会打提示，基准期间全部吞掉
+    MemoryChannel quiet;
+    SessionChannel::bind(&quiet);
+    ostringstream discard;
+    streambuf* cerrBuf = cerr.rdbuf(discard.rdbuf());
+    SecurityGuard guard;
+    cerr.rdbuf(cerrBuf);
+
+    fs::path root = fs::temp_directory_path() / ("synapse_bench_" + to_string(getpid()));
+    size_t smallDirs = buildHome(root / "small", 4, 6, 3);
+    size_t largeDirs = buildHome(root / "large", 16, 8, 4);
+    cout << "[Bench] build=" << SYNAPSE_BUILD_TYPE << "  合成 home: small " << smallDirs << " 个目录, large "
+         << largeDirs << " 个目录" << endl;
+
+    vector<BenchCase> cases = buildCases(guard, root / "small", root / "large");
+    vector<BenchCase> fixtureCases;
+    if (!fixture.empty()) {
+        ifstream manifest(fs::path(fixture) / ".synapse_fixture.json");
+        string text((istreambuf_iterator<char>(manifest)), istreambuf_iterator<char>());
+        if (text.empty()) {
+            cerr << "[Error] " << fixture << " 不是 synapse_fixture 生成的目录" << endl;
+            return 1;
+        }
+        size_t pos = text.find("\"entries\":");
+        cout << "[Bench] fixture " << fixture << ": " << (pos == string::npos ? 0 : atoll(text.c_str() + pos + 10)) << " 个条目" << endl;
+        for (auto& bench : buildFixtureCases(fixture)) {
+            if (!filter.empty() && bench.name.find(filter) == string::npos) continue;
+            cout << "[Bench]   " << bench.name << " 命中 " << bench.body() << endl;
+            fixtureCases.push_back(bench);
+        }
+        cases.insert(cases.end(), fixtureCases.begin(), fixtureCases.end());
+    }
+
+    vector<BenchResult> results;
+    cout << left << setw(58) << "case" << right << setw(14) << "ns/op" << setw(12) << "MB/s" << endl;
+    for (const auto& bench : cases) {
+        if (!filter.empty() && bench.name.find(filter) == string::npos) continue;
+        cerr.rdbuf(discard.rdbuf());
+        BenchResult r = runCase(bench, minTimeMs);
+        cerr.rdbuf(cerrBuf);
+        discard.str("");
+        quiet.takeOutput();
+        cout << left << setw(58) << r.name << right << fixed << setprecision(1) << setw(14) << r.nsPerOp;
+        if (r.mbPerSec > 0) cout << setw(12) << r.mbPerSec;
+        cout << endl;
+        results.push_back(r);
+    }
+
+    // 冷缓存：每次调用前清页缓存，单次计时，3 次取中位数
+    if (cold && !fixtureCases.empty()) {
+        if (!dropCaches()) {
+            cout << "[Bench] 冷缓存用例跳过：无法写 /proc/sys/vm/drop_caches (需要 root)" << endl;
+        } else {
+            for (const auto& bench : fixtureCases) {
+                vector<double> samples;
+                for (int round = 0; round < 3; ++round) {
+                    dropCaches();
+                    auto start = Clock::now();
+                    sink = sink + bench.body();
+                    samples.push_back(chrono::duration<double, nano>(Clock::now() - start).count());
+                }
+                sort(samples.begin(), samples.end());
+                BenchResult r{bench.name + "/cold", samples[1], 0, 1};
+                quiet.takeOutput();
+                cout << left << setw(58) << r.name << right << fixed << setprecision(1) << setw(14) << r.nsPerOp << endl;
+                results.push_back(r);
+            }
+        }
+    }
+    SessionChannel::bind(nullptr);
+
+    error_code ec;
+    fs::remove_all(root, ec);
+
+    if (!jsonPath.empty()) {
+        ofstream out(jsonPath);
+        if (!out.is_open()) {
+            cerr << "[Error] 无法写入: " << jsonPath << endl;
+            return 1;
+        }
+        out << toJson(results);
+        cout << "[Bench] 基线已写入 " << jsonPath << endl;
+    }
+
+    int regressions = 0;
+    if (!baselinePath.empty()) {
+        vector<pair<string, double>> baseline;
+        string build;
+        if (!loadBaseline(baselinePath, baseline, build)) {
+            cerr << "[Error] 无法读取基线: " << baselinePath << endl;
+            return 1;
+        }
+        if (build != SYNAPSE_BUILD_TYPE) {
+            cout << "[Bench] ⚠️  基线的构建类型是 " << build << "，当前是 " << SYNAPSE_BUILD_TYPE << "，对比仅供参考" << endl;
+        }
+        cout << endl << left << setw(58) << "case" << right << setw(14) << "baseline" << setw(14) << "now" << setw(10) << "ratio" << endl;
+        for (const auto& r : results) {
+            auto it = find_if(baseline.begin(), baseline.end(), [&](const auto& b) { return b.first == r.name; });
+            if (it == baseline.end() || it->second <= 0) continue;
+            double ratio = r.nsPerOp / it->second;
+            bool regressed = ratio > 1.0 + threshold;
+            if (regressed) regressions++;
+            cout << left << setw(58) << r.name << right << fixed << setprecision(1) << setw(14) << it->second
+                 << setw(14) << r.nsPerOp << setprecision(2) << setw(10) << ratio
+                 << (regressed ? "  REGRESSION" : (ratio < 1.0 - threshold ? "  faster" : "")) << endl;
+        }
+        cout << "[Bench] 退化 " << regressions << " 项 (阈值 " << threshold * 100 << "%)" << endl;
+    }
+    return regressions > 0 ? 3 : 0;
+}
@@ -0,0 +1,432 @@
+// synapse_dataset: 训练数据离线工具
+// 把 training_data/ 下 DeepSeek 审计日志里的 input/output 挖出来，导出成微调数据集
+//
+// 用法: synapse_dataset export [--format chat|alpaca|modelfile] [--out FILE]
+//                              [--task CREATE|DELETE] [--threads N] [--all]
+//                              [--near-dup K] [路径...]
+//       synapse_dataset intent-train [--out FILE] [--epochs N] [--holdout F] [路径...]
+//       synapse_dataset intent-eval --model FILE [路径...]
+//       synapse_dataset synth [--count N] [--seed N] [--lang zh|en|mix] [--format jsonl|tsv|text]
+//                             [--delete-ratio F] [--other-ratio F] [--out FILE] [--bench] [--threads N]
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandGrammar.h"
+#include "DatasetLoader.h"
+#include "DatasetExporter.h"
+#include "IntentClassifier.h"
+#include "JsonUtil.h"
+
+using namespace std;
+
+static void printUsage() {
+    cerr << "用法: synapse_dataset <command> [选项] [路径...]\n"
+         << "\n"
+         << "命令:\n"
+         << "  export        导出去重后的微调数据集\n"
+         << "  intent-train  训练意图分类器，并在留出集上报告准确率\n"
+         << "  intent-eval   用已有模型在数据上评估准确率\n"
+         << "  synth         用文法离线生成带标签的合成指令 (压测、预热缓存、训练分类器)\n"
+         << "\n"
+         << "export 选项:\n"
+         << "  --format F   chat (默认) | alpaca | modelfile\n"
+         << "  --out FILE   输出文件，默认 stdout\n"
+         << "  --task T     只导出 CREATE 或 DELETE\n"
+         << "  --threads N  解析线程数，默认全部核心\n"
+         << "  --all        包含【是否入库】= 否 的样本\n"
+         << "  --near-dup K MinHash 近重复剔除，每簇最多保留 K 条\n"
+         << "\n"
+         << "intent-train 选项:\n"
+         << "  --out FILE   模型输出路径，默认 training_data/intent_model.bin\n"
+         << "  --epochs N   训练轮数，默认 5\n"
+         << "  --holdout F  留出集比例 (按输入哈希切分，稳定可复现)，默认 0.2\n"
+         << "  --synthetic N 额外混入 N 条合成指令 (只进训练集)\n"
+         << "\n"
+         << "intent-eval 选项:\n"
+         << "  --model FILE 要评估的模型\n"
+         << "\n"
+         << "synth 选项:\n"
+         << "  --count N    生成条数，默认 1000\n"
+         << "  --seed N     随机种子，相同种子输出相同，默认 1\n"
+         << "  --lang L     zh | en | mix (默认)\n"
+         << "  --format F   jsonl (默认，可直接当 --batch 输入) | tsv (text\\tintent\\tslots) | text\n"
+         << "  --delete-ratio F / --other-ratio F  删除 / 闲聊占比，默认 0.35 / 0.1\n"
+         << "  --out FILE   输出文件，默认 stdout\n"
+         << "  --bench      只生成不输出，报告吞吐 (配合 --threads N)\n"
+         << "\n"
+         << "路径可以是目录 (递归收集 .txt/.log) 或多会话拼接的训练仓库文件，默认 training_data\n";
+}
+
+static int runExport(int argc, char** argv) {
+    ExportOptions options;
+    string outPath;
+    unsigned threads = 0;
+    vector<string> roots;
+
+    for (int i = 0; i < argc; ++i) {
+        string arg = argv[i];
+        auto needValue = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                cerr << "[Error] " << name << " 需要参数" << endl;
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--format") {
+            const char* v = needValue("--format");
+            if (!v || !DatasetExporter::parseFormat(v, options.format)) {
+                cerr << "[Error] 未知格式: " << (v ? v : "") << endl;
+                return 2;
+            }
+        } else if (arg == "--out") {
+            const char* v = needValue("--out");
+            if (!v) return 2;
+            outPath = v;
+        } else if (arg == "--task") {
+            const char* v = needValue("--task");
+            if (!v) return 2;
+            options.taskFilter = v;
+        } else if (arg == "--threads") {
+            const char* v = needValue("--threads");
+            if (!v) return 2;
+            threads = static_cast<unsigned>(atoi(v));
+        } else if (arg == "--near-dup") {
+            const char* v = needValue("--near-dup");
+            if (!v) return 2;
+            options.nearDupRepresentatives = static_cast<size_t>(atoi(v));
+        } else if (arg == "--all") {
+            options.includeRejected = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        } else {
+            roots.push_back(arg);
+        }
+    }
+    if (roots.empty()) roots.push_back("training_data");
+
+    // Modelfile 只有一个 SYSTEM，混合任务没有意义，默认只导创建任务
+    if (options.format == ExportFormat::Modelfile && options.taskFilter.empty()) {
+        options.taskFilter = "CREATE";
+        cerr << "[Info] modelfile 格式未指定 --task，默认导出 CREATE" << endl;
+    }
+
+    DatasetStats stats;
+    vector<TrainingExample> examples = DatasetLoader::load(roots, threads, &stats);
+
+    SelectStats selectStats;
+    vector<const TrainingExample*> selected = DatasetExporter::select(examples, options, &selectStats);
+
+    if (outPath.empty()) {
+        DatasetExporter::write(cout, selected, options);
+        cout.flush();
+    } else {
+        ofstream out(outPath, ios::binary);
+        if (!out.is_open()) {
+            cerr << "[Error] 无法写入: " << outPath << endl;
+            return 1;
+        }
+        DatasetExporter::write(out, selected, options);
+    }
+
+    double secs = stats.seconds > 0 ? stats.seconds : 1e-9;
+    cerr << "[Dataset] 文件 " << stats.files
+         << " | 会话 " << stats.sessions
+         << " | 含训练块 " << stats.examples
+         << " | 导出 " << selected.size()
+         << " | 重复 " << selectStats.duplicates;
+    if (options.nearDupRepresentatives > 0) {
+        cerr << " | 近重复剔除 " << selectStats.nearDuplicates << " (簇 " << selectStats.clusters << ")";
+    }
+    cerr << endl;
+    cerr << "[Dataset] 解析耗时 " << stats.seconds * 1000.0 << " ms, "
+         << static_cast<size_t>(stats.sessions / secs) << " 会话/秒, "
+         << (stats.bytes / 1048576.0) / secs << " MB/秒" << endl;
+    return 0;
+}
+
+struct LabelledText {
+    std::string text;
+    std::string label;
+};
+
+static vector<LabelledText> loadLabelled(const vector<string>& roots, DatasetStats& stats) {
+    vector<LabelledText> data;
+    LabelledText item;
+    for (const auto& ex : DatasetLoader::load(roots, 0, &stats)) {
+        if (IntentClassifier::labelFor(ex, item.text, item.label)) data.push_back(item);
+    }
+    return data;
+}
+
+// 按输入哈希决定是否进留出集：同一句话永远落在同一侧，重复样本不会泄漏到测试集
+static bool inHoldout(const string& text, double ratio) {
+    return (hash<string>()(text) % 1000) < static_cast<size_t>(ratio * 1000);
+}
+
+static void reportAccuracy(const IntentClassifier& model, const vector<const LabelledText*>& data, const char* title) {
+    const int N = IntentClassifier::NUM_CLASSES;
+    size_t confusion[N][N] = {};
+    size_t correct = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (const auto* item : data) {
+        IntentPrediction pred = model.predict(item->text);
+        int truth = 0, guess = 0;
+        for (int c = 0; c < N; ++c) {
+            if (item->label == IntentClassifier::LABELS[c]) truth = c;
+            if (pred.label == IntentClassifier::LABELS[c]) guess = c;
+        }
+        confusion[truth][guess]++;
+        if (truth == guess) correct++;
+    }
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    cerr << "[Intent] " << title << ": " << data.size() << " 条，准确率 "
+         << (data.empty() ? 0.0 : 100.0 * correct / data.size()) << "%";
+    if (!data.empty()) cerr << "，平均预测 " << micros / data.size() << " 微秒";
+    cerr << endl;
+    cerr << "[Intent] 混淆矩阵 (行 = 真实，列 = 预测)  CREATE DELETE OTHER" << endl;
+    for (int t = 0; t < N; ++t) {
+        cerr << "[Intent]   " << IntentClassifier::LABELS[t];
+        for (int g = 0; g < N; ++g) cerr << " " << confusion[t][g];
+        cerr << endl;
+    }
+}
+
+static int runIntentTrain(int argc, char** argv) {
+    string outPath = "training_data/intent_model.bin";
+    int epochs = 5;
+    double holdout = 0.2;
+    size_t synthetic = 0;
+    vector<string> roots;
+
+    for (int i = 0; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "--out" || arg == "--epochs" || arg == "--holdout" || arg == "--synthetic") && i + 1 >= argc) {
+            cerr << "[Error] " << arg << " 需要参数" << endl;
+            return 2;
+        }
+        if (arg == "--out") outPath = argv[++i];
+        else if (arg == "--epochs") epochs = atoi(argv[++i]);
+        else if (arg == "--holdout") holdout = atof(argv[++i]);
+        else if (arg == "--synthetic") synthetic = strtoull(argv[++i], nullptr, 10);
+        else roots.push_back(arg);
+    }
+    if (roots.empty()) roots.push_back("training_data");
+
+    DatasetStats stats;
+    vector<LabelledText> data = loadLabelled(roots, stats);
+    vector<const LabelledText*> train, test;
+    for (const auto& item : data) {
+        (inHoldout(item.text, holdout) ? test : train).push_back(&item);
+    }
+
+    // 合成指令只补充训练集，留出集仍然全是真实会话，准确率不会被文法本身抬高
+    vector<LabelledText> generated(synthetic);
+    CommandGrammar grammar;
+    SyntheticCommand cmd;
+    for (auto& item : generated) {
+        grammar.next(cmd);
+        item.text = cmd.text;
+        item.label = cmd.intent;
+        train.push_back(&item);
+    }
+    cerr << "[Intent] 会话 " << stats.sessions << " | 带标签 " << data.size() << " | 合成 " << synthetic
+         << " | 训练 " << train.size() << " | 留出 " << test.size() << endl;
+
+    IntentClassifier model;
+    auto start = chrono::steady_clock::now();
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        // 学习率逐轮衰减，最后几轮微调
+        double lr = 0.2 / (1.0 + epoch);
+        for (const auto* item : train) model.update(item->text, item->label, lr, epoch == 0);
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cerr << "[Intent] 训练 " << epochs << " 轮耗时 " << ms << " ms" << endl;
+
+    reportAccuracy(model, train, "训练集");
+    reportAccuracy(model, test, "留出集");
+
+    if (!model.save(outPath)) {
+        cerr << "[Error] 无法写入模型: " << outPath << endl;
+        return 1;
+    }
+    cerr << "[Intent] 模型已保存至: " << outPath << endl;
+    return 0;
+}
+
+static int runIntentEval(int argc, char** argv) {
+    string modelPath;
+    vector<string> roots;
+    for (int i = 0; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--model" && i + 1 < argc) modelPath = argv[++i];
+        else roots.push_back(arg);
+    }
+    if (modelPath.empty()) {
+        cerr << "[Error] intent-eval 需要 --model FILE" << endl;
+        return 2;
+    }
+    if (roots.empty()) roots.push_back("training_data");
+
+    IntentClassifier model;
+    if (!model.load(modelPath)) {
+        cerr << "[Error] 无法加载模型: " << modelPath << endl;
+        return 1;
+    }
+
+    DatasetStats stats;
+    vector<LabelledText> data = loadLabelled(roots, stats);
+    vector<const LabelledText*> all;
+    for (const auto& item : data) all.push_back(&item);
+    cerr << "[Intent] 模型已训练样本 " << model.trainedExamples() << "，在线留出准确率 "
+         << 100.0 * model.heldOutAccuracy() << "%" << endl;
+    reportAccuracy(model, all, "评估集");
+    return 0;
+}
+
+static void appendRecord(string& buf, const SyntheticCommand& cmd, size_t index, const string& format) {
+    if (format == "text") {
+        buf += cmd.text;
+    } else if (format == "tsv") {
+        buf += cmd.text;
+        buf += '\t';
+        buf += cmd.intent;
+        buf += '\t';
+        buf += cmd.slots;
+    } else {
+        buf += "{\"id\":\"s";
+        buf += to_string(index);
+        buf += "\",\"command\":\"";
+        buf += JsonUtil::escape(cmd.text);
+        buf += "\",\"intent\":\"";
+        buf += cmd.intent;
+        buf += "\",\"slots\":\"";
+        buf += JsonUtil::escape(cmd.slots);
+        buf += "\",\"lang\":\"";
+        buf += cmd.lang;
+        buf += "\"}";
+    }
+    buf += '\n';
+}
+
+static int runSynth(int argc, char** argv) {
+    CommandGrammar::Options options;
+    size_t total = 1000;
+    string format = "jsonl";
+    string outPath;
+    bool bench = false;
+    unsigned threads = 1;
+
+    for (int i = 0; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--bench") bench = true;
+        else if (arg == "--count" && hasValue) total = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && hasValue) options.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--delete-ratio" && hasValue) options.deleteRatio = atof(argv[++i]);
+        else if (arg == "--other-ratio" && hasValue) options.otherRatio = atof(argv[++i]);
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--threads" && hasValue) threads = max(1, atoi(argv[++i]));
+        else if (arg == "--format" && hasValue) {
+            format = argv[++i];
+            if (format != "jsonl" && format != "tsv" && format != "text") {
+                cerr << "[Error] 未知格式: " << format << endl;
+                return 2;
+            }
+        } else if (arg == "--lang" && hasValue) {
+            if (!CommandGrammar::parseLanguage(argv[++i], options.language)) {
+                cerr << "[Error] 未知语言: " << argv[i] << endl;
+                return 2;
+            }
+        } else {
+            cerr << "[Error] 未知参数: " << arg << endl;
+            printUsage();
+            return 2;
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    size_t bytes = 0;
+
+    if (bench) {
+        // 每个线程一个生成器，种子错开；只累计长度防止被优化掉
+        vector<thread> workers;
+        vector<size_t> produced(threads, 0);
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                CommandGrammar::Options local = options;
+                local.seed = options.seed + t * 0x9e3779b97f4a7c15ULL;
+                CommandGrammar grammar(local);
+                SyntheticCommand cmd;
+                size_t n = total / threads + (t < total % threads ? 1 : 0);
+                size_t sum = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    grammar.next(cmd);
+                    sum += cmd.text.size() + cmd.slots.size();
+                }
+                produced[t] = sum;
+            });
+        }
+        for (auto& w : workers) w.join();
+        for (size_t b : produced) bytes += b;
+    } else {
+        FILE* out = outPath.empty() ? stdout : fopen(outPath.c_str(), "wb");
+        if (!out) {
+            cerr << "[Error] 无法写入: " << outPath << endl;
+            return 1;
+        }
+        CommandGrammar grammar(options);
+        SyntheticCommand cmd;
+        string buf;
+        buf.reserve(1 << 20);
+        for (size_t i = 0; i < total; ++i) {
+            grammar.next(cmd);
+            appendRecord(buf, cmd, i, format);
+            if (buf.size() >= (1 << 20)) {
+                bytes += fwrite(buf.data(), 1, buf.size(), out);
+                buf.clear();
+            }
+        }
+        bytes += fwrite(buf.data(), 1, buf.size(), out);
+        if (out != stdout) fclose(out);
+        else fflush(out);
+    }
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (secs <= 0) secs = 1e-9;
+    cerr << "[Synth] " << total << " 条，用时 " << secs * 1000.0 << " ms, "
+         << static_cast<size_t>(total / secs) << " 条/秒, " << (bytes / 1048576.0) / secs << " MB/秒"
+         << (bench ? " (bench, threads=" + to_string(threads) + ")" : "") << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 2;
+    }
+
+    string command = argv[1];
+    if (command == "export") return runExport(argc - 2, argv + 2);
+    if (command == "intent-train") return runIntentTrain(argc - 2, argv + 2);
+    if (command == "intent-eval") return runIntentEval(argc - 2, argv + 2);
+    if (command == "synth") return runSynth(argc - 2, argv + 2);
+    if (command == "-h" || command == "--help") {
+        printUsage();
+        return 0;
+    }
+
+    cerr << "[Error] 未知命令: " << command << endl;
+    printUsage();
+    return 2;
+}
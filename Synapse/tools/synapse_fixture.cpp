@@ -0,0 +1,325 @@
+// synapse_fixture: 生成可复现的合成 home 目录树，给路径搜索做基准
+//
+// 搜索延迟很吃目录树的形状，线上用户的 home 又拿不到，所以按种子造一棵：
+// - 百万级条目，宽目录 (单目录上万文件) 和深链 (几十层) 混合
+// - 一部分目录/文件名是中文
+// - 符号链接环 (指向 ..、指向根、两两互指)
+// - 类似 bind mount 的重复子树：目录结构重建、文件硬链接，同名目标会出现在两个位置
+// - 在不同深度埋"针" (synapse_needle_d<深度> 目录、synapse_needle.txt 文件、项目_needle 目录)，
+//   synapse_bench --fixture 用它们当搜索关键词
+// 生成的统计和针的位置写在 <root>/.synapse_fixture.json
+//
+// 用法: synapse_fixture --root DIR [--entries N] [--seed N] [--depth N] [--fanout N] [--files N]
+//                       [--wide-ratio F] [--wide-size N] [--cjk-ratio F] [--loops N] [--duplicates N] [--force]
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "JsonUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static const char* const MANIFEST = ".synapse_fixture.json";
+
+struct Options {
+    string root;
+    size_t entries = 200000;
+    uint64_t seed = 1;
+    int depth = 24;
+    int fanout = 4;
+    int files = 12;
+    double wideRatio = 0.002;
+    size_t wideSize = 20000;
+    double cjkRatio = 0.3;
+    int loops = 16;
+    int duplicates = 4;
+    bool force = false;
+};
+
+struct Stats {
+    size_t dirs = 0;
+    size_t files = 0;
+    size_t symlinks = 0;
+    size_t hardlinks = 0;
+    int maxDepth = 0;
+};
+
+struct Needle {
+    string path;
+    string kind; // dir / file
+    int depth = 0;
+};
+
+class Generator {
+public:
+    explicit Generator(const Options& options) : options(options), state(options.seed) {}
+
+    bool run();
+
+private:
+    const Options& options;
+    uint64_t state;
+    Stats stats;
+    vector<vector<string>> dirsByDepth; // 埋针、挑重复子树时用
+    vector<Needle> needles;
+
+    uint64_t next() {
+        uint64_t x = (state += 0x9e3779b97f4a7c15ULL);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    size_t below(size_t n) { return n ? next() % n : 0; }
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    string dirName(size_t index);
+    string fileName(size_t index);
+    bool makeDir(const string& path, int depth);
+    bool makeFile(const string& path);
+    size_t entries() const { return stats.dirs + stats.files + stats.symlinks + stats.hardlinks; }
+
+    void plantNeedles();
+    void makeLoops();
+    void makeDuplicates();
+    void writeManifest(double seconds);
+};
+
+string Generator::dirName(size_t index) {
+    static const char* const ascii[] = {"src", "lib", "docs", "build", "test", "data", "cache", "assets", "node_modules",
+                                        "tmp", "img", "log", "backup", "config", "vendor", "pkg", "bin", "out", "Projects"};
+    static const char* const cjk[] = {"项目", "文档", "照片", "备份", "资料", "工作", "学习", "音乐", "报告", "会议", "合同", "草稿"};
+    string base = unit() < options.cjkRatio ? cjk[below(size(cjk))] : ascii[below(size(ascii))];
+    return base + "_" + to_string(index);
+}
+
+string Generator::fileName(size_t index) {
+    static const char* const stems[] = {"report", "notes", "main", "index", "photo", "readme", "dataset", "settings", "todo", "draft"};
+    static const char* const cjk[] = {"周报", "简历", "会议记录", "预算", "合同", "笔记", "通知"};
+    static const char* const exts[] = {".txt", ".md", ".cpp", ".py", ".json", ".jpg", ".log", ".docx", ".xlsx", ".bak", ""};
+    string base = unit() < options.cjkRatio ? cjk[below(size(cjk))] : stems[below(size(stems))];
+    return base + "_" + to_string(index) + exts[below(size(exts))];
+}
+
+bool Generator::makeDir(const string& path, int depth) {
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        cerr << "[Error] mkdir " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    stats.dirs++;
+    stats.maxDepth = max(stats.maxDepth, depth);
+    if ((int)dirsByDepth.size() <= depth) dirsByDepth.resize(depth + 1);
+    // 每层最多记 4096 个候选，百万条目时内存也有上界
+    auto& bucket = dirsByDepth[depth];
+    if (bucket.size() < 4096) bucket.push_back(path);
+    else bucket[below(bucket.size())] = path;
+    return true;
+}
+
+bool Generator::makeFile(const string& path) {
+    int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        cerr << "[Error] create " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    close(fd);
+    stats.files++;
+    return true;
+}
+
+bool Generator::run() {
+    auto start = chrono::steady_clock::now();
+    if (!makeDir(options.root, 0)) return false;
+    // 先写一个占位的 manifest，中途失败也能被 --force 识别为 fixture 目录
+    ofstream(options.root + "/" + MANIFEST) << "{}\n";
+
+    deque<pair<string, int>> queue;
+    queue.emplace_back(options.root, 0);
+    size_t reported = 0;
+    while (!queue.empty() && entries() < options.entries) {
+        auto [dir, depth] = queue.front();
+        queue.pop_front();
+
+        // 宽目录：一层上万个文件
+        size_t fileCount = unit() < options.wideRatio ? options.wideSize : below(2 * options.files + 1);
+        for (size_t i = 0; i < fileCount && entries() < options.entries; ++i) {
+            if (!makeFile(dir + "/" + fileName(i))) return false;
+        }
+
+        if (depth < options.depth) {
+            size_t subdirs = below(2 * options.fanout + 1);
+            for (size_t i = 0; i < subdirs && entries() < options.entries; ++i) {
+                string child = dir + "/" + dirName(i);
+                if (!makeDir(child, depth + 1)) return false;
+                queue.emplace_back(child, depth + 1);
+            }
+            // 深链：偶尔一路往下挖到最大深度，每层只有一个子目录
+            if (unit() < 0.01) {
+                string chain = dir;
+                for (int d = depth + 1; d <= options.depth && entries() < options.entries; ++d) {
+                    chain += "/" + dirName(d) + "c"; // 后缀 c 避免和同层兄弟目录重名
+                    if (!makeDir(chain, d)) return false;
+                    if (unit() < 0.3 && !makeFile(chain + "/" + fileName(d))) return false;
+                }
+            }
+        }
+        if (entries() - reported >= 100000) {
+            reported = entries();
+            cerr << "[Fixture] " << reported << " 个条目..." << endl;
+        }
+    }
+
+    plantNeedles();
+    makeDuplicates();
+    makeLoops();
+    writeManifest(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+void Generator::plantNeedles() {
+    vector<int> depths = {1, 3, 5, stats.maxDepth};
+    for (int d : depths) {
+        if (d <= 0 || d >= (int)dirsByDepth.size() || dirsByDepth[d].empty()) continue;
+        const string& parent = dirsByDepth[d][below(dirsByDepth[d].size())];
+        string dir = parent + "/synapse_needle_d" + to_string(d);
+        string cjkDir = parent + "/项目_needle_d" + to_string(d);
+        string file = parent + "/synapse_needle.txt";
+        if (makeDir(dir, d + 1)) needles.push_back({dir, "dir", d + 1});
+        if (makeDir(cjkDir, d + 1)) needles.push_back({cjkDir, "dir", d + 1});
+        if (makeFile(file)) needles.push_back({file, "file", d + 1});
+    }
+}
+
+// bind mount 做不了 (要 root)，用"目录重建 + 文件硬链接"近似：同一份内容出现在两条路径下
+void Generator::makeDuplicates() {
+    const size_t cap = 20000;
+    for (int i = 0; i < options.duplicates; ++i) {
+        // 第一份挑埋了针的那棵，保证搜索会碰到重复结果
+        string source;
+        if (i == 0 && !needles.empty()) source = fs::path(needles[needles.size() > 3 ? 3 : 0].path).parent_path().string();
+        else {
+            int d = 2 + static_cast<int>(below(3));
+            if (d >= (int)dirsByDepth.size() || dirsByDepth[d].empty()) continue;
+            source = dirsByDepth[d][below(dirsByDepth[d].size())];
+        }
+        if (source.empty() || source == options.root) continue;
+        string target = source + "_mirror";
+        error_code ec;
+        if (fs::exists(target, ec)) continue;
+
+        size_t copied = 0;
+        fs::create_directory(target, ec);
+        stats.dirs++;
+        for (auto it = fs::recursive_directory_iterator(source, ec); !ec && it != fs::recursive_directory_iterator() && copied < cap; it.increment(ec)) {
+            fs::path rel = fs::relative(it->path(), source, ec);
+            fs::path dst = fs::path(target) / rel;
+            if (it->is_symlink(ec)) continue;
+            if (it->is_directory(ec)) {
+                fs::create_directory(dst, ec);
+                stats.dirs++;
+            } else if (link(it->path().c_str(), dst.c_str()) == 0) {
+                stats.hardlinks++;
+            }
+            copied++;
+        }
+    }
+}
+
+void Generator::makeLoops() {
+    for (int i = 0; i < options.loops; ++i) {
+        int d = 1 + static_cast<int>(below(max(1, stats.maxDepth)));
+        if (d >= (int)dirsByDepth.size() || dirsByDepth[d].empty()) continue;
+        const string& dir = dirsByDepth[d][below(dirsByDepth[d].size())];
+        string link1 = dir + "/loop_up_" + to_string(i);
+        string link2 = dir + "/loop_root_" + to_string(i);
+        string a = dir + "/loop_a_" + to_string(i), b = dir + "/loop_b_" + to_string(i);
+        if (symlink("..", link1.c_str()) == 0) stats.symlinks++;
+        if (symlink(options.root.c_str(), link2.c_str()) == 0) stats.symlinks++;
+        // 两两互指：解析时 ELOOP
+        if (symlink(b.c_str(), a.c_str()) == 0) stats.symlinks++;
+        if (symlink(a.c_str(), b.c_str()) == 0) stats.symlinks++;
+    }
+}
+
+void Generator::writeManifest(double seconds) {
+    ofstream out(options.root + "/" + MANIFEST);
+    out << "{\"seed\":" << options.seed << ",\"entries\":" << entries() << ",\"dirs\":" << stats.dirs
+        << ",\"files\":" << stats.files << ",\"symlinks\":" << stats.symlinks << ",\"hardlinks\":" << stats.hardlinks
+        << ",\"max_depth\":" << stats.maxDepth << ",\"seconds\":" << seconds << ",\"needles\":[";
+    for (size_t i = 0; i < needles.size(); ++i) {
+        out << (i ? "," : "") << "{\"kind\":\"" << needles[i].kind << "\",\"depth\":" << needles[i].depth
+            << ",\"path\":\"" << JsonUtil::escape(needles[i].path) << "\"}";
+    }
+    out << "]}\n";
+    cerr << "[Fixture] " << options.root << ": " << entries() << " 个条目 (目录 " << stats.dirs << ", 文件 " << stats.files
+         << ", 符号链接 " << stats.symlinks << ", 硬链接 " << stats.hardlinks << ")，最大深度 " << stats.maxDepth
+         << "，针 " << needles.size() << " 个，用时 " << seconds << " s" << endl;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " --root DIR [options]\n"
+         << "  --entries N      目标条目数 (默认 200000)\n"
+         << "  --seed N         随机种子，相同参数生成相同的树 (默认 1)\n"
+         << "  --depth N        最大深度 (默认 24)\n"
+         << "  --fanout N       平均子目录数 (默认 4)\n"
+         << "  --files N        平均每目录文件数 (默认 12)\n"
+         << "  --wide-ratio F   宽目录概率 (默认 0.002)\n"
+         << "  --wide-size N    宽目录文件数 (默认 20000)\n"
+         << "  --cjk-ratio F    中文名比例 (默认 0.3)\n"
+         << "  --loops N        符号链接环组数 (默认 16)\n"
+         << "  --duplicates N   重复子树数 (默认 4)\n"
+         << "  --force          root 是已有的 fixture 时先删掉重建" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--force") options.force = true;
+        else if (arg == "--root" && hasValue) options.root = argv[++i];
+        else if (arg == "--entries" && hasValue) options.entries = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && hasValue) options.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--depth" && hasValue) options.depth = atoi(argv[++i]);
+        else if (arg == "--fanout" && hasValue) options.fanout = atoi(argv[++i]);
+        else if (arg == "--files" && hasValue) options.files = atoi(argv[++i]);
+        else if (arg == "--wide-ratio" && hasValue) options.wideRatio = atof(argv[++i]);
+        else if (arg == "--wide-size" && hasValue) options.wideSize = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--cjk-ratio" && hasValue) options.cjkRatio = atof(argv[++i]);
+        else if (arg == "--loops" && hasValue) options.loops = atoi(argv[++i]);
+        else if (arg == "--duplicates" && hasValue) options.duplicates = atoi(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    while (options.root.size() > 1 && options.root.back() == '/') options.root.pop_back();
+    if (options.root.empty() || options.depth < 1 || options.fanout < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // 只删自己生成过的目录，防止手滑把真实目录清空
+    error_code ec;
+    if (fs::exists(options.root, ec) && !fs::is_empty(options.root, ec)) {
+        if (!options.force || !fs::exists(fs::path(options.root) / MANIFEST, ec)) {
+            cerr << "[Error] " << options.root << " 已存在且不是空目录"
+                 << (options.force ? " (也不是 synapse_fixture 生成的)" : "，加 --force 重建") << endl;
+            return 1;
+        }
+        fs::remove_all(options.root, ec);
+    }
+
+    Generator generator(options);
+    return generator.run() ? 0 : 1;
+}
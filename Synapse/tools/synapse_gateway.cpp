@@ -0,0 +1,568 @@
+// synapse_gateway: 一台机器上多个 Synapse 进程共用一个 Ollama 的本地网关
+//
+// GUI 实例、--batch、压测各自直连 Ollama 时，CPU 推理被超额并发打满，不同进程要的模型来回换入换出。
+// 网关对 Synapse 来说就是一个 Ollama (/api/generate、/api/chat)，所有实例的请求在这里统一排队：
+// - 全局并发上限 (--parallel)：同时只有 N 个请求打到上游，对齐 Ollama 真实的并行度
+// - 优先级：X-Synapse-Priority: interactive 的请求永远排在 background 前面 (LocalBrain 会带上)
+// - 公平：同一优先级内按客户端 (X-Synapse-Client，Synapse 发的是 pid，没有就用对端地址) 轮转
+// - 按模型成批：优先派发和上游当前驻留模型相同的请求，连续最多 --batch 个，减少模型换入换出
+// - 合并：排队中或在途的请求体一字不差时，后来者直接共享结果；交互请求合并进还在排队的后台请求时，把它提到交互队列
+// - 常驻：转发时补上 keep_alive (--keep-alive)，--warm MODEL 启动时预加载并定期续期
+// - 准入：排队超过 --queue 时返回 503，Synapse 侧当作 Ollama 错误处理；连接数超过 --max-connections 时直接 503 并断开
+//   请求头 / 请求体超过固定上限、Content-Length 非法时返回 400 / 413 并断开
+// 其余路径 (如 /api/tags) 原样转发，不排队。GET /stats 返回网关自己的计数。
+//
+//   ./synapse_gateway --upstream http://localhost:11434 --parallel 2 --warm qwen2.5-coder:1.5b
+//   SYNAPSE_OLLAMA_URL=http://127.0.0.1:11435/api/generate ./synapse --daemon
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <curl/curl.h>
+
+#include "JsonUtil.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct GatewayOptions {
+    string host = "127.0.0.1";
+    int port = 11435;
+    string upstream = "http://localhost:11434";
+    int parallel = 1;
+    size_t batch = 8;
+    size_t queue = 512;
+    int maxConnections = 256;
+    string keepAlive = "30m";
+    vector<string> warm;
+    int warmInterval = 300; // 秒
+    long timeout = 300;     // 单个上游请求的超时 (秒)
+    bool verbose = false;
+};
+
+struct HttpRequest {
+    string method;
+    string path;
+    string body;
+    string client;
+    bool background = false;
+    bool keepAlive = true;
+};
+
+struct UpstreamReply {
+    long status = 502;
+    string contentType = "application/json";
+    string body = "{\"error\":\"upstream unreachable\"}";
+};
+
+// 排队中的一个上游请求；合并进来的请求共享同一个 Job
+struct Job {
+    string path;
+    string body;
+    string model;
+    string client;
+    int priority = 0; // 0 = interactive, 1 = background
+    string key;
+    Clock::time_point enqueued;
+    bool queued = true; // 还在 queues 里 (没被工作线程取走)，受 queueMutex 保护
+
+    mutex m;
+    condition_variable cv;
+    bool done = false;
+    UpstreamReply reply;
+};
+
+struct GatewayStats {
+    atomic<uint64_t> requests{0};
+    atomic<uint64_t> forwarded{0};
+    atomic<uint64_t> coalesced{0};
+    atomic<uint64_t> rejected{0};
+    atomic<uint64_t> failed{0};
+    atomic<uint64_t> modelSwitches{0};
+    atomic<uint64_t> warmPings{0};
+    atomic<uint64_t> waitMicros{0};
+    atomic<int> inFlight{0};
+    atomic<int> connections{0};
+    atomic<uint64_t> refusedConnections{0};
+    atomic<uint64_t> promoted{0};
+};
+
+static GatewayOptions options;
+static GatewayStats stats;
+
+// ==========================================
+// 调度
+// ==========================================
+
+static mutex queueMutex;
+static condition_variable queueCv;
+static map<string, deque<shared_ptr<Job>>> queues[2]; // 客户端 -> 该客户端排队中的请求
+static string lastClient[2];
+static size_t queuedCount = 0;
+static unordered_map<string, shared_ptr<Job>> pendingByKey; // 排队中 + 在途，用于合并
+static string residentModel; // 最近一次派发的模型，视为上游当前驻留的模型
+static size_t streak = 0;    // 连续派发 residentModel 的个数
+
+// 在一个优先级里选下一个客户端：从上次的客户端之后轮转；
+// 成批没满时优先挑队头是驻留模型的客户端
+static map<string, deque<shared_ptr<Job>>>::iterator pickClient(int p) {
+    auto& q = queues[p];
+    auto start = q.upper_bound(lastClient[p]);
+    if (start == q.end()) start = q.begin();
+    if (streak < options.batch && !residentModel.empty()) {
+        auto it = start;
+        do {
+            if (it->second.front()->model == residentModel) return it;
+            if (++it == q.end()) it = q.begin();
+        } while (it != start);
+    }
+    return start;
+}
+
+// 调用方持有 queueMutex 且 queuedCount > 0
+static shared_ptr<Job> popJob() {
+    int p = queues[0].empty() ? 1 : 0;
+    auto it = pickClient(p);
+    shared_ptr<Job> job = it->second.front();
+    it->second.pop_front();
+    lastClient[p] = it->first;
+    if (it->second.empty()) queues[p].erase(it);
+    queuedCount--;
+    job->queued = false;
+    if (job->model == residentModel) {
+        streak++;
+    } else {
+        if (!residentModel.empty()) stats.modelSwitches++;
+        residentModel = job->model;
+        streak = 1;
+    }
+    return job;
+}
+
+static size_t writeCallback(void* contents, size_t size, size_t nmemb, string* out) {
+    out->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+static UpstreamReply callUpstream(const string& method, const string& path, const string& body) {
+    UpstreamReply reply;
+    CURL* curl = curl_easy_init();
+    if (!curl) return reply;
+    string url = options.upstream + path;
+    string received;
+    curl_slist* headers = curl_slist_append(nullptr, "Content-Type: application/json");
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    if (method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+    }
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &received);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, options.timeout);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    CURLcode res = curl_easy_perform(curl);
+    if (res == CURLE_OK) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &reply.status);
+        char* type = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &type);
+        if (type) reply.contentType = type;
+        reply.body = move(received);
+    } else {
+        reply.body = "{\"error\":\"" + JsonUtil::escape(string("gateway: ") + curl_easy_strerror(res)) + "\"}";
+    }
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    return reply;
+}
+
+// 上游工作线程：个数就是全局并发上限
+static void upstreamWorker() {
+    while (true) {
+        shared_ptr<Job> job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCv.wait(lock, [] { return queuedCount > 0; });
+            job = popJob();
+        }
+        stats.waitMicros += chrono::duration_cast<chrono::microseconds>(Clock::now() - job->enqueued).count();
+        stats.inFlight++;
+        UpstreamReply reply = callUpstream("POST", job->path, job->body);
+        stats.inFlight--;
+        stats.forwarded++;
+        if (reply.status != 200) stats.failed++;
+        if (options.verbose) {
+            cerr << "[Gateway] " << job->client << " " << job->path << " model=" << job->model << " -> " << reply.status << endl;
+        }
+        {
+            // 先摘掉再交结果：之后到的相同请求重新排队
+            lock_guard<mutex> lock(queueMutex);
+            pendingByKey.erase(job->key);
+        }
+        {
+            lock_guard<mutex> lock(job->m);
+            job->reply = move(reply);
+            job->done = true;
+        }
+        job->cv.notify_all();
+    }
+}
+
+// 转发时补上 keep_alive，让模型在请求间隙也常驻
+static string withKeepAlive(string body) {
+    if (options.keepAlive.empty() || body.find("\"keep_alive\"") != string::npos) return body;
+    size_t brace = body.find('{');
+    if (brace == string::npos) return body;
+    body.insert(brace + 1, "\"keep_alive\":\"" + JsonUtil::escape(options.keepAlive) + "\",");
+    return body;
+}
+
+// 把还在后台队列里的 job 挪到交互队列 (调用方持有 queueMutex)
+static void promote(const shared_ptr<Job>& job) {
+    auto client = queues[1].find(job->client);
+    if (client == queues[1].end()) return;
+    auto& jobs = client->second;
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        if (*it != job) continue;
+        jobs.erase(it);
+        if (jobs.empty()) queues[1].erase(client);
+        job->priority = 0;
+        queues[0][job->client].push_back(job);
+        stats.promoted++;
+        return;
+    }
+}
+
+// 排队并等结果；排队已满返回 false
+static bool schedule(const HttpRequest& req, UpstreamReply& reply) {
+    shared_ptr<Job> job;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        string key = req.path + '\0' + req.body;
+        auto it = pendingByKey.find(key);
+        if (it != pendingByKey.end()) {
+            job = it->second;
+            stats.coalesced++;
+            // 有交互请求在等它，就不能再排在后台请求后面
+            if (!req.background && job->priority == 1 && job->queued) promote(job);
+        } else {
+            if (queuedCount >= options.queue) {
+                stats.rejected++;
+                return false;
+            }
+            job = make_shared<Job>();
+            job->path = req.path;
+            job->body = withKeepAlive(req.body);
+            JsonUtil::extractString(req.body, "model", job->model);
+            job->client = req.client;
+            job->priority = req.background ? 1 : 0;
+            job->key = move(key);
+            job->enqueued = Clock::now();
+            pendingByKey.emplace(job->key, job);
+            queues[job->priority][job->client].push_back(job);
+            queuedCount++;
+            queueCv.notify_one();
+        }
+    }
+    unique_lock<mutex> lock(job->m);
+    job->cv.wait(lock, [&] { return job->done; });
+    reply = job->reply;
+    return true;
+}
+
+// 启动时预加载 --warm 的模型，之后每 --warm-interval 秒续一次 keep_alive
+// 不带 prompt 的 /api/generate 只加载模型，不做推理
+static void warmLoop() {
+    while (true) {
+        for (const auto& model : options.warm) {
+            string body = "{\"model\":\"" + JsonUtil::escape(model) + "\",\"keep_alive\":\"" +
+                          JsonUtil::escape(options.keepAlive.empty() ? "30m" : options.keepAlive) + "\"}";
+            auto start = Clock::now();
+            UpstreamReply reply = callUpstream("POST", "/api/generate", body);
+            stats.warmPings++;
+            double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+            if (reply.status != 200) {
+                cerr << "[Gateway] 预热 " << model << " 失败 (" << reply.status << "): " << reply.body << endl;
+            } else if (options.verbose || stats.warmPings <= options.warm.size()) {
+                cerr << "[Gateway] 模型 " << model << " 已驻留 (" << static_cast<int>(ms) << " ms)" << endl;
+            }
+        }
+        this_thread::sleep_for(chrono::seconds(options.warmInterval));
+    }
+}
+
+// ==========================================
+// HTTP
+// ==========================================
+
+static bool sendAll(int fd, string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+static string lowerCopy(string s) {
+    for (char& c : s) c = tolower(static_cast<unsigned char>(c));
+    return s;
+}
+
+// 请求头和请求体的上限：prompt 再长也到不了这个量级，超出的多半是坏请求，不能让 buffer 无限增长
+static const size_t MAX_HEADER_BYTES = 64 * 1024;
+static const size_t MAX_BODY_BYTES = 16 * 1024 * 1024;
+
+enum class ReadResult { Ok, Closed, BadRequest, TooLarge };
+
+// buffer 里可能已经有上一个请求读多了的数据 (keep-alive)
+static ReadResult readRequest(int fd, string& buffer, HttpRequest& req) {
+    char chunk[8192];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == string::npos) {
+        if (buffer.size() > MAX_HEADER_BYTES) return ReadResult::TooLarge;
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return ReadResult::Closed;
+        buffer.append(chunk, n);
+    }
+    if (headerEnd > MAX_HEADER_BYTES) return ReadResult::TooLarge;
+
+    istringstream head(buffer.substr(0, headerEnd));
+    string requestLine;
+    getline(head, requestLine);
+    istringstream rl(requestLine);
+    string version;
+    rl >> req.method >> req.path >> version;
+    req.keepAlive = version != "HTTP/1.0";
+    req.client.clear();
+    req.background = false;
+
+    size_t contentLength = 0;
+    string header;
+    while (getline(head, header)) {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+        size_t colon = header.find(':');
+        if (colon == string::npos) continue;
+        string name = lowerCopy(header.substr(0, colon));
+        string value = header.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        if (name == "content-length") {
+            // 连接线程里不能抛异常 (会 terminate 掉整个网关)，非法值按坏请求处理
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.pop_back();
+            auto [end, ec] = from_chars(value.data(), value.data() + value.size(), contentLength);
+            if (ec != errc() || end != value.data() + value.size() || value.empty()) return ReadResult::BadRequest;
+            if (contentLength > MAX_BODY_BYTES) return ReadResult::TooLarge;
+        }
+        else if (name == "connection") req.keepAlive = lowerCopy(value) != "close";
+        else if (name == "x-synapse-client") req.client = value;
+        else if (name == "x-synapse-priority") req.background = lowerCopy(value) == "background";
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    while (buffer.size() < bodyStart + contentLength) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return ReadResult::Closed;
+        buffer.append(chunk, n);
+    }
+    req.body = buffer.substr(bodyStart, contentLength);
+    buffer.erase(0, bodyStart + contentLength);
+    return ReadResult::Ok;
+}
+
+static bool sendResponse(int fd, long status, const string& contentType, const string& body, bool keepAlive) {
+    const char* reason = status == 200 ? "OK" : status == 400 ? "Bad Request" : status == 404 ? "Not Found"
+                       : status == 413 ? "Payload Too Large" : status == 503 ? "Service Unavailable" : "Bad Gateway";
+    string head = "HTTP/1.1 " + to_string(status) + " " + reason + "\r\n"
+                  "Content-Type: " + contentType + "\r\n"
+                  "Content-Length: " + to_string(body.size()) + "\r\n"
+                  "Connection: " + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+    return sendAll(fd, head + body);
+}
+
+static string statsJson() {
+    size_t queued;
+    string resident;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        queued = queuedCount;
+        resident = residentModel;
+    }
+    uint64_t forwarded = stats.forwarded.load();
+    return "{\"requests\":" + to_string(stats.requests.load()) +
+           ",\"forwarded\":" + to_string(forwarded) +
+           ",\"coalesced\":" + to_string(stats.coalesced.load()) +
+           ",\"rejected\":" + to_string(stats.rejected.load()) +
+           ",\"failed\":" + to_string(stats.failed.load()) +
+           ",\"queued\":" + to_string(queued) +
+           ",\"in_flight\":" + to_string(stats.inFlight.load()) +
+           ",\"model_switches\":" + to_string(stats.modelSwitches.load()) +
+           ",\"warm_pings\":" + to_string(stats.warmPings.load()) +
+           ",\"promoted\":" + to_string(stats.promoted.load()) +
+           ",\"connections\":" + to_string(stats.connections.load()) +
+           ",\"refused_connections\":" + to_string(stats.refusedConnections.load()) +
+           ",\"avg_wait_ms\":" + to_string(forwarded ? stats.waitMicros.load() / 1000.0 / forwarded : 0.0) +
+           ",\"resident_model\":\"" + JsonUtil::escape(resident) + "\"}";
+}
+
+static void serveConnection(int fd, string peer) {
+    string buffer;
+    HttpRequest req;
+    while (true) {
+        ReadResult result = readRequest(fd, buffer, req);
+        if (result == ReadResult::BadRequest) {
+            sendResponse(fd, 400, "application/json", "{\"error\":\"invalid Content-Length\"}", false);
+            break;
+        }
+        if (result == ReadResult::TooLarge) {
+            sendResponse(fd, 413, "application/json", "{\"error\":\"request too large\"}", false);
+            break;
+        }
+        if (result != ReadResult::Ok) break;
+        if (req.client.empty()) req.client = peer;
+        bool ok;
+        if (req.method == "GET" && req.path == "/stats") {
+            ok = sendResponse(fd, 200, "application/json", statsJson(), req.keepAlive);
+        } else if (req.method == "POST" && (req.path == "/api/generate" || req.path == "/api/chat")) {
+            stats.requests++;
+            UpstreamReply reply;
+            if (schedule(req, reply)) {
+                ok = sendResponse(fd, reply.status, reply.contentType, reply.body, req.keepAlive);
+            } else {
+                ok = sendResponse(fd, 503, "application/json", "{\"error\":\"gateway queue full\"}", req.keepAlive);
+            }
+        } else {
+            UpstreamReply reply = callUpstream(req.method, req.path, req.body);
+            ok = sendResponse(fd, reply.status, reply.contentType, reply.body, req.keepAlive);
+        }
+        if (!ok || !req.keepAlive) break;
+    }
+    ::close(fd);
+    stats.connections--;
+}
+
+// ==========================================
+// main
+// ==========================================
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options]\n"
+         << "  --host ADDR            监听地址 (默认 127.0.0.1)\n"
+         << "  --port N               监听端口 (默认 11435)\n"
+         << "  --upstream URL         Ollama 地址 (默认 http://localhost:11434)\n"
+         << "  --parallel N           同时打到上游的请求数 (默认 1，对齐 OLLAMA_NUM_PARALLEL)\n"
+         << "  --batch N              同一模型连续派发的上限，之后让给别的模型 (默认 8)\n"
+         << "  --queue N              最大排队数，超出返回 503 (默认 512)\n"
+         << "  --max-connections N    最大连接数 (每个连接一个线程)，超出直接 503 并断开 (默认 256)\n"
+         << "  --keep-alive DUR       转发时补上的 keep_alive (默认 30m，空串表示不补)\n"
+         << "  --warm MODEL           启动时预加载并定期续期的模型，可重复\n"
+         << "  --warm-interval SEC    续期间隔 (默认 300)\n"
+         << "  --timeout SEC          单个上游请求超时 (默认 300)\n"
+         << "  --verbose              打印每个转发的请求" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto next = [&]() -> string { return i + 1 < argc ? argv[++i] : ""; };
+        try {
+            if (arg == "--host") options.host = next();
+            else if (arg == "--port") options.port = stoi(next());
+            else if (arg == "--upstream") options.upstream = next();
+            else if (arg == "--parallel") options.parallel = stoi(next());
+            else if (arg == "--batch") options.batch = stoul(next());
+            else if (arg == "--queue") options.queue = stoul(next());
+            else if (arg == "--max-connections") options.maxConnections = stoi(next());
+            else if (arg == "--keep-alive") options.keepAlive = next();
+            else if (arg == "--warm") options.warm.push_back(next());
+            else if (arg == "--warm-interval") options.warmInterval = stoi(next());
+            else if (arg == "--timeout") options.timeout = stol(next());
+            else if (arg == "--verbose") options.verbose = true;
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (...) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.parallel < 1 || options.batch < 1 || options.warmInterval < 1 || options.maxConnections < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    while (!options.upstream.empty() && options.upstream.back() == '/') options.upstream.pop_back();
+
+    signal(SIGPIPE, SIG_IGN);
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1) {
+        cerr << "[Error] 无效的地址: " << options.host << endl;
+        return 1;
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd, 256) < 0) {
+        cerr << "[Error] 无法监听 " << options.host << ":" << options.port << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    for (int i = 0; i < options.parallel; ++i) thread(upstreamWorker).detach();
+    if (!options.warm.empty()) thread(warmLoop).detach();
+
+    cerr << "[Gateway] 监听 http://" << options.host << ":" << options.port << " -> " << options.upstream
+         << " (parallel " << options.parallel << ", batch " << options.batch << ", queue " << options.queue
+         << ", keep_alive " << (options.keepAlive.empty() ? "-" : options.keepAlive) << ")" << endl;
+
+    while (true) {
+        sockaddr_in peerAddr{};
+        socklen_t peerLen = sizeof(peerAddr);
+        int fd = accept4(listenFd, reinterpret_cast<sockaddr*>(&peerAddr), &peerLen, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            cerr << "[Error] accept 失败: " << strerror(errno) << endl;
+            break;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        char ip[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &peerAddr.sin_addr, ip, sizeof(ip));
+        // 每个连接一个线程，大部分时间在等排队结果；真正的并发由上游工作线程数决定
+        // 线程数由 --max-connections 封顶，--queue 限制的只是排队的请求
+        if (stats.connections >= options.maxConnections) {
+            stats.refusedConnections++;
+            sendResponse(fd, 503, "application/json", "{\"error\":\"gateway connection limit\"}", false);
+            ::close(fd);
+            continue;
+        }
+        stats.connections++;
+        thread(serveConnection, fd, string(ip)).detach();
+    }
+    ::close(listenFd);
+    curl_global_cleanup();
+    return 0;
+}
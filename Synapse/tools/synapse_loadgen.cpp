@@ -0,0 +1,744 @@
+// synapse_loadgen: 端到端压测工具，取代 tools/stress_test.py
+//
+// stress_test.py 一次只驱动一个 pexpect 会话、每轮睡 10 秒、还要在线大模型来编指令；
+// 这里按 PERSONAS (developer / office / sysadmin) 用模板在本地生成口语化指令，
+// 以可配的并发打到 daemon (每条指令一个新连接 = 一个会话) 或 --batch 模式，
+// 自动回答追问，最后报告 sessions/s、各阶段 p50/p95/p99、完成所需轮数和后端调用次数。
+//
+// daemon 需要用 JSON 协议启动：./synapse --daemon --protocol json
+// 配合 synapse_mock_llm 可以完全离线：--mock http://127.0.0.1:11500 会在压测前后各取一次 /stats 做差
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <curl/curl.h>
+
+#include "JsonUtil.h"
+#include "SessionServer.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+using Clock = chrono::steady_clock;
+
+// ==========================================
+// 角色画像 (与 stress_test.py 的 PERSONAS 一致)
+// ==========================================
+
+struct Persona {
+    string name;
+    vector<string> topics;
+    vector<string> filenames;
+    vector<string> extensions;
+    vector<string> paths;
+};
+
+static const vector<Persona> PERSONAS = {
+    {"developer",
+     {"python脚本", "C++源码", "配置文件", "接口文档", "测试用例"},
+     {"main", "utils", "config", "test_api", "app", "schema"},
+     {".py", ".cpp", ".json", ".yaml", ".js"},
+     {"project", "src", "dev", "code", "workspace"}},
+    {"office",
+     {"会议记录", "周报", "待办事项", "简历", "通知"},
+     {"2026会议记录", "张三简历", "1月周报", "todo", "notice"},
+     {".txt", ".docx", ".md", ".xlsx"},
+     {"Desktop", "桌面", "Documents", "文档"}},
+    {"sysadmin",
+     {"系统日志", "数据库备份", "错误报告", "临时文件"},
+     {"syslog", "db_backup", "error", "temp_check", "auth"},
+     {".log", ".bak", ".tar.gz", ".sh"},
+     {"/var/log", "/tmp", "/etc/conf", "backup"}},
+};
+
+struct Options {
+    string target = "daemon";
+    string socketPath = SessionServer::defaultSocketPath();
+    string synapsePath = "./synapse";
+    size_t concurrency = 4;
+    size_t sessions = 100;
+    uint64_t seed = 1;
+    double deleteRatio = 0.2;
+    string pathRoot = "/tmp/synapse_loadgen";
+    vector<size_t> personas;
+    string mockUrl;
+    double timeoutSec = 120;
+    int maxTurns = 12;
+    bool json = false;
+    bool verbose = false;
+};
+
+static Options options;
+
+// 一条生成好的指令，以及回答追问要用的上下文
+struct Command {
+    size_t index = 0;
+    string persona;
+    bool isDelete = false;
+    string text;
+    vector<string> names; // 追问文件名时依次给出
+    string ext;
+    string dir;
+    vector<string> answers; // batch 模式预置的回答 (假设模型把指令里给出的要素都提取对了)
+};
+
+struct TimedEvent {
+    string type;
+    string text;
+    double ms = 0; // 相对发出指令的时间
+};
+
+struct SessionResult {
+    bool completed = false;  // 收到了 done / batch 结果
+    bool understood = false;
+    int turns = 0;           // 用户一共说了几句 (指令本身 + 回答)
+    double totalMs = 0;
+    vector<TimedEvent> events;
+    string error;
+};
+
+// ==========================================
+// 指令生成
+// ==========================================
+
+// persona 的路径落到 pathRoot 下，避免在真实 Home 里乱建文件
+static string personaDir(const string& path) {
+    string rel = path;
+    while (!rel.empty() && rel[0] == '/') rel.erase(0, 1);
+    return options.pathRoot + "/" + rel;
+}
+
+template <typename T>
+static const T& pick(mt19937_64& rng, const vector<T>& items) {
+    return items[uniform_int_distribution<size_t>(0, items.size() - 1)(rng)];
+}
+
+static Command generateCommand(size_t index) {
+    mt19937_64 rng(options.seed * 1000003 + index);
+    const Persona& p = PERSONAS[options.personas[uniform_int_distribution<size_t>(0, options.personas.size() - 1)(rng)]];
+
+    Command cmd;
+    cmd.index = index;
+    cmd.persona = p.name;
+    cmd.ext = pick(rng, p.extensions);
+    cmd.dir = personaDir(pick(rng, p.paths));
+    string topic = pick(rng, p.topics);
+    // 带上序号，保证每个会话的文件名不撞车
+    string name = pick(rng, p.filenames) + "_" + to_string(index);
+    cmd.names = {name};
+
+    if (uniform_real_distribution<double>(0, 1)(rng) < options.deleteRatio) {
+        // 删除：目标文件由压测工具预先建好，用绝对路径，只需要确认一次
+        cmd.isDelete = true;
+        string target = options.pathRoot + "/delete_targets/" + name + cmd.ext;
+        ofstream(target) << "loadgen\n";
+        static const vector<string> verbs = {"删除 ", "帮我删了 ", "把这个文件删掉 ", "清理掉 "};
+        cmd.text = pick(rng, verbs) + target;
+        cmd.answers = {"y"};
+        return cmd;
+    }
+
+    switch (uniform_int_distribution<int>(0, 4)(rng)) {
+        case 0: // 什么都没说
+            cmd.text = "帮我弄个" + topic;
+            cmd.answers = {name, cmd.ext, cmd.dir};
+            break;
+        case 1: // 全说了
+            cmd.text = "在 " + cmd.dir + " 整一个 " + name + cmd.ext;
+            break;
+        case 2: // 只有名字
+            cmd.text = "新建一个 " + name;
+            cmd.answers = {cmd.ext, cmd.dir};
+            break;
+        case 3: // 只有位置
+            cmd.text = "帮我在 " + cmd.dir + " 建个" + topic;
+            cmd.answers = {name, cmd.ext};
+            break;
+        default: { // 多个文件
+            string second = name + "_b";
+            cmd.names = {name, second};
+            cmd.text = "搞两个" + topic + "文件";
+            cmd.answers = {name + "," + second, cmd.ext, cmd.ext, cmd.dir};
+            break;
+        }
+    }
+    return cmd;
+}
+
+// daemon 模式下按提问内容作答 (和 stress_test.py 的匹配规则一致)
+// 返回 false 表示这个事件不需要回答 (删除候选列表后面还跟着一条 "请输入序号" 的提问)
+class Answerer {
+public:
+    explicit Answerer(const Command& cmd) : cmd(cmd) {}
+
+    static bool expectsAnswer(const string& type, const string& text) {
+        if (type == "prompt") return true;
+        if (type == "candidates") return text.find("删除哪一个") == string::npos;
+        // 路径搜不到、选项无效时以错误提示直接等下一行输入
+        return type == "error" && (text.find("请重新输入") != string::npos || text.find("选项无效") != string::npos);
+    }
+
+    // 空行会被追问流程忽略，所以每个提问都要给出非空回答
+    string answer(const string& type, const string& text) {
+        if (cmd.isDelete) {
+            if (text.find("(y/n)") != string::npos) return "y";
+            return "1";
+        }
+        if (text.find("后缀") != string::npos) return cmd.ext;
+        if (type == "candidates" || text.find("请选择") != string::npos ||
+            text.find("序号") != string::npos || text.find("选项无效") != string::npos) return "1";
+        if (text.find("(y/n)") != string::npos) return "y";
+        if (text.find("名字") != string::npos || text.find("文件名") != string::npos ||
+            text.find("还缺") != string::npos || text.find("还需") != string::npos) {
+            if (nextName < cmd.names.size()) return cmd.names[nextName++];
+            return "自动";
+        }
+        return cmd.dir; // "放在哪里" / "请重新输入" 路径
+    }
+
+private:
+    const Command& cmd;
+    size_t nextName = 0;
+};
+
+// ==========================================
+// 行读取 / 事件解析
+// ==========================================
+
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd(fd) {}
+
+    // 超时或对端关闭返回 false
+    bool readLine(string& line, Clock::time_point deadline) {
+        while (true) {
+            size_t nl = buffer.find('\n');
+            if (nl != string::npos) {
+                line = buffer.substr(0, nl);
+                buffer.erase(0, nl + 1);
+                return true;
+            }
+            int waitMs = chrono::duration_cast<chrono::milliseconds>(deadline - Clock::now()).count();
+            if (waitMs <= 0) return false;
+            pollfd pfd{fd, POLLIN, 0};
+            int r = poll(&pfd, 1, waitMs);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            char chunk[8192];
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buffer.append(chunk, n);
+        }
+    }
+
+private:
+    int fd;
+    string buffer;
+};
+
+static bool parseEvent(const string& line, string& type, string& text) {
+    if (line.empty() || line[0] != '{') return false;
+    return JsonUtil::extractString(line, "type", type) && JsonUtil::extractString(line, "text", text);
+}
+
+static bool writeAll(int fd, const string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        off += n;
+    }
+    return true;
+}
+
+// ==========================================
+// daemon 目标
+// ==========================================
+
+static SessionResult runDaemonSession(const Command& cmd) {
+    SessionResult result;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        result.error = string("connect: ") + strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return result;
+    }
+
+    LineReader reader(fd);
+    auto deadline = Clock::now() + chrono::milliseconds(static_cast<long long>(options.timeoutSec * 1000));
+    string line, type, text;
+
+    // 等会话就绪
+    bool ready = false;
+    while (!ready && reader.readLine(line, deadline)) {
+        if (!parseEvent(line, type, text)) {
+            result.error = "daemon 没有使用 JSON 协议 (请用 --daemon --protocol json 启动)";
+            ::close(fd);
+            return result;
+        }
+        ready = text.find("Ready.") != string::npos;
+    }
+    if (!ready) {
+        result.error = "等待 Ready 超时";
+        ::close(fd);
+        return result;
+    }
+
+    Answerer answerer(cmd);
+    auto start = Clock::now();
+    writeAll(fd, cmd.text + "\n");
+    result.turns = 1;
+
+    while (reader.readLine(line, deadline)) {
+        if (!parseEvent(line, type, text)) continue;
+        double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+        if (type == "done") {
+            result.completed = true;
+            result.understood = text == "understood";
+            result.totalMs = ms;
+            break;
+        }
+        result.events.push_back({type, text, ms});
+        if (Answerer::expectsAnswer(type, text)) {
+            if (result.turns > options.maxTurns) {
+                result.error = "追问轮数超过上限";
+                break;
+            }
+            writeAll(fd, answerer.answer(type, text) + "\n");
+            result.turns++;
+        }
+    }
+    if (!result.completed && result.error.empty()) result.error = "会话超时或被断开";
+
+    writeAll(fd, "exit\n");
+    ::close(fd);
+    return result;
+}
+
+static void runDaemon(vector<Command>& commands, vector<SessionResult>& results) {
+    atomic<size_t> next{0};
+    vector<thread> users;
+    for (size_t u = 0; u < options.concurrency; ++u) {
+        users.emplace_back([&] {
+            size_t i;
+            while ((i = next.fetch_add(1)) < commands.size()) {
+                results[i] = runDaemonSession(commands[i]);
+            }
+        });
+    }
+    for (auto& t : users) t.join();
+}
+
+// ==========================================
+// batch 目标
+// ==========================================
+
+static void runBatch(vector<Command>& commands, vector<SessionResult>& results) {
+    int toChild[2], fromChild[2];
+    if (pipe2(toChild, O_CLOEXEC) < 0 || pipe2(fromChild, O_CLOEXEC) < 0) {
+        cerr << "[Error] pipe 失败: " << strerror(errno) << endl;
+        return;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        string jobs = to_string(options.concurrency);
+        execl(options.synapsePath.c_str(), options.synapsePath.c_str(), "--batch", "-", "--jobs", jobs.c_str(), (char*)nullptr);
+        cerr << "[Error] 无法启动 " << options.synapsePath << ": " << strerror(errno) << endl;
+        _exit(127);
+    }
+    ::close(toChild[0]);
+    ::close(fromChild[1]);
+
+    // 指令在单独的线程里写，避免子进程输出管道写满时两边互相等
+    thread writer([&] {
+        for (const auto& cmd : commands) {
+            string line = "{\"id\":\"" + to_string(cmd.index) + "\",\"command\":\"" + JsonUtil::escape(cmd.text) + "\",\"answers\":[";
+            for (size_t i = 0; i < cmd.answers.size(); ++i) {
+                if (i > 0) line += ",";
+                line += "\"" + JsonUtil::escape(cmd.answers[i]) + "\"";
+            }
+            line += "]}\n";
+            if (!writeAll(toChild[1], line)) break;
+        }
+        ::close(toChild[1]);
+    });
+
+    LineReader reader(fromChild[0]);
+    auto deadline = Clock::now() + chrono::milliseconds(static_cast<long long>(options.timeoutSec * 1000 * commands.size()));
+    string line;
+    while (reader.readLine(line, deadline)) {
+        string id;
+        if (!JsonUtil::extractString(line, "id", id)) continue;
+        size_t index = stoul(id);
+        if (index >= results.size()) continue;
+        SessionResult& r = results[index];
+        r.completed = true;
+        r.understood = line.find("\"understood\":true") != string::npos;
+
+        size_t pos = line.find("\"answers_used\":");
+        if (pos != string::npos) r.turns = 1 + stoi(line.substr(pos + 15));
+        pos = line.find("\"elapsed_ms\":");
+        if (pos != string::npos) r.totalMs = stod(line.substr(pos + 13));
+        if (line.find("\"starved\":true") != string::npos) r.error = "预置回答不够用 (starved)";
+
+        // events 与 event_ms 一一对应
+        vector<double> eventMs;
+        pos = line.find("\"event_ms\":[");
+        if (pos != string::npos) {
+            istringstream ms(line.substr(pos + 12, line.find(']', pos) - pos - 12));
+            string item;
+            while (getline(ms, item, ',')) eventMs.push_back(stod(item));
+        }
+        size_t eventsPos = line.find("\"events\":[");
+        size_t cursor = eventsPos == string::npos ? line.size() : eventsPos + 10;
+        for (size_t e = 0; ; ++e) {
+            string_view obj = JsonUtil::findObject(line, cursor);
+            if (obj.empty() || (pos != string::npos && static_cast<size_t>(obj.data() - line.data()) > pos)) break;
+            TimedEvent ev;
+            JsonUtil::extractString(obj, "type", ev.type);
+            JsonUtil::extractString(obj, "text", ev.text);
+            ev.ms = e < eventMs.size() ? eventMs[e] : r.totalMs;
+            r.events.push_back(ev);
+            cursor = (obj.data() - line.data()) + obj.size();
+        }
+    }
+    writer.join();
+    ::close(fromChild[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+// ==========================================
+// 统计
+// ==========================================
+
+static size_t findEvent(const vector<TimedEvent>& events, size_t from, const vector<string>& needles) {
+    for (size_t i = from; i < events.size(); ++i) {
+        for (const auto& n : needles) {
+            if (events[i].text.find(n) != string::npos) return i;
+        }
+    }
+    return events.size();
+}
+
+// 从事件流切出各阶段耗时 (ms)；阶段没出现就不计
+static map<string, vector<double>> stageTimes(const SessionResult& r) {
+    map<string, vector<double>> stages;
+    const auto& ev = r.events;
+    auto endOf = [&](size_t i) { return i + 1 < ev.size() ? ev[i + 1].ms : r.totalMs; };
+
+    size_t routed = findEvent(ev, 0, {"最终识别为", "未识别为操作指令"});
+    if (routed < ev.size()) stages["route"].push_back(ev[routed].ms);
+
+    double search = 0;
+    bool searched = false;
+    for (size_t i = 0; i < ev.size(); ++i) {
+        if (ev[i].text.find("正在全盘") != string::npos || ev[i].text.find("正在定位文件") != string::npos) {
+            search += endOf(i) - ev[i].ms;
+            searched = true;
+        }
+    }
+    if (searched) stages["search"].push_back(search);
+
+    if (routed < ev.size()) {
+        for (size_t i = routed; i < ev.size(); ++i) {
+            if (ev[i].type == "result") {
+                stages["execute"].push_back(ev[i].ms - ev[routed].ms);
+                break;
+            }
+        }
+    }
+
+    size_t audit = findEvent(ev, 0, {"正在请求 DeepSeek 审计"});
+    if (audit < ev.size()) {
+        size_t done = findEvent(ev, audit, {"审计完成"});
+        stages["audit"].push_back((done < ev.size() ? ev[done].ms : r.totalMs) - ev[audit].ms);
+    }
+    if (r.completed) stages["total"].push_back(r.totalMs);
+    return stages;
+}
+
+static double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0;
+    sort(values.begin(), values.end());
+    size_t idx = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[min(idx, values.size() - 1)];
+}
+
+static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    static_cast<string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+static map<string, long long> fetchMockStats() {
+    map<string, long long> stats;
+    if (options.mockUrl.empty()) return stats;
+    string body;
+    CURL* curl = curl_easy_init();
+    if (!curl) return stats;
+    string url = options.mockUrl + "/stats";
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    if (res != CURLE_OK) return stats;
+
+    // {"requests":1,"generate":2,...} 全是整数
+    size_t pos = 0;
+    while ((pos = body.find('"', pos)) != string::npos) {
+        size_t end = body.find('"', pos + 1);
+        if (end == string::npos) break;
+        string key = body.substr(pos + 1, end - pos - 1);
+        size_t colon = body.find(':', end);
+        if (colon == string::npos) break;
+        stats[key] = atoll(body.c_str() + colon + 1);
+        pos = body.find_first_of(",}", colon);
+    }
+    return stats;
+}
+
+static void report(const vector<Command>& commands, const vector<SessionResult>& results, double wallSec,
+                   const map<string, long long>& mockBefore, const map<string, long long>& mockAfter) {
+    size_t completed = 0, understood = 0, failed = 0;
+    map<string, vector<double>> stages;
+    map<int, size_t> turns;
+    map<string, size_t> errors;
+    map<string, size_t> calls;
+    double turnSum = 0;
+
+    static const vector<pair<string, string>> callMarkers = {
+        {"local_router", "Local Brain 正在思考意图"},
+        {"grok_arbitration", "呼叫 Grok"},
+        {"deepseek", "[DeepSeek] Thinking"},
+        {"classifier_bypass", "本地分类器判定"},
+        {"correction_memory_hit", "命中纠错记忆"},
+    };
+
+    for (const auto& r : results) {
+        if (r.completed) completed++;
+        if (r.understood) understood++;
+        if (!r.error.empty()) {
+            failed++;
+            errors[r.error]++;
+        }
+        if (r.completed) {
+            turns[r.turns]++;
+            turnSum += r.turns;
+        }
+        for (auto& [name, values] : stageTimes(r)) {
+            stages[name].insert(stages[name].end(), values.begin(), values.end());
+        }
+        for (const auto& ev : r.events) {
+            for (const auto& [name, marker] : callMarkers) {
+                if (ev.text.find(marker) != string::npos) calls[name]++;
+            }
+        }
+    }
+    double rate = wallSec > 0 ? completed / wallSec : 0;
+    static const vector<string> stageOrder = {"route", "search", "execute", "audit", "total"};
+
+    if (options.json) {
+        ostringstream out;
+        out << fixed << setprecision(2);
+        out << "{\"target\":\"" << options.target << "\",\"concurrency\":" << options.concurrency
+            << ",\"sessions\":" << commands.size() << ",\"completed\":" << completed
+            << ",\"understood\":" << understood << ",\"failed\":" << failed
+            << ",\"wall_s\":" << wallSec << ",\"sessions_per_s\":" << rate << ",\"stages\":{";
+        bool first = true;
+        for (const auto& name : stageOrder) {
+            auto it = stages.find(name);
+            if (it == stages.end()) continue;
+            out << (first ? "" : ",") << "\"" << name << "\":{\"count\":" << it->second.size()
+                << ",\"p50\":" << percentile(it->second, 50) << ",\"p95\":" << percentile(it->second, 95)
+                << ",\"p99\":" << percentile(it->second, 99) << "}";
+            first = false;
+        }
+        out << "},\"turns\":{\"avg\":" << (completed ? turnSum / completed : 0) << ",\"histogram\":{";
+        first = true;
+        for (const auto& [t, n] : turns) {
+            out << (first ? "" : ",") << "\"" << t << "\":" << n;
+            first = false;
+        }
+        out << "}},\"backend_calls\":{";
+        first = true;
+        for (const auto& [name, marker] : callMarkers) {
+            out << (first ? "" : ",") << "\"" << name << "\":" << calls[name];
+            first = false;
+        }
+        out << "}";
+        if (!mockAfter.empty()) {
+            out << ",\"mock_stats\":{";
+            first = true;
+            for (const auto& [key, value] : mockAfter) {
+                auto before = mockBefore.find(key);
+                out << (first ? "" : ",") << "\"" << key << "\":" << value - (before == mockBefore.end() ? 0 : before->second);
+                first = false;
+            }
+            out << "}";
+        }
+        out << "}";
+        cout << out.str() << endl;
+        return;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "================ Synapse 压测报告 ================" << endl;
+    cout << "目标: " << options.target << "  并发: " << options.concurrency << "  会话: " << commands.size()
+         << "  (完成 " << completed << ", 被理解 " << understood << ", 失败 " << failed << ")" << endl;
+    cout << "总耗时: " << setprecision(2) << wallSec << " s  吞吐: " << rate << " sessions/s" << setprecision(1) << endl;
+    cout << endl << left << setw(10) << "阶段(ms)" << right << setw(8) << "count" << setw(10) << "p50"
+         << setw(10) << "p95" << setw(10) << "p99" << endl;
+    for (const auto& name : stageOrder) {
+        auto it = stages.find(name);
+        if (it == stages.end()) continue;
+        cout << left << setw(10) << name << right << setw(8) << it->second.size()
+             << setw(10) << percentile(it->second, 50) << setw(10) << percentile(it->second, 95)
+             << setw(10) << percentile(it->second, 99) << endl;
+    }
+    cout << endl << "完成所需轮数: 平均 " << setprecision(2) << (completed ? turnSum / completed : 0) << "  分布";
+    for (const auto& [t, n] : turns) cout << "  " << t << "轮:" << n;
+    cout << endl << "后端调用 (按事件统计):";
+    for (const auto& [name, marker] : callMarkers) cout << "  " << name << "=" << calls[name];
+    cout << endl;
+    if (!mockAfter.empty()) {
+        cout << "后端调用 (mock /stats 差值):";
+        for (const auto& [key, value] : mockAfter) {
+            auto before = mockBefore.find(key);
+            cout << "  " << key << "=" << value - (before == mockBefore.end() ? 0 : before->second);
+        }
+        cout << endl;
+    }
+    for (const auto& [error, n] : errors) cout << "失败原因: " << error << " x" << n << endl;
+}
+
+// ==========================================
+// main
+// ==========================================
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options]\n"
+         << "  --target daemon|batch   压测对象 (默认 daemon，需 --daemon --protocol json)\n"
+         << "  --socket PATH           daemon socket (默认 " << SessionServer::defaultSocketPath() << ")\n"
+         << "  --synapse PATH          batch 模式下的 synapse 可执行文件 (默认 ./synapse)\n"
+         << "  --concurrency N         并发会话数 (batch 模式即 --jobs，默认 4)\n"
+         << "  --sessions N            总会话数 (默认 100)\n"
+         << "  --personas a,b          角色：developer,office,sysadmin (默认全部)\n"
+         << "  --delete-ratio P        删除指令占比 (默认 0.2)\n"
+         << "  --path-root DIR         生成文件的根目录 (默认 /tmp/synapse_loadgen)\n"
+         << "  --seed N                随机种子 (同样的种子生成同样的指令)\n"
+         << "  --mock URL              synapse_mock_llm 地址，报告其 /stats 差值\n"
+         << "  --timeout SEC           单个会话超时 (默认 120)\n"
+         << "  --json                  以 JSON 输出报告\n"
+         << "  --verbose               把失败会话的指令和事件流打到 stderr" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto next = [&]() -> string { return i + 1 < argc ? argv[++i] : ""; };
+        try {
+            if (arg == "--target") options.target = next();
+            else if (arg == "--socket") options.socketPath = next();
+            else if (arg == "--synapse") options.synapsePath = next();
+            else if (arg == "--concurrency") options.concurrency = stoul(next());
+            else if (arg == "--sessions") options.sessions = stoul(next());
+            else if (arg == "--delete-ratio") options.deleteRatio = stod(next());
+            else if (arg == "--path-root") options.pathRoot = next();
+            else if (arg == "--seed") options.seed = stoull(next());
+            else if (arg == "--mock") options.mockUrl = next();
+            else if (arg == "--timeout") options.timeoutSec = stod(next());
+            else if (arg == "--json") options.json = true;
+            else if (arg == "--verbose") options.verbose = true;
+            else if (arg == "--personas") {
+                stringstream ss(next());
+                string name;
+                while (getline(ss, name, ',')) {
+                    auto it = find_if(PERSONAS.begin(), PERSONAS.end(), [&](const Persona& p) { return p.name == name; });
+                    if (it == PERSONAS.end()) throw invalid_argument(name);
+                    options.personas.push_back(it - PERSONAS.begin());
+                }
+            }
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (...) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if ((options.target != "daemon" && options.target != "batch") || options.concurrency == 0 || options.sessions == 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (options.personas.empty()) {
+        for (size_t i = 0; i < PERSONAS.size(); ++i) options.personas.push_back(i);
+    }
+    while (!options.mockUrl.empty() && options.mockUrl.back() == '/') options.mockUrl.pop_back();
+
+    signal(SIGPIPE, SIG_IGN);
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // 准备目录和指令
+    error_code ec;
+    fs::create_directories(options.pathRoot + "/delete_targets", ec);
+    for (const auto& p : PERSONAS) {
+        for (const auto& path : p.paths) fs::create_directories(personaDir(path), ec);
+    }
+    vector<Command> commands;
+    commands.reserve(options.sessions);
+    for (size_t i = 0; i < options.sessions; ++i) commands.push_back(generateCommand(i));
+    vector<SessionResult> results(commands.size());
+
+    auto mockBefore = fetchMockStats();
+    auto start = Clock::now();
+    if (options.target == "daemon") runDaemon(commands, results);
+    else runBatch(commands, results);
+    double wallSec = chrono::duration<double>(Clock::now() - start).count();
+    auto mockAfter = fetchMockStats();
+
+    if (options.verbose) {
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (results[i].error.empty()) continue;
+            cerr << "---- #" << i << " [" << commands[i].persona << "] " << commands[i].text << " => " << results[i].error << endl;
+            for (const auto& ev : results[i].events) {
+                cerr << fixed << setprecision(1) << setw(9) << ev.ms << " ms  " << ev.type << ": " << ev.text << endl;
+            }
+        }
+    }
+    report(commands, results, wallSec, mockBefore, mockAfter);
+    curl_global_cleanup();
+
+    size_t completed = count_if(results.begin(), results.end(), [](const SessionResult& r) { return r.completed; });
+    return completed == results.size() ? 0 : 2;
+}
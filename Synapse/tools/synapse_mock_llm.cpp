@@ -0,0 +1,631 @@
+// synapse_mock_llm: 本地大模型替身，给离线压测 / 基准测试用
+//
+// 协议：
+//   POST /api/generate                      Ollama (stream true/false)
+//   POST /chat/completions                  OpenAI 风格 (DeepSeek)，stream 时走 SSE
+//   POST /v1/chat/completions               同上 (灵芽)
+//   GET  /api/tags                          Ollama 模型列表
+//   GET  /stats                             请求计数 (压测前后各取一次做差)
+//
+// 回答：先匹配 --rules 文件，没命中再走内置规则 (按项目里的 prompt 认出路由 / 创建提取 / 删除提取 / 审计)
+// 延迟：首 token 前等 latency ± jitter (uniform / normal / exp 分布)，之后按 --tokens-per-sec 逐 token 吐
+// 故障：--error-rate 返回 500，--throttle-rate 返回 429，--drop-rate 直接断开连接
+//
+// 让 Synapse 指向它：SYNAPSE_MOCK_LLM=http://127.0.0.1:11500 ./synapse
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <ctime>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "JsonUtil.h"
+
+using namespace std;
+
+struct MockOptions {
+    string host = "127.0.0.1";
+    int port = 11500;
+    double latencyMs = 0;
+    double jitterMs = 0;
+    string distribution = "uniform";
+    double tokensPerSec = 0; // 0 = 不限速
+    double errorRate = 0;
+    double throttleRate = 0;
+    double dropRate = 0;
+    uint64_t seed = 42;
+    string rulesFile;
+    bool verbose = false;
+};
+
+struct Rule {
+    string pattern;
+    string response;
+};
+
+struct MockStats {
+    atomic<uint64_t> requests{0};
+    atomic<uint64_t> generate{0};
+    atomic<uint64_t> chat{0};
+    atomic<uint64_t> streamed{0};
+    atomic<uint64_t> errors{0};
+    atomic<uint64_t> throttled{0};
+    atomic<uint64_t> dropped{0};
+    atomic<uint64_t> tokens{0};
+};
+
+static MockOptions options;
+static vector<Rule> rules;
+static MockStats stats;
+static atomic<uint64_t> requestSeq{0};
+
+// ==========================================
+// 回答生成
+// ==========================================
+
+static string between(const string& text, const string& open, const string& close, bool last = true) {
+    size_t start = last ? text.rfind(open) : text.find(open);
+    if (start == string::npos) return "";
+    start += open.size();
+    size_t end = text.find(close, start);
+    if (end == string::npos) end = text.size();
+    return text.substr(start, end - start);
+}
+
+static bool containsAny(const string& text, const vector<string>& words) {
+    for (const auto& w : words) {
+        if (text.find(w) != string::npos) return true;
+    }
+    return false;
+}
+
+static string classify(const string& text) {
+    if (containsAny(text, {"删", "移除", "清理", "清掉", "delete", "remove", "rm "})) return "DELETE";
+    if (containsAny(text, {"建", "搞", "弄", "整", "生成", "create", "make", "new ", "touch"})) return "CREATE";
+    return "OTHER";
+}
+
+static bool isPathChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.' || c == '/' || c == '~';
+}
+
+// 文本里的 ASCII 片段：以 / 开头的是路径，带后缀的是文件名
+static void scanTokens(const string& text, vector<string>& files, vector<string>& paths) {
+    size_t i = 0;
+    while (i < text.size()) {
+        if (!isPathChar(text[i])) { i++; continue; }
+        size_t start = i;
+        while (i < text.size() && isPathChar(text[i])) i++;
+        string token = text.substr(start, i - start);
+        if (token[0] == '/' || token[0] == '~') {
+            paths.push_back(token);
+            continue;
+        }
+        size_t dot = token.find('.');
+        if (dot != string::npos && dot > 0 && dot + 1 < token.size()) files.push_back(token);
+    }
+}
+
+static int extractQuantity(const string& text) {
+    static const map<string, int> numerals = {
+        {"一", 1}, {"两", 2}, {"二", 2}, {"三", 3}, {"四", 4}, {"五", 5},
+        {"六", 6}, {"七", 7}, {"八", 8}, {"九", 9}, {"十", 10}
+    };
+    for (const string unit : {"个", "份"}) {
+        size_t pos = text.find(unit);
+        if (pos == string::npos) continue;
+        size_t digitsEnd = pos;
+        while (digitsEnd > 0 && text[digitsEnd - 1] == ' ') digitsEnd--;
+        size_t digitsStart = digitsEnd;
+        while (digitsStart > 0 && isdigit(static_cast<unsigned char>(text[digitsStart - 1]))) digitsStart--;
+        if (digitsStart < digitsEnd) return stoi(text.substr(digitsStart, digitsEnd - digitsStart));
+        if (digitsEnd >= 3) {
+            auto it = numerals.find(text.substr(digitsEnd - 3, 3));
+            if (it != numerals.end()) return it->second;
+        }
+    }
+    return 0;
+}
+
+// FileCreator 的 "Names|Quantity|Path"
+static string extractCreate(const string& text) {
+    vector<string> files, paths;
+    scanTokens(text, files, paths);
+    int quantity = extractQuantity(text);
+    string names = files.empty() ? "NULL" : files[0];
+    for (size_t i = 1; i < files.size(); ++i) names += "," + files[i];
+    if (!files.empty() && quantity < (int)files.size()) quantity = files.size();
+    string path = !paths.empty() ? paths[0] : (text.find("桌面") != string::npos ? "桌面" : "NULL");
+    return names + "|" + to_string(quantity) + "|" + path;
+}
+
+// FileDeleter 的 "a.txt|/tmp/b.log"
+static string extractDelete(const string& text) {
+    vector<string> files, paths;
+    scanTokens(text, files, paths);
+    paths.insert(paths.end(), files.begin(), files.end());
+    if (paths.empty()) return "NULL";
+    string out = paths[0];
+    for (size_t i = 1; i < paths.size(); ++i) out += "|" + paths[i];
+    return out;
+}
+
+static string respond(const string& prompt) {
+    // 认出项目里的几种 prompt，取出其中的用户原话
+    string userText;
+    enum { Router, Create, Delete, Audit, Shell, Unknown } kind = Unknown;
+    if (prompt.find("审计") != string::npos) {
+        // 审计 prompt 里嵌着整段交互日志，必须最先判断
+        kind = Audit;
+    } else if (prompt.find("Task: Intent Classification") != string::npos) {
+        kind = Router;
+        // exec_router.txt 里 {{USER_INPUT}} 出现两次只替换了第一次，从 "Input:" 取
+        userText = between(prompt, "Input: ", "\n", false);
+    } else if (prompt.find("你是一个意图分类器") != string::npos) {
+        kind = Router;
+        userText = between(prompt, "用户输入：\"", "\"。", false);
+    } else if (prompt.find("Names|Quantity|Path") != string::npos) {
+        kind = Create;
+        userText = between(prompt, "Input: ", "\n");
+    } else if (prompt.find("Task: Extract target files.") != string::npos) {
+        kind = Delete;
+        userText = between(prompt, "Input: \"", "\"\n", false);
+    } else if (prompt.find("Linux 专家") != string::npos) {
+        kind = Shell;
+        userText = between(prompt, "用户需求：", "\n", false);
+    }
+
+    const string& subject = userText.empty() ? prompt : userText;
+    for (const auto& rule : rules) {
+        if (subject.find(rule.pattern) != string::npos) return rule.response;
+    }
+
+    switch (kind) {
+        case Router: return classify(userText);
+        case Create: return extractCreate(userText);
+        case Delete: return extractDelete(userText);
+        case Audit:  return "【评分】100\n【审计结论】mock 审计：流程正常\n【是否入库】否";
+        case Shell:  return "ls -la";
+        default:     return "OTHER";
+    }
+}
+
+// 粗略的 token 切分：连续 ASCII 字母数字算一个，其余每个 UTF-8 字符算一个
+static vector<string> tokenize(const string& text) {
+    vector<string> tokens;
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = text[i];
+        size_t len = 1;
+        if (isalnum(c)) {
+            while (i + len < text.size() && isalnum(static_cast<unsigned char>(text[i + len]))) len++;
+        } else if (c >= 0xF0) len = 4;
+        else if (c >= 0xE0) len = 3;
+        else if (c >= 0xC0) len = 2;
+        len = min(len, text.size() - i);
+        tokens.push_back(text.substr(i, len));
+        i += len;
+    }
+    return tokens;
+}
+
+// ==========================================
+// 延迟与故障注入
+// ==========================================
+
+struct Fault {
+    enum Kind { None, Error, Throttle, Drop } kind = None;
+    double firstTokenDelayMs = 0;
+};
+
+// 每个请求按序号派生随机数，同样的请求顺序得到同样的延迟和故障
+static Fault planRequest() {
+    mt19937_64 rng(options.seed * 1000003 + requestSeq.fetch_add(1));
+    uniform_real_distribution<double> unit(0.0, 1.0);
+
+    Fault fault;
+    double roll = unit(rng);
+    if (roll < options.dropRate) fault.kind = Fault::Drop;
+    else if (roll < options.dropRate + options.errorRate) fault.kind = Fault::Error;
+    else if (roll < options.dropRate + options.errorRate + options.throttleRate) fault.kind = Fault::Throttle;
+
+    double jitter = 0;
+    if (options.jitterMs > 0) {
+        if (options.distribution == "normal") jitter = normal_distribution<double>(0.0, options.jitterMs)(rng);
+        else if (options.distribution == "exp") jitter = exponential_distribution<double>(1.0 / options.jitterMs)(rng);
+        else jitter = uniform_real_distribution<double>(-options.jitterMs, options.jitterMs)(rng);
+    }
+    fault.firstTokenDelayMs = max(0.0, options.latencyMs + jitter);
+    return fault;
+}
+
+static void sleepMs(double ms) {
+    if (ms > 0) this_thread::sleep_for(chrono::microseconds(static_cast<long long>(ms * 1000)));
+}
+
+static double tokenIntervalMs() {
+    return options.tokensPerSec > 0 ? 1000.0 / options.tokensPerSec : 0;
+}
+
+// ==========================================
+// HTTP
+// ==========================================
+
+struct HttpRequest {
+    string method;
+    string path;
+    string body;
+    bool keepAlive = true;
+};
+
+static bool sendAll(int fd, string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+static string lowerCopy(string s) {
+    for (char& c : s) c = tolower(static_cast<unsigned char>(c));
+    return s;
+}
+
+// buffer 里可能已经有上一个请求读多了的数据 (keep-alive)
+static bool readRequest(int fd, string& buffer, HttpRequest& req) {
+    char chunk[8192];
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == string::npos) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, n);
+    }
+
+    istringstream head(buffer.substr(0, headerEnd));
+    string requestLine;
+    getline(head, requestLine);
+    istringstream rl(requestLine);
+    string version;
+    rl >> req.method >> req.path >> version;
+    req.keepAlive = version != "HTTP/1.0";
+
+    size_t contentLength = 0;
+    string header;
+    while (getline(head, header)) {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+        size_t colon = header.find(':');
+        if (colon == string::npos) continue;
+        string name = lowerCopy(header.substr(0, colon));
+        string value = header.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        if (name == "content-length") contentLength = stoul(value);
+        else if (name == "connection") req.keepAlive = lowerCopy(value) != "close";
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    while (buffer.size() < bodyStart + contentLength) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, n);
+    }
+    req.body = buffer.substr(bodyStart, contentLength);
+    buffer.erase(0, bodyStart + contentLength);
+    return true;
+}
+
+static bool sendResponse(int fd, int status, const string& contentType, const string& body, bool keepAlive) {
+    const char* reason = status == 200 ? "OK" : status == 404 ? "Not Found" : status == 429 ? "Too Many Requests" : "Internal Server Error";
+    string head = "HTTP/1.1 " + to_string(status) + " " + reason + "\r\n"
+                  "Content-Type: " + contentType + "\r\n"
+                  "Content-Length: " + to_string(body.size()) + "\r\n"
+                  "Connection: " + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+    return sendAll(fd, head + body);
+}
+
+static bool sendChunk(int fd, const string& data) {
+    ostringstream chunk;
+    chunk << hex << data.size() << "\r\n" << data << "\r\n";
+    return sendAll(fd, chunk.str());
+}
+
+static bool extractBool(const string& json, const string& key) {
+    size_t pos = json.find("\"" + key + "\"");
+    if (pos == string::npos) return false;
+    pos = json.find(':', pos);
+    if (pos == string::npos) return false;
+    pos = json.find_first_not_of(" \t\r\n", pos + 1);
+    return pos != string::npos && json.compare(pos, 4, "true") == 0;
+}
+
+static string isoNow() {
+    time_t now = time(nullptr);
+    struct tm tmNow;
+    gmtime_r(&now, &tmNow);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tmNow);
+    return buf;
+}
+
+// 最后一条消息的 content 当作 prompt
+static string lastMessageContent(const string& body) {
+    size_t pos = body.rfind("\"content\"");
+    if (pos == string::npos) return "";
+    string content;
+    JsonUtil::extractString(string_view(body).substr(pos), "content", content);
+    return content;
+}
+
+static bool handleGenerate(int fd, const HttpRequest& req, const Fault& fault) {
+    stats.generate++;
+    string model, prompt;
+    JsonUtil::extractString(req.body, "model", model);
+    JsonUtil::extractString(req.body, "prompt", prompt);
+    bool stream = extractBool(req.body, "stream") || req.body.find("\"stream\"") == string::npos; // Ollama 默认流式
+
+    if (fault.kind == Fault::Error) {
+        stats.errors++;
+        return sendResponse(fd, 500, "application/json", "{\"error\":\"mock injected error\"}", req.keepAlive);
+    }
+    if (fault.kind == Fault::Throttle) {
+        stats.throttled++;
+        return sendResponse(fd, 429, "application/json", "{\"error\":\"mock rate limited\"}", req.keepAlive);
+    }
+
+    auto start = chrono::steady_clock::now();
+    sleepMs(fault.firstTokenDelayMs);
+    string answer = respond(prompt);
+    vector<string> tokens = tokenize(answer);
+    stats.tokens += tokens.size();
+    size_t promptTokens = prompt.size() / 4 + 1;
+
+    auto finalFields = [&] {
+        long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        return ",\"done\":true,\"done_reason\":\"stop\",\"total_duration\":" + to_string(ns) +
+               ",\"prompt_eval_count\":" + to_string(promptTokens) +
+               ",\"eval_count\":" + to_string(tokens.size());
+    };
+    string prefix = "{\"model\":\"" + JsonUtil::escape(model) + "\",\"created_at\":\"" + isoNow() + "\"";
+
+    if (!stream) {
+        sleepMs(tokenIntervalMs() * tokens.size());
+        string body = prefix + ",\"response\":\"" + JsonUtil::escape(answer) + "\"" + finalFields() + "}";
+        return sendResponse(fd, 200, "application/json", body, req.keepAlive);
+    }
+
+    stats.streamed++;
+    string head = string("HTTP/1.1 200 OK\r\nContent-Type: application/x-ndjson\r\nTransfer-Encoding: chunked\r\n") +
+                  "Connection: " + (req.keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+    if (!sendAll(fd, head)) return false;
+    for (const auto& token : tokens) {
+        sleepMs(tokenIntervalMs());
+        if (!sendChunk(fd, prefix + ",\"response\":\"" + JsonUtil::escape(token) + "\",\"done\":false}\n")) return false;
+    }
+    if (!sendChunk(fd, prefix + ",\"response\":\"\"" + finalFields() + "}\n")) return false;
+    return sendAll(fd, "0\r\n\r\n");
+}
+
+static bool handleChat(int fd, const HttpRequest& req, const Fault& fault) {
+    stats.chat++;
+    string model;
+    JsonUtil::extractString(req.body, "model", model);
+    string prompt = lastMessageContent(req.body);
+    bool stream = extractBool(req.body, "stream");
+
+    if (fault.kind == Fault::Error) {
+        stats.errors++;
+        return sendResponse(fd, 500, "application/json",
+                            "{\"error\":{\"message\":\"mock injected error\",\"type\":\"server_error\"}}", req.keepAlive);
+    }
+    if (fault.kind == Fault::Throttle) {
+        stats.throttled++;
+        return sendResponse(fd, 429, "application/json",
+                            "{\"error\":{\"message\":\"mock rate limited\",\"type\":\"rate_limit_exceeded\"}}", req.keepAlive);
+    }
+
+    sleepMs(fault.firstTokenDelayMs);
+    string answer = respond(prompt);
+    vector<string> tokens = tokenize(answer);
+    stats.tokens += tokens.size();
+    size_t promptTokens = prompt.size() / 4 + 1;
+
+    string id = "mock-" + to_string(requestSeq.load());
+    string prefix = "{\"id\":\"" + id + "\",\"created\":" + to_string(time(nullptr)) +
+                    ",\"model\":\"" + JsonUtil::escape(model) + "\"";
+    string usage = "\"usage\":{\"prompt_tokens\":" + to_string(promptTokens) +
+                   ",\"completion_tokens\":" + to_string(tokens.size()) +
+                   ",\"total_tokens\":" + to_string(promptTokens + tokens.size()) + "}";
+
+    if (!stream) {
+        sleepMs(tokenIntervalMs() * tokens.size());
+        string body = prefix + ",\"object\":\"chat.completion\",\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\",\"content\":\"" +
+                      JsonUtil::escape(answer) + "\"},\"finish_reason\":\"stop\"}]," + usage + "}";
+        return sendResponse(fd, 200, "application/json", body, req.keepAlive);
+    }
+
+    stats.streamed++;
+    string head = string("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nTransfer-Encoding: chunked\r\n") +
+                  "Connection: " + (req.keepAlive ? "keep-alive" : "close") + "\r\n\r\n";
+    if (!sendAll(fd, head)) return false;
+    string chunkPrefix = prefix + ",\"object\":\"chat.completion.chunk\",\"choices\":[{\"index\":0,\"delta\":{";
+    if (!sendChunk(fd, "data: " + chunkPrefix + "\"role\":\"assistant\",\"content\":\"\"},\"finish_reason\":null}]}\n\n")) return false;
+    for (const auto& token : tokens) {
+        sleepMs(tokenIntervalMs());
+        if (!sendChunk(fd, "data: " + chunkPrefix + "\"content\":\"" + JsonUtil::escape(token) + "\"},\"finish_reason\":null}]}\n\n")) return false;
+    }
+    if (!sendChunk(fd, "data: " + chunkPrefix + "},\"finish_reason\":\"stop\"}]," + usage + "}\n\n")) return false;
+    if (!sendChunk(fd, "data: [DONE]\n\n")) return false;
+    return sendAll(fd, "0\r\n\r\n");
+}
+
+static string statsJson() {
+    return "{\"requests\":" + to_string(stats.requests.load()) +
+           ",\"generate\":" + to_string(stats.generate.load()) +
+           ",\"chat\":" + to_string(stats.chat.load()) +
+           ",\"streamed\":" + to_string(stats.streamed.load()) +
+           ",\"errors\":" + to_string(stats.errors.load()) +
+           ",\"throttled\":" + to_string(stats.throttled.load()) +
+           ",\"dropped\":" + to_string(stats.dropped.load()) +
+           ",\"tokens\":" + to_string(stats.tokens.load()) + "}";
+}
+
+static void serveConnection(int fd) {
+    string buffer;
+    HttpRequest req;
+    while (readRequest(fd, buffer, req)) {
+        if (options.verbose) cerr << "[Mock] " << req.method << " " << req.path << " (" << req.body.size() << " bytes)" << endl;
+
+        bool ok;
+        if (req.method == "GET" && req.path == "/stats") {
+            ok = sendResponse(fd, 200, "application/json", statsJson(), req.keepAlive);
+        } else if (req.method == "GET" && req.path == "/api/tags") {
+            ok = sendResponse(fd, 200, "application/json", "{\"models\":[{\"name\":\"mock\",\"model\":\"mock\"}]}", req.keepAlive);
+        } else if (req.method == "POST" && (req.path == "/api/generate" || req.path == "/chat/completions" ||
+                                            req.path == "/v1/chat/completions")) {
+            stats.requests++;
+            Fault fault = planRequest();
+            if (fault.kind == Fault::Drop) {
+                stats.dropped++;
+                break;
+            }
+            ok = req.path == "/api/generate" ? handleGenerate(fd, req, fault) : handleChat(fd, req, fault);
+        } else {
+            ok = sendResponse(fd, 404, "application/json", "{\"error\":\"not found\"}", req.keepAlive);
+        }
+        if (!ok || !req.keepAlive) break;
+    }
+    ::close(fd);
+}
+
+// ==========================================
+// main
+// ==========================================
+
+// 规则文件：每行 "关键词 => 回复"，# 开头是注释；回复里的 \n 表示换行
+static bool loadRules(const string& path) {
+    ifstream file(path);
+    if (!file.is_open()) return false;
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        size_t arrow = line.find(" => ");
+        if (arrow == string::npos) continue;
+        Rule rule;
+        rule.pattern = line.substr(0, arrow);
+        rule.response = line.substr(arrow + 4);
+        size_t pos = 0;
+        while ((pos = rule.response.find("\\n", pos)) != string::npos) {
+            rule.response.replace(pos, 2, "\n");
+            pos++;
+        }
+        rules.push_back(rule);
+    }
+    return true;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options]\n"
+         << "  --host ADDR            监听地址 (默认 127.0.0.1)\n"
+         << "  --port N               监听端口 (默认 11500)\n"
+         << "  --latency MS           首 token 前的基础延迟\n"
+         << "  --jitter MS            延迟抖动幅度\n"
+         << "  --dist uniform|normal|exp  抖动分布 (exp 为长尾)\n"
+         << "  --tokens-per-sec R     吐 token 的速率，0 表示不限\n"
+         << "  --error-rate P         以概率 P 返回 500\n"
+         << "  --throttle-rate P      以概率 P 返回 429\n"
+         << "  --drop-rate P          以概率 P 直接断开连接\n"
+         << "  --seed N               随机种子，同样的请求顺序得到同样的延迟和故障\n"
+         << "  --rules FILE           规则文件，每行 '关键词 => 回复'，先于内置规则匹配\n"
+         << "  --verbose              打印每个请求" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto next = [&]() -> string { return i + 1 < argc ? argv[++i] : ""; };
+        try {
+            if (arg == "--host") options.host = next();
+            else if (arg == "--port") options.port = stoi(next());
+            else if (arg == "--latency") options.latencyMs = stod(next());
+            else if (arg == "--jitter") options.jitterMs = stod(next());
+            else if (arg == "--dist") options.distribution = next();
+            else if (arg == "--tokens-per-sec") options.tokensPerSec = stod(next());
+            else if (arg == "--error-rate") options.errorRate = stod(next());
+            else if (arg == "--throttle-rate") options.throttleRate = stod(next());
+            else if (arg == "--drop-rate") options.dropRate = stod(next());
+            else if (arg == "--seed") options.seed = stoull(next());
+            else if (arg == "--rules") options.rulesFile = next();
+            else if (arg == "--verbose") options.verbose = true;
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (...) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.distribution != "uniform" && options.distribution != "normal" && options.distribution != "exp") {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!options.rulesFile.empty() && !loadRules(options.rulesFile)) {
+        cerr << "[Error] 无法读取规则文件: " << options.rulesFile << endl;
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1) {
+        cerr << "[Error] 无效的地址: " << options.host << endl;
+        return 1;
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd, 256) < 0) {
+        cerr << "[Error] 无法监听 " << options.host << ":" << options.port << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    cerr << "[Mock] 监听 http://" << options.host << ":" << options.port
+         << " (latency " << options.latencyMs << "ms ± " << options.jitterMs << "ms " << options.distribution
+         << ", " << options.tokensPerSec << " tok/s, error " << options.errorRate
+         << ", throttle " << options.throttleRate << ", drop " << options.dropRate
+         << ", rules " << rules.size() << ")" << endl;
+
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            cerr << "[Error] accept 失败: " << strerror(errno) << endl;
+            break;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        // 每个连接一个线程：mock 的瓶颈应该在模拟的延迟上，而不是这里
+        thread(serveConnection, fd).detach();
+    }
+    ::close(listenFd);
+    return 0;
+}
@@ -13,13 +13,24 @@ let backendProcess = null;
 async function startBackend() {
   console.log('准备启动后端...');
   
-  const cmd = Command.sidecar('synapse');
+  // JSON-lines 协议：一行一个事件 {session, seq, type, text, items}
+  const cmd = Command.sidecar('synapse', ['--protocol', 'json']);
 
   cmd.stdout.on('data', (line) => {
     const cleanLine = line.trim();
     if (!cleanLine) return;
     console.log('Backend:', cleanLine);
 
+    let event = null;
+    if (cleanLine.startsWith('{')) {
+        try { event = JSON.parse(cleanLine); } catch (e) { event = null; }
+    }
+    if (event && event.type) {
+        handleEvent(event);
+        return;
+    }
+
+    // 兼容旧版后端的文本前缀
     if (cleanLine.startsWith('[THINK]')) {
         appendThinking(cleanLine.substring(8));
         updateStatus("思考中...", true);
@@ -59,6 +70,41 @@ async function startBackend() {
   }
 }
 
+function handleEvent(event) {
+    switch (event.type) {
+        case 'thinking':
+            appendThinking(event.text);
+            updateStatus("思考中...", true);
+            break;
+        case 'progress':
+            appendThinking(event.text);
+            updateStatus("处理中...", true);
+            break;
+        case 'result':
+            appendAIMessage(event.text);
+            updateStatus("就绪", false);
+            break;
+        case 'error':
+            appendError(event.text);
+            updateStatus("就绪", false);
+            break;
+        case 'candidates':
+            appendCandidates(event.text, event.items || []);
+            updateStatus("等待选择...", false);
+            break;
+        case 'done':
+            updateStatus("就绪", false);
+            break;
+        case 'prompt':
+            appendAIMessage(event.text);
+            updateStatus("等待输入...", false);
+            break;
+        default:
+            appendAIMessage(event.text);
+            updateStatus("就绪", false);
+    }
+}
+
 async function sendMessage() {
   // ✅ 修改 2: 允许发送空回车
   // 获取原始输入，不立即 trim，因为我们需要判断用户是不是只按了回车
@@ -104,6 +150,31 @@ function appendAIMessage(text) {
   chatHistory.scrollTop = chatHistory.scrollHeight;
 }
 
+// 候选列表：点一项直接把序号发给后端
+function appendCandidates(title, items) {
+  const d = document.createElement('div');
+  d.className = 'message ai-message';
+  if (title) {
+      const t = document.createElement('div');
+      t.textContent = title;
+      d.appendChild(t);
+  }
+  const list = document.createElement('ol');
+  list.className = 'candidate-list';
+  items.forEach((item, i) => {
+      const li = document.createElement('li');
+      li.textContent = item;
+      li.addEventListener('click', () => {
+          userInput.value = String(i + 1);
+          sendMessage();
+      });
+      list.appendChild(li);
+  });
+  d.appendChild(list);
+  chatHistory.appendChild(d);
+  chatHistory.scrollTop = chatHistory.scrollHeight;
+}
+
 function appendThinking(text) {
     const d = document.createElement('div');
     d.className = 'thinking-process';